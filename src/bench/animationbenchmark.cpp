@@ -0,0 +1,251 @@
+#include "../render/animation.h"
+#include "../render/posecache.h"
+#include "../util/cliploader.h"
+#include "../util/skinnedmodelparser.h"
+#include "../util/jobsystem.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <thread>
+
+/*
+headless benchmark of the skinned animation, needs no device or window.
+loads a skinned model and all clips on the cpu and evaluates poses of 1 to many instances,
+reports the time per bone of clip sampling, of sampling with hierarchy and palette and of the cached parallel path,
+plus the heap allocations per frame of every path.
+
+animationbenchmark [model.s3d] [clip directory] [max instances]
+*/
+
+namespace
+{
+    /*heap allocations of all threads*/
+    std::atomic<long long> allocations{ 0 };
+}
+
+/*counts every allocation of the program, the array and nothrow versions end up here as well*/
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    /*results of one amount of instances*/
+    struct Result
+    {
+        unsigned int instances = 0;
+        unsigned int frames = 0;
+
+        double sampleNs = 0.0;
+        double evaluateNs = 0.0;
+        double cachedNs = 0.0;
+
+        long long sampleAllocations = 0;
+        long long evaluateAllocations = 0;
+        long long cachedAllocations = 0;
+
+        unsigned int uniquePoses = 0;
+    };
+
+    /*simulated frame time*/
+    constexpr float frameTime = 1.0f / 60.0f;
+
+    /*evaluated instances per measurement, fewer instances run more frames*/
+    constexpr unsigned int evaluationsPerMeasurement = 20000;
+    constexpr unsigned int maxFrames = 240;
+
+    /*@returns result for an amount of instances*/
+    Result measure(const SkinnedRig& rig, const std::vector<std::unique_ptr<AnimationClip>>& clips, unsigned int instanceCount, JobSystem* jobs)
+    {
+        Result result;
+        result.instances = instanceCount;
+        result.frames = (std::max)((std::min)(evaluationsPerMeasurement / instanceCount, maxFrames), 1u);
+
+        /*instances cycle through the clips and start at different times*/
+        std::vector<AnimationInstance> instances(instanceCount);
+        std::vector<AnimationInstance*> pointers(instanceCount);
+
+        for (unsigned int i = 0; i < instanceCount; i++)
+        {
+            AnimationInstance& instance = instances[i];
+
+            instance.rig = &rig;
+            instance.currentClip = clips[i % clips.size()].get();
+            instance.animationTimer = std::fmod(i * 0.37f, instance.currentClip->getEndTime());
+            instance.keyCursors.assign(instance.currentClip->boneAnimations.size(), 0);
+            instance.finalTransforms.resize(instance.currentClip->boneAnimations.size());
+            instance.skinningScratch.resize(rig.boneCount);
+
+            pointers[i] = &instance;
+        }
+
+        float totalTime = 0.0f;
+
+        auto advance = [&]()
+        {
+            totalTime += frameTime;
+
+            for (auto& instance : instances)
+            {
+                instance.animationTimer = std::fmod(instance.animationTimer + frameTime, instance.currentClip->getEndTime());
+            }
+        };
+
+        /*
+        @param function evaluating one frame of all instances
+        @param receives the allocations of all frames
+        @returns nanoseconds per bone
+        */
+        auto time = [&](const auto& frame, long long& frameAllocations)
+        {
+            /*the first frame may size buffers*/
+            frame();
+            advance();
+
+            const long long allocationsBefore = allocations.load();
+            const auto start = std::chrono::high_resolution_clock::now();
+
+            for (unsigned int f = 0; f < result.frames; f++)
+            {
+                frame();
+                advance();
+            }
+
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            frameAllocations = allocations.load() - allocationsBefore;
+
+            const double nanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            return nanoseconds / ((double)result.frames * instanceCount * rig.boneCount);
+        };
+
+        /*clip sampling only*/
+        result.sampleNs = time([&]()
+        {
+            for (auto& instance : instances)
+            {
+                instance.currentClip->sampler.sample(instance.animationTimer, instance.skinningScratch.sampledPose, instance.keyCursors.data());
+            }
+        }, result.sampleAllocations);
+
+        /*sampling, hierarchy and palette of every instance on this thread*/
+        result.evaluateNs = time([&]()
+        {
+            for (auto& instance : instances)
+            {
+                rig.calculateFinalTransforms(instance.skinningScratch, instance.currentClip, instance.animationTimer, &instance.keyCursors, UINT_MAX,
+                                             nullptr, { instance.finalTransforms.data(), (unsigned int)instance.finalTransforms.size() });
+            }
+        }, result.evaluateAllocations);
+
+        /*the path of the game, shared poses on the job system*/
+        PoseCache poseCache;
+        poseCache.setup(0.005f, 0);
+
+        const std::vector<BonePalette> uploads;
+
+        result.cachedNs = time([&]()
+        {
+            poseCache.beginFrame(totalTime);
+            poseCache.evaluate(pointers, uploads, jobs);
+        }, result.cachedAllocations);
+
+        result.uniquePoses = poseCache.getUniquePoses();
+
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::filesystem::path modelFile = argc >= 2 ? argv[1] : "data/skinned/geo.s3d";
+    const std::filesystem::path clipDirectory = argc >= 3 ? argv[2] : "data/anim";
+    const unsigned int maxInstances = argc >= 4 ? (unsigned int)std::stoul(argv[3]) : 10000;
+
+    /*only the cpu side of the model, no vertex or index buffers are created*/
+    SkinnedRig rig;
+    std::vector<SkinnedModelParser::MeshGeometry> geometry;
+    DirectX::BoundingBox bounds;
+
+    if (!std::filesystem::is_regular_file(modelFile) || !SkinnedModelParser().parseS3D(modelFile, rig, geometry, bounds))
+    {
+        std::cerr << "Failed to load skinned model " << modelFile.u8string() << "!" << std::endl;
+        return 1;
+    }
+
+    const std::string modelName = modelFile.stem().string();
+
+    ClipLoader loader{};
+    std::vector<std::unique_ptr<AnimationClip>> clips;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(clipDirectory))
+    {
+        if (entry.is_directory()) continue;
+
+        auto clip = loader.loadCLP(entry);
+
+        if (!clip)
+        {
+            std::cerr << "Failed to load animation clip " << entry.path().u8string() << "!" << std::endl;
+            continue;
+        }
+
+        if (clip->boneAnimations.size() != rig.boneCount || !clip->sampler.isValid())
+        {
+            std::cerr << "Animation clip " << clip->name << " does not match the skeleton of " << modelName << ", it is skipped." << std::endl;
+            continue;
+        }
+
+        clips.push_back(std::move(clip));
+    }
+
+    if (clips.empty())
+    {
+        std::cerr << "No animation clip for " << modelName << " found!" << std::endl;
+        return 1;
+    }
+
+    /*same worker count as the game*/
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    JobSystem jobs(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+
+    std::cout << "Benchmarking " << modelName << " with " << rig.boneCount << " bones and " << clips.size() << " clips.\n";
+    std::cout << "instances | frames | sample ns/bone | evaluate ns/bone | cached parallel ns/bone | unique poses | allocations per frame (sample/evaluate/cached)\n";
+
+    for (unsigned int instances = 1; instances <= maxInstances; instances *= 10)
+    {
+        const Result r = measure(rig, clips, instances, &jobs);
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << r.instances << " | " << r.frames << " | "
+                  << r.sampleNs << " | " << r.evaluateNs << " | " << r.cachedNs << " | "
+                  << r.uniquePoses << " | "
+                  << std::defaultfloat << std::setprecision(3)
+                  << (double)r.sampleAllocations / r.frames << " / "
+                  << (double)r.evaluateAllocations / r.frames << " / "
+                  << (double)r.cachedAllocations / r.frames << "\n";
+
+        /*10 times more instances would overflow*/
+        if (instances > UINT_MAX / 10) break;
+    }
+
+    return 0;
+}
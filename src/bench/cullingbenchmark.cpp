@@ -0,0 +1,530 @@
+#include "../render/lightclusters.h"
+#include "../util/frustumculling.h"
+#include "../util/quadtree.h"
+#include "../util/loosequadtree.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+using namespace DirectX;
+
+/*
+headless benchmark of the frustum culling, needs no device, window or data files.
+scatters boxes over a level and culls them against the camera frustum and an orthographic shadow frustum,
+reports the time per box of the per object tests, of the BoxCuller and of the searches of the static and the loose quad tree
+followed by a test of the objects they return, and checks that every path keeps every visible box.
+the pointer based quad tree the static tree replaced is kept below to compare the old and the new search.
+the point and spot lights of the level are binned into the light clusters, the nearest of them are assigned to the light slots
+by the nearest light selection and by sorting all visible lights.
+
+cullingbenchmark [box count] [repetitions]
+*/
+
+namespace
+{
+    /*size of the level the boxes are scattered over*/
+    constexpr float levelSize = 2000.0f;
+
+    /*results of one frustum*/
+    struct Result
+    {
+        std::string name;
+
+        /*the shadow frustums of the game only exist as planes*/
+        bool hasBoundingFrustum = false;
+
+        double boundingFrustumNs = 0.0;
+        double classifyNs = 0.0;
+        double boxCullerNs = 0.0;
+        double oldQuadTreeNs = 0.0;
+        double quadTreeNs = 0.0;
+        double looseTreeNs = 0.0;
+
+        unsigned int boundingFrustumVisible = 0;
+        unsigned int classifyVisible = 0;
+        unsigned int boxCullerVisible = 0;
+        unsigned int oldQuadTreeVisible = 0;
+        unsigned int quadTreeVisible = 0;
+        unsigned int looseTreeVisible = 0;
+
+        /*boxes the per object test keeps but the BoxCuller drops, has to be 0*/
+        unsigned int missed = 0;
+    };
+
+    /*the trees only store the pointers, every object of the benchmark points to its box*/
+    GameObject* toObject(const BoundingBox& box)
+    {
+        return reinterpret_cast<GameObject*>(const_cast<BoundingBox*>(&box));
+    }
+
+    const BoundingBox& toBox(const GameObject* object)
+    {
+        return *reinterpret_cast<const BoundingBox*>(object);
+    }
+
+    /*
+    the static quad tree before it was packed into arrays, one heap node per quad and recursive searches through std::function.
+    stores boxes instead of game objects, otherwise unchanged
+    */
+    class OldQuadTree
+    {
+    public:
+
+        struct QuadNode
+        {
+            BoundingBox boundingBox;
+            std::vector<const BoundingBox*> containedObjects;
+            std::vector<std::unique_ptr<QuadNode>> children;
+        };
+
+        void build(XMFLOAT3 center, float x, float z, int depth)
+        {
+            if (depth < 1) depth = 1;
+
+            root = populateNode(center, x, z, depth);
+        }
+
+        bool insert(const BoundingBox* box)
+        {
+            bool inserted = false;
+
+            const std::function<void(QuadNode*)> recursiveInsert = [&](QuadNode* node)
+            {
+                if (node->boundingBox.Intersects(*box))
+                {
+                    if (node->children.empty())
+                    {
+                        node->containedObjects.push_back(box);
+                        inserted = true;
+                    }
+                    else
+                    {
+                        for (auto& c : node->children)
+                        {
+                            recursiveInsert(c.get());
+                        }
+                    }
+                }
+            };
+
+            recursiveInsert(root.get());
+
+            return inserted;
+        }
+
+        void searchCollision(const BoundingFrustum& frustum, std::vector<QuadNode*>& nodes) const
+        {
+            const std::function<void(QuadNode*)> recursiveSearch = [&](QuadNode* node)
+            {
+                if (node->children.empty())
+                {
+                    if (frustum.Contains(node->boundingBox) != DISJOINT && !node->containedObjects.empty())
+                    {
+                        nodes.push_back(node);
+                    }
+                }
+                else
+                {
+                    if (frustum.Contains(node->boundingBox) != DISJOINT)
+                    {
+                        for (auto& i : node->children)
+                        {
+                            recursiveSearch(i.get());
+                        }
+                    }
+                }
+            };
+
+            recursiveSearch(root.get());
+        }
+
+    private:
+
+        const float fixedHeight = 64.0f;
+
+        std::unique_ptr<QuadNode> populateNode(XMFLOAT3 center, float x, float z, int depth)
+        {
+            auto node = std::make_unique<QuadNode>();
+            node->boundingBox = BoundingBox(center, { x / 2.0f, fixedHeight, z / 2.0f });
+
+            if (depth > 0)
+            {
+                node->children.push_back(populateNode({ center.x - x / 4.0f, 0.0f, center.z - z / 4.0f }, x / 2.0f, z / 2.0f, depth - 1));
+                node->children.push_back(populateNode({ center.x + x / 4.0f, 0.0f, center.z - z / 4.0f }, x / 2.0f, z / 2.0f, depth - 1));
+                node->children.push_back(populateNode({ center.x - x / 4.0f, 0.0f, center.z + z / 4.0f }, x / 2.0f, z / 2.0f, depth - 1));
+                node->children.push_back(populateNode({ center.x + x / 4.0f, 0.0f, center.z + z / 4.0f }, x / 2.0f, z / 2.0f, depth - 1));
+            }
+
+            return node;
+        }
+
+        std::unique_ptr<QuadNode> root = nullptr;
+    };
+
+    /*static and moving objects of the level*/
+    struct Trees
+    {
+        OldQuadTree oldQuadTree;
+        QuadTree quadTree;
+        LooseQuadTree looseTree;
+    };
+
+    /*
+    @param function culling all boxes once
+    @param repetitions of the function
+    @param box count
+    @returns nanoseconds per box
+    */
+    template<typename Function>
+    double time(const Function& cull, unsigned int repetitions, size_t boxes)
+    {
+        /*the first run warms the caches*/
+        cull();
+
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        for (unsigned int r = 0; r < repetitions; r++)
+        {
+            cull();
+        }
+
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const double nanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        return nanoseconds / ((double)repetitions * boxes);
+    }
+
+    /*
+    @param name of the frustum
+    @param frustum for the per object test of the game objects, a null pointer skips it
+    @param planes of the same frustum
+    @param boxes to cull
+    @param culler holding the same boxes
+    @param trees holding the same boxes
+    @param repetitions of every measurement
+    @returns result of the frustum
+    */
+    Result measure(const std::string& name, const BoundingFrustum* frustum, const FrustumPlanes& planes,
+                   const std::vector<BoundingBox>& boxes, BoxCuller& culler, const Trees& trees, unsigned int repetitions)
+    {
+        Result result;
+        result.name = name;
+
+        std::vector<unsigned char> visible(boxes.size());
+
+        if (frustum)
+        {
+            result.hasBoundingFrustum = true;
+            result.boundingFrustumNs = time([&]()
+            {
+                for (size_t i = 0; i < boxes.size(); i++)
+                {
+                    visible[i] = frustum->Contains(boxes[i]) != DISJOINT;
+                }
+            }, repetitions, boxes.size());
+
+            for (const auto v : visible)
+            {
+                result.boundingFrustumVisible += v;
+            }
+        }
+
+        result.classifyNs = time([&]()
+        {
+            for (size_t i = 0; i < boxes.size(); i++)
+            {
+                visible[i] = planes.classify(boxes[i]) != DISJOINT;
+            }
+        }, repetitions, boxes.size());
+
+        result.boxCullerNs = time([&]()
+        {
+            culler.cull(planes);
+        }, repetitions, boxes.size());
+
+        /*like the static shadow casters, objects in several leaves are found more than once*/
+        std::vector<unsigned int> leaves;
+        std::vector<GameObject*> objects;
+
+        result.quadTreeNs = time([&]()
+        {
+            leaves.clear();
+            objects.clear();
+
+            trees.quadTree.searchCollision(planes, leaves);
+
+            for (const auto leaf : leaves)
+            {
+                for (const auto& object : trees.quadTree.getLeafObjects(leaf))
+                {
+                    if (planes.classify(toBox(object)) != DISJOINT)
+                    {
+                        objects.push_back(object);
+                    }
+                }
+            }
+
+            std::sort(objects.begin(), objects.end());
+            objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+        }, repetitions, boxes.size());
+
+        result.quadTreeVisible = (unsigned int)objects.size();
+
+        /*like the camera culling of the level, the old quad tree and the loose tree only take a BoundingFrustum*/
+        if (frustum)
+        {
+            std::vector<OldQuadTree::QuadNode*> nodes;
+            std::vector<const BoundingBox*> oldObjects;
+
+            result.oldQuadTreeNs = time([&]()
+            {
+                nodes.clear();
+                oldObjects.clear();
+
+                trees.oldQuadTree.searchCollision(*frustum, nodes);
+
+                for (const auto node : nodes)
+                {
+                    for (const auto box : node->containedObjects)
+                    {
+                        if (planes.classify(*box) != DISJOINT)
+                        {
+                            oldObjects.push_back(box);
+                        }
+                    }
+                }
+
+                std::sort(oldObjects.begin(), oldObjects.end());
+                oldObjects.erase(std::unique(oldObjects.begin(), oldObjects.end()), oldObjects.end());
+            }, repetitions, boxes.size());
+
+            result.oldQuadTreeVisible = (unsigned int)oldObjects.size();
+
+            std::vector<GameObject*> candidates;
+
+            result.looseTreeNs = time([&]()
+            {
+                candidates.clear();
+                objects.clear();
+
+                trees.looseTree.searchCollision(*frustum, candidates);
+
+                for (const auto& object : candidates)
+                {
+                    if (planes.classify(toBox(object)) != DISJOINT)
+                    {
+                        objects.push_back(object);
+                    }
+                }
+            }, repetitions, boxes.size());
+
+            result.looseTreeVisible = (unsigned int)objects.size();
+        }
+
+        for (unsigned int i = 0; i < culler.size(); i++)
+        {
+            result.classifyVisible += visible[i];
+            result.boxCullerVisible += culler.isVisible(i);
+
+            if (visible[i] && !culler.isVisible(i))
+            {
+                result.missed++;
+            }
+        }
+
+        return result;
+    }
+
+    /*results of the light clusters and the slot assignment*/
+    struct LightResult
+    {
+        double assignNs = 0.0;
+        double selectNs = 0.0;
+        double sortNs = 0.0;
+
+        unsigned int visible = 0;
+        unsigned int indices = 0;
+
+        /*the nearest light selection has to pick the same lights as the full sort*/
+        bool same = false;
+    };
+
+    /*
+    @param lights in world space
+    @param view matrix of the camera
+    @param position the distances are measured from
+    @param amount of slots
+    @param repetitions of every measurement
+    @returns result of the lights
+    */
+    LightResult measureLights(const std::vector<ClusterLight>& lights, FXMMATRIX view, FXMVECTOR eye, unsigned int slots, unsigned int repetitions)
+    {
+        LightResult result;
+
+        LightClusters clusters;
+        clusters.build(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 1000.0f);
+
+        result.assignNs = time([&]()
+        {
+            clusters.assign(lights.data(), (unsigned int)lights.size(), view);
+        }, repetitions, lights.size());
+
+        std::vector<unsigned int> selected;
+
+        result.selectNs = time([&]()
+        {
+            clusters.selectNearest(lights.data(), eye, 0, (unsigned int)lights.size(), slots, selected);
+        }, repetitions, lights.size());
+
+        /*every visible light is sorted by its distance, equal distances keep the order of the lights*/
+        std::vector<std::pair<float, unsigned int>> sorted;
+
+        result.sortNs = time([&]()
+        {
+            sorted.clear();
+
+            for (const auto i : clusters.getVisibleLights())
+            {
+                sorted.push_back({ XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&lights[i].position), eye))), i });
+            }
+
+            std::sort(sorted.begin(), sorted.end());
+        }, repetitions, lights.size());
+
+        result.visible = (unsigned int)clusters.getVisibleLights().size();
+        result.indices = clusters.getTotalLightIndices();
+        result.same = selected.size() == (std::min)(sorted.size(), (size_t)slots);
+
+        for (size_t i = 0; result.same && i < selected.size(); i++)
+        {
+            result.same = selected[i] == sorted[i].second;
+        }
+
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int boxCount = argc >= 2 ? (unsigned int)std::stoul(argv[1]) : 20000;
+    const unsigned int repetitions = argc >= 3 ? (unsigned int)std::stoul(argv[2]) : 200;
+
+    /*one light per 10 objects, the pass constants have 4 point light slots*/
+    const unsigned int lightCount = (std::max)(boxCount / 10, 1u);
+    constexpr unsigned int lightSlots = 4;
+
+    /*boxes of different sizes on and above the ground, like the objects of a level*/
+    std::mt19937 random(4953);
+    std::uniform_real_distribution<float> position(-levelSize * 0.5f, levelSize * 0.5f);
+    std::uniform_real_distribution<float> height(0.0f, 40.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 8.0f);
+
+    std::vector<BoundingBox> boxes(boxCount);
+    BoxCuller culler;
+
+    /*same depths as the trees of the level*/
+    Trees trees;
+    trees.oldQuadTree.build({ 0.0f, 0.0f, 0.0f }, levelSize, levelSize, 4);
+    trees.quadTree.build({ 0.0f, 0.0f, 0.0f }, levelSize, levelSize, 4);
+    trees.looseTree.build({ 0.0f, 0.0f, 0.0f }, levelSize, levelSize, 5);
+
+    for (auto& box : boxes)
+    {
+        box = BoundingBox(XMFLOAT3(position(random), height(random), position(random)), XMFLOAT3(extent(random), extent(random), extent(random)));
+        culler.add(box);
+        trees.oldQuadTree.insert(&box);
+        trees.quadTree.insert(toObject(box), box);
+        trees.looseTree.insert(toObject(box), box);
+    }
+
+    trees.quadTree.pack();
+
+    /*every fourth light is a spot light looking down*/
+    std::uniform_real_distribution<float> fallOff(5.0f, 40.0f);
+    std::uniform_real_distribution<float> spotPower(4.0f, 64.0f);
+    std::vector<ClusterLight> lights(lightCount);
+
+    for (unsigned int i = 0; i < lightCount; i++)
+    {
+        lights[i].position = XMFLOAT3(position(random), height(random), position(random));
+        lights[i].range = fallOff(random);
+
+        if (i % 4 == 3)
+        {
+            lights[i].cosCone = ClusterLight::spotCone(spotPower(random));
+        }
+    }
+
+    /*camera above the level looking along its diagonal, the frustum is moved to world space like the one of the game*/
+    const XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 1000.0f);
+    const XMVECTOR eye = XMVectorSet(-600.0f, 20.0f, -600.0f, 1.0f);
+    const XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+    BoundingFrustum cameraFrustum(proj);
+    cameraFrustum.Transform(cameraFrustum, XMMatrixInverse(nullptr, view));
+
+    /*the light volume of the shadow map, the sun looks down at the center of the level*/
+    const XMMATRIX lightView = XMMatrixLookAtLH(XMVectorSet(300.0f, 500.0f, 200.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    const XMMATRIX lightProj = XMMatrixOrthographicLH(600.0f, 600.0f, 1.0f, 1200.0f);
+
+    const Result results[] =
+    {
+        measure("camera", &cameraFrustum, FrustumPlanes(cameraFrustum), boxes, culler, trees, repetitions),
+        measure("shadow", nullptr, FrustumPlanes(XMMatrixMultiply(lightView, lightProj)), boxes, culler, trees, repetitions)
+    };
+
+    std::cout << "Culling " << boxCount << " boxes " << repetitions << " times.\n";
+    std::cout << "frustum | BoundingFrustum ns/box | classify ns/box | BoxCuller ns/box | old quad tree ns/box | quad tree ns/box | loose tree ns/box | "
+                 "visible (BoundingFrustum/classify/BoxCuller/old quad tree/quad tree/loose tree) | missed\n";
+
+    bool missed = false;
+
+    for (const auto& r : results)
+    {
+        std::cout << std::fixed << std::setprecision(2) << r.name << " | ";
+
+        if (r.hasBoundingFrustum)
+        {
+            std::cout << r.boundingFrustumNs << " | " << r.classifyNs << " | " << r.boxCullerNs << " | " << r.oldQuadTreeNs << " | " << r.quadTreeNs << " | " << r.looseTreeNs << " | "
+                      << r.boundingFrustumVisible << " / " << r.classifyVisible << " / " << r.boxCullerVisible << " / " << r.oldQuadTreeVisible << " / "
+                      << r.quadTreeVisible << " / " << r.looseTreeVisible;
+        }
+        else
+        {
+            std::cout << "- | " << r.classifyNs << " | " << r.boxCullerNs << " | - | " << r.quadTreeNs << " | - | "
+                      << "- / " << r.classifyVisible << " / " << r.boxCullerVisible << " / - / " << r.quadTreeVisible << " / -";
+        }
+
+        std::cout << " | " << r.missed << "\n";
+
+        /*the trees return candidates that are tested exactly like classify*/
+        missed = missed || r.missed > 0 || r.quadTreeVisible != r.classifyVisible ||
+                 (r.hasBoundingFrustum && (r.oldQuadTreeVisible != r.classifyVisible || r.looseTreeVisible != r.classifyVisible));
+    }
+
+    const LightResult lightResult = measureLights(lights, view, eye, lightSlots, repetitions);
+
+    std::cout << "\nBinning " << lightCount << " lights into " << LightClusters::CLUSTER_COUNT << " clusters and assigning " << lightSlots << " slots.\n";
+    std::cout << "assign ns/light | nearest ns/light | sort ns/light | visible | cluster light indices | same lights\n";
+    std::cout << std::fixed << std::setprecision(2) << lightResult.assignNs << " | " << lightResult.selectNs << " | " << lightResult.sortNs << " | "
+              << lightResult.visible << " | " << lightResult.indices << " | " << (lightResult.same ? "yes" : "no") << "\n";
+
+    if (missed)
+    {
+        std::cerr << "A culling path dropped visible boxes!" << std::endl;
+        return 1;
+    }
+
+    if (!lightResult.same)
+    {
+        std::cerr << "The nearest light selection picked other lights than the sort!" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "../render/drawpacket.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+/*
+headless benchmark of the draw packets, needs no device, window or data files.
+builds the keys of a level of objects with one to three meshes like Level::buildDrawPackets,
+reports the time per packet of building the keys, of the radix sort and of a stable comparison sort,
+checks that both sorts give the same order and counts the draws and state changes of the submit loop,
+including the draws left if runs with the same pipeline state, mesh and material were merged into instanced draws.
+
+drawpacketbenchmark [object count] [repetitions]
+*/
+
+namespace
+{
+    /*size of the level the objects are scattered over*/
+    constexpr float levelSize = 2000.0f;
+
+    /*different models of the level, every model has its own meshes*/
+    constexpr std::uint32_t modelCount = 120;
+    constexpr std::uint32_t materialCount = 60;
+
+    /*pipeline state ids of the opaque and of the blended render types, like the first and the last render types of the level*/
+    constexpr std::uint32_t opaquePSOs = 4;
+    constexpr std::uint32_t blendedPSO = 9;
+
+    /*one object of the level*/
+    struct Object
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+
+        std::uint32_t pso = 0;
+        std::uint32_t model = 0;
+        std::uint32_t meshCount = 1;
+        std::uint32_t material = 0;
+    };
+
+    /*
+    adds the packets of all objects like Level::buildDrawPackets, blended objects keep their order
+    @param objects of the level
+    @param camera position
+    @param builder receiving the packets
+    */
+    void build(const std::vector<Object>& objects, const float* eye, DrawPacketBuilder& builder)
+    {
+        builder.clear();
+
+        for (std::uint32_t i = 0; i < (std::uint32_t)objects.size(); i++)
+        {
+            const Object& o = objects[i];
+
+            for (std::uint32_t m = 0; m < o.meshCount; m++)
+            {
+                if (o.pso == blendedPSO)
+                {
+                    builder.add(DrawPacketBuilder::makeOrderedKey(o.pso, i, m), i, m);
+                }
+                else
+                {
+                    const float dx = o.x - eye[0];
+                    const float dy = o.y - eye[1];
+                    const float dz = o.z - eye[2];
+
+                    builder.add(DrawPacketBuilder::makeOpaqueKey(o.pso, o.model * 3 + m, o.material + m, dx * dx + dy * dy + dz * dz), i, m);
+                }
+            }
+        }
+    }
+
+    /*draws and state changes of the submit loop*/
+    struct Submit
+    {
+        unsigned int draws = 0;
+        unsigned int psoChanges = 0;
+        unsigned int meshChanges = 0;
+
+        /*runs of opaque packets with the same pipeline state, mesh and material*/
+        unsigned int mergedDraws = 0;
+    };
+
+    /*
+    @param sorted packets
+    @returns what the submit loop of the level sends to the command list
+    */
+    Submit countSubmit(const std::vector<DrawPacket>& packets)
+    {
+        Submit submit;
+
+        std::uint64_t previous = 0;
+
+        for (size_t i = 0; i < packets.size(); i++)
+        {
+            const std::uint64_t key = packets[i].sortKey;
+            const std::uint32_t pso = DrawPacketBuilder::getPSO(key);
+
+            submit.draws++;
+
+            if (i == 0 || pso != DrawPacketBuilder::getPSO(previous))
+            {
+                submit.psoChanges++;
+            }
+
+            /*the mesh is part of the key of opaque packets, blended packets change it with every object*/
+            if (i == 0 || pso == blendedPSO || ((key >> 32) & 0xFFFFFF) != ((previous >> 32) & 0xFFFFFF))
+            {
+                submit.meshChanges++;
+            }
+
+            /*pso, mesh and material are the upper 48 bit of an opaque key*/
+            if (i == 0 || pso == blendedPSO || (key >> 16) != (previous >> 16))
+            {
+                submit.mergedDraws++;
+            }
+
+            previous = key;
+        }
+
+        return submit;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned int objectCount = argc >= 2 ? (unsigned int)std::stoul(argv[1]) : 20000;
+    const unsigned int repetitions = argc >= 3 ? (unsigned int)std::stoul(argv[2]) : 200;
+
+    /*most objects are opaque, one in ten is blended*/
+    std::mt19937 random(4953);
+    std::uniform_real_distribution<float> position(-levelSize * 0.5f, levelSize * 0.5f);
+    std::uniform_real_distribution<float> height(0.0f, 40.0f);
+    std::uniform_int_distribution<std::uint32_t> pso(0, opaquePSOs - 1);
+    std::uniform_int_distribution<std::uint32_t> model(0, modelCount - 1);
+    std::uniform_int_distribution<std::uint32_t> material(0, materialCount - 1);
+    std::uniform_int_distribution<std::uint32_t> meshes(1, 3);
+    std::uniform_int_distribution<int> blended(0, 9);
+
+    std::vector<Object> objects(objectCount);
+
+    for (auto& o : objects)
+    {
+        o.x = position(random);
+        o.y = height(random);
+        o.z = position(random);
+        o.pso = blended(random) == 0 ? blendedPSO : pso(random);
+        o.model = model(random);
+        o.meshCount = meshes(random);
+        o.material = material(random);
+    }
+
+    const float eye[3] = { -600.0f, 20.0f, -600.0f };
+
+    DrawPacketBuilder builder;
+    std::vector<DrawPacket> reference;
+
+    long long buildNs = 0;
+    long long radixNs = 0;
+    long long stableNs = 0;
+    bool same = true;
+
+    /*the first run warms the caches, every run sorts freshly built packets*/
+    for (unsigned int r = 0; r <= repetitions; r++)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        build(objects, eye, builder);
+
+        const auto built = std::chrono::high_resolution_clock::now();
+
+        reference = builder.getPackets();
+        const auto copied = std::chrono::high_resolution_clock::now();
+
+        builder.sort();
+
+        const auto sorted = std::chrono::high_resolution_clock::now();
+
+        std::stable_sort(reference.begin(), reference.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; });
+
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        if (r == 0) continue;
+
+        buildNs += std::chrono::duration_cast<std::chrono::nanoseconds>(built - start).count();
+        radixNs += std::chrono::duration_cast<std::chrono::nanoseconds>(sorted - copied).count();
+        stableNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - sorted).count();
+
+        const auto& packets = builder.getPackets();
+
+        for (size_t i = 0; same && i < packets.size(); i++)
+        {
+            same = packets[i].sortKey == reference[i].sortKey && packets[i].object == reference[i].object && packets[i].mesh == reference[i].mesh;
+        }
+    }
+
+    const double packetRuns = (double)repetitions * (double)(std::max)(builder.size(), (size_t)1);
+    const Submit submit = countSubmit(builder.getPackets());
+
+    std::cout << "Building and sorting " << builder.size() << " draw packets of " << objectCount << " objects " << repetitions << " times.\n";
+    std::cout << "build ns/packet | radix sort ns/packet | stable sort ns/packet | same order\n";
+    std::cout << std::fixed << std::setprecision(2) << (double)buildNs / packetRuns << " | " << (double)radixNs / packetRuns << " | "
+              << (double)stableNs / packetRuns << " | " << (same ? "yes" : "no") << "\n";
+
+    std::cout << "\ndraws | pso changes | mesh changes | draws with merged runs of equal pso, mesh and material\n";
+    std::cout << submit.draws << " | " << submit.psoChanges << " | " << submit.meshChanges << " | " << submit.mergedDraws << "\n";
+
+    if (!same)
+    {
+        std::cerr << "The radix sort gave another order than the stable sort!" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
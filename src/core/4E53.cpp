@@ -16,7 +16,10 @@
 #include "../core/title.h"
 #include "../core/transition.h"
 #include "../core/coins.h"
+#include "../util/jobsystem.h"
+#include "../util/clipcompressor.h"
 #include <filesystem>
+#include <sstream>
 
 #ifndef _DEBUG
 inline const std::string SETTINGS_FILE = "config/settings.json";
@@ -123,6 +126,28 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE /*hPrevInstance*
     auto randomizer = std::make_shared<Randomizer>();
     ServiceProvider::setRandomizer(randomizer);
 
+    /*worker threads for the frame update, the main thread works on every job as well*/
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    auto jobSystem = std::make_shared<JobSystem>(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+    ServiceProvider::setJobSystem(jobSystem);
+
+    /*offline compression of the animation clips: -compressclips [translation tolerance] [scale tolerance] [rotation tolerance]*/
+    if (__argc >= 2 && std::string(__argv[1]) == "-compressclips")
+    {
+        ClipCompressor::Tolerance tolerance;
+
+        if (__argc >= 3) tolerance.translation = std::stof(__argv[2]);
+        if (__argc >= 4) tolerance.scale = std::stof(__argv[3]);
+        if (__argc >= 5) tolerance.rotation = std::stof(__argv[4]);
+
+        std::stringstream report;
+        const UINT compressed = ClipCompressor(tolerance).compressDirectory(ANIM_PATH, report);
+
+        LOG(Severity::Info, report.str() << "Compressed " << compressed << " animation clips.");
+
+        return 0;
+    }
+
     /*load settings file*/
     SettingsLoader settingsLoader;
 
@@ -450,24 +475,18 @@ bool P_4E53::Initialize()
             counter++;
         }
 
-        if (ServiceProvider::getActiveLevel()->mGameObjects.size() > 0)
+        /*select the first selectable object, the pick handle is the selection index*/
+        for (const auto& g : ServiceProvider::getActiveLevel()->getPickableObjects())
         {
-            std::vector<GameObject*> validGameObjects;
-
-            for (const auto& g : ServiceProvider::getActiveLevel()->mGameObjects)
+            if ((g->gameObjectType == ObjectType::Default ||
+                g->gameObjectType == ObjectType::Wall ||
+                g->gameObjectType == ObjectType::Skinned) &&
+                g->isSelectable)
             {
-                if ((g.second->gameObjectType == ObjectType::Default ||
-                    g.second->gameObjectType == ObjectType::Wall ||
-                    g.second->gameObjectType == ObjectType::Skinned) &&
-                    g.second->isSelectable)
-                {
-                    validGameObjects.push_back(g.second.get());
-                }
+                ServiceProvider::getEditSettings()->currentSelectionIndex = (int)g->pickHandle;
+                ServiceProvider::getEditSettings()->currentSelection = g;
+                break;
             }
-
-            ServiceProvider::getEditSettings()->currentSelectionIndex = 0;
-            ServiceProvider::getEditSettings()->currentSelection = validGameObjects[ServiceProvider::getEditSettings()->currentSelectionIndex];
-
         }
 
         /*init ordered Models*/
@@ -577,6 +596,7 @@ void P_4E53::update(const GameTime& gt)
     auto activeCamera = ServiceProvider::getActiveCamera();
 
     renderResource->cycleFrameResource();
+    renderResource->poseCache.beginFrame(gt.TotalTime());
     FrameResource* mCurrentFrameResource = renderResource->getCurrentFrameResource();
 
     /*wait for gpu if necessary*/
@@ -1037,18 +1057,18 @@ void P_4E53::update(const GameTime& gt)
                 {
                     if (editSettings->currentSelection->gameObjectType == ObjectType::Default)
                     {
-                        editSettings->currentSelection->renderItem->staticModel = renderResource->mModels["box"].get();
-                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["invWall"].get();
+                        editSettings->currentSelection->renderItem->staticModel = renderResource->mModels["box"_id].get();
+                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["invWall"_id].get();
                         editSettings->currentSelection->gameObjectType = ObjectType::Wall;
                         editSettings->currentSelection->renderItem->renderType = RenderType::DefaultTransparency;
                         editSettings->currentSelection->renderItem->shadowType = ShadowRenderType::ShadowAlpha;
-                        editSettings->currentSelection->renderItem->NumFramesDirty = gNumFrameResources;
+                        renderResource->markDirty(editSettings->currentSelection->renderItem.get());
                         editSettings->currentSelection->isDrawEnabled = false;
                         editSettings->currentSelection->isShadowEnabled = false;
                         editSettings->currentSelection->isShadowForced = false;
                         editSettings->currentSelection->isCollisionEnabled = true;
 
-                        editSettings->currentSelection->getCollider().setBaseBoxes(renderResource->mModels["box"]->baseModelBox);
+                        editSettings->currentSelection->getCollider().setBaseBoxes(renderResource->mModels["box"_id]->baseModelBox);
                         editSettings->currentSelection->updateTransforms();
                         activeLevel->calculateRenderOrderSizes();
 
@@ -1085,7 +1105,7 @@ void P_4E53::update(const GameTime& gt)
 
                     if (editSettings->selectedGroup == "default")
                     {
-                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"].get();
+                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"_id].get();
                     }
                     else
                     {
@@ -1093,7 +1113,7 @@ void P_4E53::update(const GameTime& gt)
                     }
 
                     editSettings->currentSelection->setTextureScale(XMFLOAT3(1.0f, 1.0f, 1.0f));
-                    editSettings->currentSelection->renderItem->NumFramesDirty = gNumFrameResources;
+                    renderResource->markDirty(editSettings->currentSelection->renderItem.get());
 
                     editSettings->currentSelection->getCollider().setBaseBoxes(editSettings->currentSelection->renderItem->staticModel->baseModelBox);
                     editSettings->currentSelection->updateTransforms();
@@ -1128,7 +1148,7 @@ void P_4E53::update(const GameTime& gt)
 
                     if (editSettings->selectedGroup == "default")
                     {
-                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"].get();
+                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"_id].get();
                     }
                     else
                     {
@@ -1136,7 +1156,7 @@ void P_4E53::update(const GameTime& gt)
                     }
 
                     editSettings->currentSelection->setTextureScale(XMFLOAT3(1.0f, 1.0f, 1.0f));
-                    editSettings->currentSelection->renderItem->NumFramesDirty = gNumFrameResources;
+                    renderResource->markDirty(editSettings->currentSelection->renderItem.get());
                     editSettings->currentSelection->getCollider().setBaseBoxes(editSettings->currentSelection->renderItem->staticModel->baseModelBox);
                     editSettings->currentSelection->updateTransforms();
                     setModelSelection();
@@ -1173,7 +1193,7 @@ void P_4E53::update(const GameTime& gt)
 
                     if (editSettings->selectedGroup == "default")
                     {
-                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"].get();
+                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"_id].get();
                     }
                     else
                     {
@@ -1183,7 +1203,7 @@ void P_4E53::update(const GameTime& gt)
                     editSettings->currentSelection->getCollider().setBaseBoxes(editSettings->currentSelection->renderItem->staticModel->baseModelBox);
                     editSettings->currentSelection->updateTransforms();
                     editSettings->currentSelection->setTextureScale(XMFLOAT3(1.0f, 1.0f, 1.0f));
-                    editSettings->currentSelection->renderItem->NumFramesDirty = gNumFrameResources;
+                    renderResource->markDirty(editSettings->currentSelection->renderItem.get());
 
                     resetCollisionOnModelSwitch();
                 }
@@ -1216,7 +1236,7 @@ void P_4E53::update(const GameTime& gt)
 
                     if (editSettings->selectedGroup == "default")
                     {
-                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"].get();
+                        editSettings->currentSelection->renderItem->MaterialOverwrite = renderResource->mMaterials["default"_id].get();
                     }
                     else
                     {
@@ -1226,7 +1246,7 @@ void P_4E53::update(const GameTime& gt)
                     editSettings->currentSelection->getCollider().setBaseBoxes(editSettings->currentSelection->renderItem->staticModel->baseModelBox);
                     editSettings->currentSelection->updateTransforms();
                     editSettings->currentSelection->setTextureScale(XMFLOAT3(1.0f, 1.0f, 1.0f));
-                    editSettings->currentSelection->renderItem->NumFramesDirty = gNumFrameResources;
+                    renderResource->markDirty(editSettings->currentSelection->renderItem.get());
 
                     resetCollisionOnModelSwitch();
                 }
@@ -1282,41 +1302,8 @@ void P_4E53::update(const GameTime& gt)
 
                     LOG(Severity::Info, "Create new game object " << newGO["Name"] << ".");
 
-                    for (const auto& e : activeLevel->mGameObjects)
-                    {
-                        if (e.second->Name == newGO["Name"])
-                        {
-                            editSettings->currentSelection = e.second.get();
-
-
-                            /*find out the selection index*/
-                            std::vector<GameObject*> validGameObjects;
-
-                            for (const auto& g : activeLevel->mGameObjects)
-                            {
-                                if (g.second->gameObjectType == ObjectType::Default ||
-                                    g.second->gameObjectType == ObjectType::Wall ||
-                                    g.second->gameObjectType == ObjectType::Skinned || 
-                                    g.second->gameObjectType == ObjectType::Water)
-                                {
-                                    validGameObjects.push_back(g.second.get());
-                                }
-                            }
-
-                            UINT icounter = 0;
-                            for (const auto elem : validGameObjects)
-                            {
-                                if (elem == editSettings->currentSelection)
-                                {
-                                    break;
-                                }
-                                icounter++;
-                            }
-
-                            editSettings->currentSelectionIndex = icounter;
-
-                        }
-                    }
+                    editSettings->currentSelection = activeLevel->mGameObjects[newGO["Name"]].get();
+                    editSettings->currentSelectionIndex = (int)editSettings->currentSelection->pickHandle;
 
                     editSettings->currentSelection->gameObjectType = prevGO->gameObjectType;
 
@@ -1731,62 +1718,18 @@ void P_4E53::update(const GameTime& gt)
             if (inputData.Pressed(BTN::A))
             {
                 float dist = 0.0f;
-                float tMin = MathHelper::Infinity;
 
-                GameObject* selectedObject = nullptr;
-
-                for (const auto& e : activeLevel->mGameObjects)
-                {
-                    if (e.second->gameObjectType == ObjectType::Sky ||
-                        e.second->gameObjectType == ObjectType::Terrain ||
-                        e.second->gameObjectType == ObjectType::Debug ||
-                        !e.second->isSelectable)
-                        continue;
-
-                    /*pick object via ray cast from camera*/
-                    if (e.second->getCollider().getPickBox().Intersects(fpsCamera->getPosition(),
-                        fpsCamera->getLook(),
-                        dist))
-                    {
-                        if (dist < tMin)
-                        {
-                            tMin = dist;
-                            selectedObject = e.second.get();
-                        }
-                        
-                    }
-                }
+                /*pick object via ray cast from camera*/
+                GameObject* selectedObject = activeLevel->pickGameObject(fpsCamera->getPosition(),
+                                                                         fpsCamera->getLook(),
+                                                                         dist);
 
                 if (selectedObject)
                 {
                     LOG(Severity::Info, "Picked GameObject " << selectedObject->Name << ".");
 
-                    std::vector<GameObject*> validGameObjects;
-
-                    for (const auto& g : activeLevel->mGameObjects)
-                    {
-                        if (g.second->gameObjectType == ObjectType::Default ||
-                            g.second->gameObjectType == ObjectType::Wall ||
-                            g.second->gameObjectType == ObjectType::Skinned ||
-                            g.second->gameObjectType == ObjectType::Water)
-                        {
-                            validGameObjects.push_back(g.second.get());
-                        }
-                    }
-
-                    int index = 0;
-
-                    for (const auto& e : validGameObjects)
-                    {
-                        if (e == selectedObject)
-                        {
-                            break;
-                        }
-                        index++;
-                    }
-
                     editSettings->currentSelection = selectedObject;
-                    editSettings->currentSelectionIndex = index;
+                    editSettings->currentSelectionIndex = (int)selectedObject->pickHandle;
 
                     setModelSelection();
 
@@ -29,9 +29,3 @@ bool BaseCollider::intersects(const DirectX::BoundingFrustum& cameraFrustum) con
 {
     return cameraFrustum.Contains(frustumCheckBoundingBox) == DirectX::DISJOINT;
 }
-
-/*intersect with shadow sphere*/
-bool BaseCollider::intersects(const DirectX::BoundingSphere& shadowSphere) const
-{
-    return frustumCheckBoundingBox.Intersects(shadowSphere);
-}
@@ -32,7 +32,6 @@ public:
 
     /*collision functions*/
     bool intersects(const DirectX::BoundingFrustum& cameraFrustum) const;
-    bool intersects(const DirectX::BoundingSphere& shadowSphere) const;
 
 private:
 
@@ -1,6 +1,8 @@
 #include "gameobject.h"
 #include "../util/collisiondatabase.h"
 #include "../util/serviceprovider.h"
+#include "../core/level.h"
+#include "../core/transformsystem.h"
 #include "../physics/bulletphysics.h"
 
 using namespace DirectX;
@@ -94,7 +96,7 @@ GameObject::GameObject(const json& objectJson, int index, int skinnedIndex) // u
             isDrawEnabled = false;
             isShadowEnabled = false;
             isShadowForced = false;
-            rItem->staticModel = renderResource->mModels["box"].get();
+            rItem->staticModel = renderResource->mModels["box"_id].get();
             TextureScale = Scale;
             gameObjectType = ObjectType::Wall;
         }
@@ -102,7 +104,7 @@ GameObject::GameObject(const json& objectJson, int index, int skinnedIndex) // u
         {
             LOG(Severity::Warning, "GameObject " << Name << " specified not loaded model " << objectJson["Model"] << "!");
 
-            rItem->staticModel = renderResource->mModels["box"].get();
+            rItem->staticModel = renderResource->mModels["box"_id].get();
         }
     }
     else
@@ -117,12 +119,12 @@ GameObject::GameObject(const json& objectJson, int index, int skinnedIndex) // u
         {
             if (gameObjectType == ObjectType::Wall)
             {
-                rItem->MaterialOverwrite = renderResource->mMaterials["invWall"].get();
+                rItem->MaterialOverwrite = renderResource->mMaterials["invWall"_id].get();
             }
             else
             {
                 LOG(Severity::Warning, "GameObject " << Name << " specified not loaded material " << objectJson["Material"] << "!");
-                rItem->MaterialOverwrite = renderResource->mMaterials["default"].get();
+                rItem->MaterialOverwrite = renderResource->mMaterials["default"_id].get();
             }
         }
         else
@@ -287,8 +289,8 @@ GameObject::GameObject(const std::string& name, int index, int skinnedIndex) //
 
     if (skinnedIndex == -1)
     {
-        tItem->staticModel = renderResource->mModels["box"].get();
-        tItem->MaterialOverwrite = renderResource->mMaterials["default"].get();
+        tItem->staticModel = renderResource->mModels["box"_id].get();
+        tItem->MaterialOverwrite = renderResource->mMaterials["default"_id].get();
     }
     else
     {
@@ -340,35 +342,113 @@ void GameObject::update(const GameTime& gt)
     // update animation for skinned objects
     if (gameObjectType == ObjectType::Skinned)
     {
-        if (renderItem->currentClip != nullptr)
+        updateAnimation(gt);
+    }
+
+
+}
+
+void GameObject::updateAnimation(const GameTime& gt)
+{
+    AnimationInstance& animation = renderItem->animation;
+
+    if (animation.currentClip != nullptr)
+    {
+        animation.animationTimer += gt.DeltaTime() * animationTimeScale;
+
+        if (animation.animationTimer >= animation.currentClip->getEndTime())
         {
-            renderItem->animationTimer += gt.DeltaTime() * animationTimeScale;
+            animation.animationTimer = fmod(animation.animationTimer, animation.currentClip->getEndTime());
+        }
 
-            if (renderItem->animationTimer >= renderItem->currentClip->getEndTime())
-            {
-                renderItem->animationTimer = fmod(renderItem->animationTimer, renderItem->currentClip->getEndTime());
-            }
+        if (animation.animationTimer <= animation.currentClip->getStartTime())
+        {
+            animation.animationTimer = animation.currentClip->getEndTime() - fmod(animation.animationTimer, animation.currentClip->getEndTime());
+        }
+    }
 
-            if (renderItem->animationTimer <= renderItem->currentClip->getStartTime())
-            {
-                renderItem->animationTimer = renderItem->currentClip->getEndTime() - fmod(renderItem->animationTimer, renderItem->currentClip->getEndTime());
-            }
+    /*the faded out clip and the additive layers keep playing and loop like the current clip*/
+    AnimationBlend& blend = animation.animationBlend;
+    const float deltaTime = gt.DeltaTime() * animationTimeScale;
 
+    auto advance = [deltaTime](AnimationLayer& layer)
+    {
+        const float duration = layer.clip->getEndTime();
+
+        layer.time += deltaTime;
+
+        if (duration > 0.0f && (layer.time >= duration || layer.time < 0.0f))
+        {
+            layer.time = fmod(layer.time, duration);
+            layer.time += layer.time < 0.0f ? duration : 0.0f;
         }
+    };
 
-        if (currentlyInFrustum || !isFrustumCulled)
-            renderItem->skinnedModel->calculateFinalTransforms(renderItem->currentClip, renderItem->finalTransforms, renderItem->animationTimer);
+    if (blend.hasFadeSource())
+    {
+        blend.fadeElapsed += gt.DeltaTime();
 
+        if (!blend.isFading())
+        {
+            blend.stopFade();
+        }
+        else if (blend.fadeOut.clip != nullptr)
+        {
+            advance(blend.fadeOut);
+        }
     }
 
+    for (auto& layer : blend.additive)
+    {
+        advance(layer);
+    }
 
+    /*off screen only the time advances, the pose is evaluated again as soon as the object is visible*/
+    if (!currentlyInFrustum && isFrustumCulled)
+    {
+        animationOutdated = true;
+        return;
+    }
+
+    auto renderResource = ServiceProvider::getRenderResource();
+    const GraphicSettings& settings = ServiceProvider::getSettings()->graphicSettings;
+
+    const XMVECTOR toCamera = XMVectorSubtract(ServiceProvider::getActiveCamera()->getPosition(), XMLoadFloat3(&Position));
+    const float distanceSq = XMVectorGetX(XMVector3LengthSq(toCamera));
+
+    auto beyond = [distanceSq](float distance)
+    {
+        return distance > 0.0f && distanceSq > distance * distance;
+    };
+
+    /*distant objects are evaluated every 2nd or 4th frame, spread over the frames by their address*/
+    UINT interval = 1;
+
+    if (beyond(settings.AnimationLodQuarterRateDistance))
+    {
+        interval = 4;
+    }
+    else if (beyond(settings.AnimationLodHalfRateDistance))
+    {
+        interval = 2;
+    }
+
+    const UINT offset = (UINT)(reinterpret_cast<std::uintptr_t>(this) >> 6);
+
+    if (!animationOutdated && (renderResource->poseCache.getFrame() + offset) % interval != 0)
+    {
+        return;
+    }
+
+    animationOutdated = false;
+
+    animation.animatedBoneDepth = beyond(settings.AnimationBoneMaskDistance) ? (UINT)settings.AnimationBoneMaskDepth : UINT_MAX;
+
+    renderResource->requestPose(renderItem.get());
 }
 
-bool GameObject::draw() const
+bool GameObject::isVisible() const
 {
-    const auto gObjRenderItem = renderItem.get();
-    const auto objectCB = ServiceProvider::getRenderResource()->getCurrentFrameResource()->ObjectCB->getResource();
-
     if (gameObjectType == ObjectType::Debug) return false;
 
     if (!isDrawEnabled &&
@@ -379,6 +459,16 @@ bool GameObject::draw() const
 
     if (!currentlyInFrustum && isFrustumCulled) return false;
 
+    return true;
+}
+
+bool GameObject::draw() const
+{
+    const auto gObjRenderItem = renderItem.get();
+    const auto objectCB = ServiceProvider::getRenderResource()->getCurrentFrameResource()->ObjectCB->getResource();
+
+    if (!isVisible()) return false;
+
     const auto renderResource = ServiceProvider::getRenderResource();
 
     D3D12_GPU_VIRTUAL_ADDRESS cachedObjCBAddress = 0;
@@ -578,9 +668,32 @@ void GameObject::setPosition(DirectX::XMFLOAT3 _pos, bool updTrf)
     }
 
 
+    if (transformSystem)
+    {
+        transformSystem->setPosition(transformHandle, Position);
+    }
+
     if(updTrf)
-        updateTransforms();
+        requestTransformUpdate();
+
+}
+
+void GameObject::setRotation(DirectX::XMFLOAT3 _rot, bool updTrf)
+{
+    Rotation = _rot;
 
+    /*the transform system computes the rotation matrix together with the world matrix*/
+    if (transformSystem)
+    {
+        transformSystem->setRotation(transformHandle, Rotation);
+    }
+    else
+    {
+        XMStoreFloat4x4(&rotationQuat, XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&Rotation)));
+    }
+
+    if(updTrf)
+        requestTransformUpdate();
 }
 
 void GameObject::setScale(DirectX::XMFLOAT3 _scale)
@@ -592,7 +705,12 @@ void GameObject::setScale(DirectX::XMFLOAT3 _scale)
 
     Scale = _scale;
 
-    updateTransforms();
+    if (transformSystem)
+    {
+        transformSystem->setScale(transformHandle, Scale);
+    }
+
+    requestTransformUpdate();
 
 }
 
@@ -600,36 +718,72 @@ void GameObject::makeDynamic(SkinnedModel* sModel, UINT cbIndex)
 {
     gameObjectType = ObjectType::Skinned;
     renderItem->skinnedModel = sModel;
+    renderItem->animation.rig = sModel;
+    renderItem->animation.skinningScratch.resize(sModel->boneCount);
     setAnimation(nullptr);
 }
 
-void GameObject::setAnimation(AnimationClip* aClip, bool keepRelativeTime)
+void GameObject::setAnimation(AnimationClip* aClip, bool keepRelativeTime, float fadeDuration)
 {
+    AnimationInstance& animation = renderItem->animation;
+
     //nothing to do
-    if(renderItem->currentClip == aClip && keepRelativeTime) return;
+    if(animation.currentClip == aClip && keepRelativeTime) return;
 
     float percentTime = 0.0f;
 
     if (keepRelativeTime)
     {
-        percentTime = renderItem->animationTimer / renderItem->currentClip->getEndTime();
+        percentTime = animation.animationTimer / animation.currentClip->getEndTime();
     }
 
-    renderItem->currentClip = aClip;
+    /*the previous clip keeps playing from its current time while it fades out*/
+    AnimationBlend& blend = animation.animationBlend;
+
+    if (fadeDuration > 0.0f && animation.currentClip != nullptr && aClip != nullptr && animation.currentClip != aClip)
+    {
+        animation.startFade(fadeDuration);
+    }
+    else
+    {
+        blend.stopFade();
+    }
+
+    animation.currentClip = aClip;
+    animationOutdated = true;
+    animation.keyCursors.assign(aClip != nullptr ? aClip->boneAnimations.size() : 0, 0);
 
     if (aClip != nullptr)
     {
-        renderItem->animationTimer = percentTime * renderItem->currentClip->getEndTime();
-        renderItem->finalTransforms.resize(aClip->boneAnimations.size());
+        animation.animationTimer = percentTime * animation.currentClip->getEndTime();
+        animation.finalTransforms.resize(aClip->boneAnimations.size());
     }
     else
     {
-        renderItem->animationTimer = 0.0f;
-        renderItem->finalTransforms.resize(96);
+        animation.animationTimer = 0.0f;
+        animation.finalTransforms.resize(96);
     }
     
 }
 
+void GameObject::addAdditiveAnimation(AnimationClip* aClip, float weight)
+{
+    if (aClip == nullptr) return;
+
+    AnimationLayer layer;
+    layer.clip = aClip;
+    layer.weight = weight;
+
+    renderItem->animation.animationBlend.additive.push_back(layer);
+    animationOutdated = true;
+}
+
+void GameObject::clearAdditiveAnimations()
+{
+    renderItem->animation.animationBlend.additive.clear();
+    animationOutdated = true;
+}
+
 void GameObject::checkInViewFrustum(BoundingFrustum& localCamFrustum)
 {
 
@@ -669,5 +823,28 @@ void GameObject::updateTransforms()
     /*update collider*/
     collider.update(renderItem->World);
 
-    renderItem->NumFramesDirty = gNumFrameResources;
+    markTransformChanged();
+}
+
+void GameObject::requestTransformUpdate()
+{
+    if (transformSystem)
+    {
+        transformSystem->markDirty(transformHandle);
+    }
+    else
+    {
+        updateTransforms();
+    }
+}
+
+void GameObject::markTransformChanged()
+{
+    ServiceProvider::getRenderResource()->markDirty(renderItem.get());
+
+    /*the level is not active yet while loading, objects are inserted with their final bounds at the end of load()*/
+    if (cullingHandle != UINT_MAX && !cullingQueued && ServiceProvider::getActiveLevel())
+    {
+        ServiceProvider::getActiveLevel()->markMoved(this);
+    }
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "../core/basecollider.h"
 #include <btBulletDynamicsCommon.h>
 
+class TransformSystem;
+
 using json = nlohmann::json;
 
 enum class ObjectType
@@ -34,6 +36,7 @@ public:
     friend class BulletPhysics;
     friend class P_4E53;
     friend class EditModeHUD;
+    friend class TransformSystem;
 
     /*load a game object from a json*/
     explicit GameObject(const json& objectJson, int index, int skinnedIndex = -1);
@@ -51,6 +54,9 @@ public:
     virtual void update(const GameTime& gt);
     bool draw() const;
     bool drawShadow() const;
+
+    /*same checks draw() does before it draws anything*/
+    bool isVisible() const;
     void drawPickBox() const;
 
     json toJson() const;
@@ -72,7 +78,19 @@ public:
     bool isShadowForced = false;
     bool isSelectable = true;
 
-    bool currentlyInShadowSphere = false;
+    /*inside the light volume of the shadow map in the current frame*/
+    bool currentlyInLightVolume = false;
+
+    /*handle in the culling tree of the level, transform changes are queued to the level*/
+    UINT cullingHandle = UINT_MAX;
+    bool cullingQueued = false;
+
+    /*handle in the pick hierarchy of the level, also used as stable selection index in the editor*/
+    UINT pickHandle = UINT_MAX;
+
+    /*static objects of the level defer their transform changes to the transform system*/
+    TransformSystem* transformSystem = nullptr;
+    UINT transformHandle = UINT_MAX;
 
 protected:
 
@@ -108,8 +126,17 @@ protected:
     DirectX::XMFLOAT3 TextureTranslation, TextureRotation, TextureScale;
     DirectX::XMFLOAT4X4 rotationQuat;
 
+    /*
+    advances the animation time and requests the pose if the animation lod allows it, can run in update jobs
+    @param game time
+    */
+    void updateAnimation(const GameTime& gt);
+
     /*render related*/
     bool currentlyInFrustum = false;
+
+    /*the pose was skipped while the object was off screen*/
+    bool animationOutdated = true;
     UINT objectCBSize = 0;
     UINT skinnedCBSize = 0;
 
@@ -131,15 +158,7 @@ public:
 
     void setScale(DirectX::XMFLOAT3 _scale);
 
-    void setRotation(DirectX::XMFLOAT3 _rot, bool updTrf = true)
-    {
-        Rotation = _rot;
-        DirectX::XMStoreFloat4x4(&rotationQuat,
-                                 DirectX::XMMatrixRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&Rotation)));
-
-        if(updTrf)
-            updateTransforms();
-    }
+    void setRotation(DirectX::XMFLOAT3 _rot, bool updTrf = true);
 
     DirectX::XMFLOAT3 getPosition() const
     {
@@ -181,21 +200,21 @@ public:
     {
         TextureTranslation = _translation;
 
-        updateTransforms();
+        requestTransformUpdate();
     }
 
     void setTextureScale(DirectX::XMFLOAT3 _scale)
     {
         TextureScale = _scale;
 
-        updateTransforms();
+        requestTransformUpdate();
     }
 
     void setTextureRotation(DirectX::XMFLOAT3 _rot)
     {
         TextureRotation = _rot;
 
-        updateTransforms();
+        requestTransformUpdate();
     }
 
     DirectX::XMFLOAT3 getTextureTranslation() const
@@ -219,13 +238,33 @@ public:
     }
 
     void makeDynamic(SkinnedModel* sModel, UINT skinnedCBIndex);
-    void setAnimation(AnimationClip* aClip, bool keepRelativeTime = false);
+
+    /*
+    @param clip to play, nullptr for the bind pose
+    @param keep the relative time of the previous clip
+    @param seconds the previous clip is crossfaded with the new one, 0 switches immediately
+    */
+    void setAnimation(AnimationClip* aClip, bool keepRelativeTime = false, float fadeDuration = 0.0f);
+
+    /*
+    plays a clip on top of the current one, the difference to its first key is added to the pose
+    @param additive clip
+    @param weight of the difference
+    */
+    void addAdditiveAnimation(AnimationClip* aClip, float weight = 1.0f);
+    void clearAdditiveAnimations();
 
     void checkInViewFrustum(DirectX::BoundingFrustum& localCamFrustum);
+
+    /*result of a batched frustum test, objects that are not frustum culled are always visible*/
+    void setInViewFrustum(bool inFrustum)
+    {
+        currentlyInFrustum = inFrustum || !isFrustumCulled;
+    }
     void resetInViewFrustum()
     {
         currentlyInFrustum = false;
-        currentlyInShadowSphere = false;
+        currentlyInLightVolume = false;
     }
 
     BaseCollider& getCollider()
@@ -235,6 +274,12 @@ public:
 
     void updateTransforms();
 
+    /*updates the transforms now or marks them dirty in the transform system*/
+    void requestTransformUpdate();
+
+    /*queues the new world matrix for upload and the new bounds for the culling trees*/
+    void markTransformChanged();
+
     void resetMomentum()
     {
         if(bulletBody)
@@ -106,7 +106,7 @@ bool Level::load(const std::string& levelFile)
     if(ServiceProvider::getGameState() == GameState::EDITOR)
     {
         auto hitboxEdit = std::make_unique<GameObject>(std::string("HITBOX_EDIT"), amountObjectCBs++);
-        hitboxEdit->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["box"].get();
+        hitboxEdit->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["box"_id].get();
         hitboxEdit->renderItem->renderType = RenderType::Outline;
         hitboxEdit->isCollisionEnabled = false;
         hitboxEdit->isShadowEnabled = false;
@@ -153,17 +153,21 @@ bool Level::load(const std::string& levelFile)
 
 
 
-    calculateRenderOrderSizes();
-
-
     /* build quad tree and sort game objects into it */
     quadTree.build({ 0,0,0 }, mTerrain->terrainSize, mTerrain->terrainSize, 4);
+    cullingTree.build({ 0,0,0 }, mTerrain->terrainSize, mTerrain->terrainSize, 5);
+    pickTree.clear();
+    transformSystem.clear();
 
     for (const auto& i : mGameObjects)
     {
         addGameObjectToQuadTree(i.second.get());
     }
 
+    quadTree.pack();
+
+    calculateRenderOrderSizes();
+
     //LOG(Severity::Debug, "QuadTree:\n" << quadTree);
     //LOG(Severity::Debug, "Stored objects: " << quadTree.sizeContainedObjects());
 
@@ -192,12 +196,12 @@ bool Level::load(const std::string& levelFile)
 
 void Level::indicatorOn()
 {
-    mGameObjects["&INDICATOR"]->isDrawEnabled = true;
+    mGameObjects["&INDICATOR"_id]->isDrawEnabled = true;
 }
 
 void Level::indicatorOff()
 {
-    mGameObjects["&INDICATOR"]->isDrawEnabled = false;
+    mGameObjects["&INDICATOR"_id]->isDrawEnabled = false;
 }
 
 void Level::setupMazeGrid(int width, int height)
@@ -308,6 +312,7 @@ void Level::setupMazeGrid(int width, int height)
 
         ServiceProvider::getPhysics()->addGameObject(*gameObject.get());
         addGameObjectToQuadTree(gameObject.get());
+        mazeWalls.push_back(gameObject.get());
         mGameObjects[gameObject->Name] = std::move(gameObject);
     };
 
@@ -391,6 +396,31 @@ void Level::setupMazeGrid(int width, int height)
     }
 
 
+    /*the walls and coins are looked up every time a new maze is applied, build their names only once*/
+    eastWallIds.clear();
+    southWallIds.clear();
+    westWallIds.clear();
+    coinIds.clear();
+
+    for(int i = 0; i < width * height; i++)
+    {
+        eastWallIds.push_back(StringId(prefixEast + std::to_string(i)));
+        southWallIds.push_back(StringId(prefixSouth + std::to_string(i)));
+    }
+
+    for(int i = 0; i < height; i++)
+    {
+        westWallIds.push_back(StringId(prefixWest + std::to_string(i)));
+    }
+
+    for(int i = 0; i < Coins::CoinCount; i++)
+    {
+        coinIds.push_back(StringId("&COIN" + std::to_string(i)));
+    }
+
+    /*the walls and coins are searchable from now on*/
+    quadTree.pack();
+
     /*recalculate render orders*/
     calculateRenderOrderSizes();
 
@@ -411,10 +441,10 @@ void Level::setupCoins(Grid& grid)
     {
         float xPos = baseX + coinPlacement[i].first * mazeBaseWidth + baseHalf;
         float zPos = baseZ - coinPlacement[i].second * mazeBaseWidth - baseHalf;
-        mGameObjects["&COIN" + std::to_string(i)]->setPosition({ xPos, Coins::BaseHeight, zPos });
-        mGameObjects["&COIN" + std::to_string(i)]->setScale({ Coins::BaseScale, Coins::BaseScale, Coins::BaseScale });
-        mGameObjects["&COIN" + std::to_string(i)]->isDrawEnabled = true;
-        mGameObjects["&COIN" + std::to_string(i)]->setCollision(true);
+        mGameObjects[coinIds[i]]->setPosition({ xPos, Coins::BaseHeight, zPos });
+        mGameObjects[coinIds[i]]->setScale({ Coins::BaseScale, Coins::BaseScale, Coins::BaseScale });
+        mGameObjects[coinIds[i]]->isDrawEnabled = true;
+        mGameObjects[coinIds[i]]->setCollision(true);
     }
 
     ServiceProvider::getPlayer()->resetCoins();
@@ -428,17 +458,17 @@ void Level::updateToGrid(Grid& grid)
     // reactivate all walls
     for(int i = 0; i < grid.rows() * grid.columns(); i++)
     {
-        mGameObjects[prefixEast + std::to_string(i)]->setCollision(true);
-        mGameObjects[prefixSouth + std::to_string(i)]->setCollision(true);
+        mGameObjects[eastWallIds[i]]->setCollision(true);
+        mGameObjects[southWallIds[i]]->setCollision(true);
 
-        if(!mGameObjects[prefixEast + std::to_string(i)]->isDrawEnabled)
+        if(!mGameObjects[eastWallIds[i]]->isDrawEnabled)
         {
-            mGameObjects[prefixEast + std::to_string(i)]->isDrawEnabled = true;
+            mGameObjects[eastWallIds[i]]->isDrawEnabled = true;
         }
         
-        if(!mGameObjects[prefixSouth + std::to_string(i)]->isDrawEnabled)
+        if(!mGameObjects[southWallIds[i]]->isDrawEnabled)
         {
-            mGameObjects[prefixSouth + std::to_string(i)]->isDrawEnabled = true;
+            mGameObjects[southWallIds[i]]->isDrawEnabled = true;
         }
     }
 
@@ -454,15 +484,15 @@ void Level::updateToGrid(Grid& grid)
             //east wall
             if(cell->isLinked(cell->e))
             {
-                mGameObjects[prefixEast + std::to_string(currentIndex)]->isDrawEnabled = false;
-                mGameObjects[prefixEast + std::to_string(currentIndex)]->setCollision(false);
+                mGameObjects[eastWallIds[currentIndex]]->isDrawEnabled = false;
+                mGameObjects[eastWallIds[currentIndex]]->setCollision(false);
             }
 
             //south wall
             if(cell->isLinked(cell->s))
             {
-                mGameObjects[prefixSouth + std::to_string(currentIndex)]->isDrawEnabled = false;
-                mGameObjects[prefixSouth + std::to_string(currentIndex)]->setCollision(false);
+                mGameObjects[southWallIds[currentIndex]]->isDrawEnabled = false;
+                mGameObjects[southWallIds[currentIndex]]->setCollision(false);
             }
 
             x++;
@@ -471,6 +501,9 @@ void Level::updateToGrid(Grid& grid)
         x = 0;
     }
 
+    /*visibility between the cells of the new maze, built in the background during the transition*/
+    mazePVS.build(grid);
+
 }
 
 void Level::setIndicator(const GameTime& gt)
@@ -489,7 +522,7 @@ void Level::setIndicator(const GameTime& gt)
         for(int i = 0; i < Coins::CoinCount; i++)
         {
             if(!mPlayer->coins[i].collected)
-                coins.push_back(mGameObjects["&COIN" + std::to_string(i)].get());
+                coins.push_back(mGameObjects[coinIds[i]].get());
         }
 
         std::sort(coins.begin(), coins.end(), [&](const GameObject* a, const GameObject* b)
@@ -515,7 +548,7 @@ void Level::setIndicator(const GameTime& gt)
     //else point to door
     else
     {
-        const auto dPos = mGameObjects["ENDGATE"]->getPosition();
+        const auto dPos = mGameObjects["ENDGATE"_id]->getPosition();
 
         const XMFLOAT2 betweenVector = { dPos.x - pPosF3.x,
                                          dPos.z - pPosF3.z };
@@ -533,8 +566,8 @@ void Level::setIndicator(const GameTime& gt)
     fPos.z += newY;
     fPos.y += 1.5f;
 
-    mGameObjects["&INDICATOR"]->setPosition(fPos);
-    mGameObjects["&INDICATOR"]->setRotation({ 0.0f, -indicatorAngle + XM_PIDIV2 , 0.0f });
+    mGameObjects["&INDICATOR"_id]->setPosition(fPos);
+    mGameObjects["&INDICATOR"_id]->setRotation({ 0.0f, -indicatorAngle + XM_PIDIV2 , 0.0f });
 
 }
 
@@ -544,26 +577,26 @@ void Level::setStartEnd(Grid& grid, Cell* start, Cell* end)
 
     for(int i = 0; i < grid.rows(); i++)
     {
-        mGameObjects[prefixWest + std::to_string(i)]->isDrawEnabled = true;
-        mGameObjects[prefixWest + std::to_string(i)]->setCollision(true);
+        mGameObjects[westWallIds[i]]->isDrawEnabled = true;
+        mGameObjects[westWallIds[i]]->setCollision(true);
     }
 
     // open start
     auto [xPosStart, yPosStart] = start->getPosition();
-    mGameObjects[prefixWest + std::to_string(yPosStart)]->isDrawEnabled = false;
-    mGameObjects[prefixWest + std::to_string(yPosStart)]->setCollision(false);
+    mGameObjects[westWallIds[yPosStart]]->isDrawEnabled = false;
+    mGameObjects[westWallIds[yPosStart]]->setCollision(false);
 
 
     // open end
     auto [xPosEnd, yPosEnd] = end->getPosition();
    
     int index = yPosEnd * grid.columns() + xPosEnd;
-    mGameObjects[prefixEast + std::to_string(index)]->isDrawEnabled = false;
-    mGameObjects[prefixEast + std::to_string(index)]->setCollision(false);
+    mGameObjects[eastWallIds[index]]->isDrawEnabled = false;
+    mGameObjects[eastWallIds[index]]->setCollision(false);
 
     //reset end door
-    mGameObjects["ENDBLOCKED"]->setCollision(true);
-    mGameObjects["ENDGATE"]->setRotation({0.0f, XM_PIDIV2, 0.0f}
+    mGameObjects["ENDBLOCKED"_id]->setCollision(true);
+    mGameObjects["ENDGATE"_id]->setRotation({0.0f, XM_PIDIV2, 0.0f}
 
     );
 }
@@ -582,8 +615,6 @@ void Level::update(const GameTime& gt)
 {
     GameState gstate = ServiceProvider::getGameState();
 
-    std::vector<QuadTree::QuadNode*> frustumNodes;
-
     auto renderResource = ServiceProvider::getRenderResource();
     auto aCamera = ServiceProvider::getActiveCamera();
 
@@ -593,72 +624,103 @@ void Level::update(const GameTime& gt)
     BoundingFrustum localSpaceFrustum;
     aCamera->getFrustum().Transform(localSpaceFrustum, invView);
 
+    auto jobs = ServiceProvider::getJobSystem();
+
+    /*apply transform changes made outside of the level update, e.g. by the editor*/
+    transformSystem.flush(jobs);
+
+    /*move objects that changed their transform since the last frame to their new node*/
+    applyMovedObjects();
+
     /*update the in camera frustum property of the game objects*/
-    quadTree.searchCollision(localSpaceFrustum, frustumNodes);
+    frustumObjects.clear();
+    cullingTree.searchCollision(localSpaceFrustum, frustumObjects);
 
     /*reset*/
     for (auto& gameObj : mGameObjects)
     {
         gameObj.second->resetInViewFrustum();
+    }
 
-        if (gameObj.second->isShadowForced || gameObj.second->getCollider().intersects(renderResource->getShadowMap()->shadowBounds))
-        {
-            gameObj.second->currentlyInShadowSphere = true;
-        }
+    /*collect shadow casters, the quadtree can only be used outside of the editor*/
+    buildShadowCasters(gstate == GameState::EDITOR);
+
+    /*update inViewFrustum status of objects in visible nodes, the culling tree
+    also follows moving and edited objects so this works in every game state*/
+    frustumCuller.clear();
+
+    for (const auto& gO : frustumObjects)
+    {
+        frustumCuller.add(gO->getCollider().getFrustumBox());
     }
 
-    /*update inViewFrustum status of objects in visible nodes*/
-    /* when in edit mode the quadtree is disabled because objects
-    can be moved out of their original cell.*/
-    if(gstate != GameState::EDITOR)
+    const FrustumPlanes frustumPlanes(localSpaceFrustum);
+
+    /*every block of boxes owns its part of the mask and its objects, so the blocks can be culled on different threads*/
+    jobs->parallelFor(frustumCuller.getBlockCount(), 4, [&](UINT firstBlock, UINT lastBlock)
     {
-        for(const auto& i : frustumNodes)
+        frustumCuller.cull(frustumPlanes, firstBlock, lastBlock);
+
+        const UINT last = (std::min)(lastBlock * BoxCuller::BLOCK_SIZE, (UINT)frustumObjects.size());
+
+        for (UINT i = firstBlock * BoxCuller::BLOCK_SIZE; i < last; i++)
         {
-            for(auto& gO : i->containedObjects)
-            {
-                gO->checkInViewFrustum(localSpaceFrustum);
-            }
+            frustumObjects[i]->setInViewFrustum(frustumCuller.isVisible(i));
         }
+    });
+
+    for (const auto& gO : untrackedObjects)
+    {
+        gO->checkInViewFrustum(localSpaceFrustum);
+    }
+
+    /*inside the maze most objects in the frustum are hidden behind walls*/
+    if (gstate == GameState::INGAME && !mazeWalls.empty())
+    {
+        cullByPVS(aCamera);
+        cullOccluded(aCamera);
     }
 
     /*udpdate all game objects*/
-    for (auto& gameObj : mGameObjects)
+    if (gstate != GameState::EDITOR)
     {
-        if(gstate == GameState::EDITOR)
+        /*update() only changes the object itself, they are updated in fixed chunks.
+        skinned objects only request their pose here, all poses are evaluated in parallel by the render resource.*/
+        jobs->parallelFor((UINT)updateObjects.size(), 32, [&](UINT first, UINT last)
         {
-            gameObj.second->checkInViewFrustum(localSpaceFrustum);
-        }
-        else
-        {
-            /*objects that can move out of quad tree are all checked for frustum cull*/
-            if(gameObj.second->motionType != ObjectMotionType::Static)
+            for (UINT i = first; i < last; i++)
             {
-                gameObj.second->checkInViewFrustum(localSpaceFrustum);
+                updateObjects[i]->update(gt);
             }
+        });
+    }
 
-            gameObj.second->update(gt);
-
+    /*object specific game logic, changes other objects so it runs after all updates*/
+    for (const auto& gO : scriptedObjects)
+    {
+        if(gstate != GameState::EDITOR)
+        {
             /* open door if all coins collected*/
-            if(gameObj.first.rfind("ENDG", 0) == 0 &&
+            if(gO->Name.rfind("ENDG", 0) == 0 &&
                ServiceProvider::getPlayer()->coinCount() == Coins::CoinCount)
             {
-                auto rot = gameObj.second->getRotation();
+                auto rot = gO->getRotation();
                 if(rot.y < XM_PI)
                 {
                     rot.y += XM_PIDIV2 * gt.DeltaTime();
-                    gameObj.second->setRotation(rot);
+                    gO->setRotation(rot);
                 }
                 else
                 {
-                    mGameObjects["ENDBLOCKED"]->setCollision(false);
+                    mGameObjects["ENDBLOCKED"_id]->setCollision(false);
                 }
 
             }
 
             /*update coin animation*/
-            if(gameObj.first.rfind("&COIN", 0) == 0 && gstate == GameState::INGAME)
+            if(gO->Name.rfind("&COIN", 0) == 0 && gstate == GameState::INGAME)
             {
-                const int coinIndex = static_cast<int>(gameObj.second->Name[5] - '0');
+                const int coinIndex = static_cast<int>(gO->Name[5] - '0');
                 auto& pCoins = ServiceProvider::getPlayer()->coins;
 
                 if(pCoins[coinIndex].collected && !pCoins[coinIndex].animationFinished)
@@ -668,102 +730,77 @@ void Level::update(const GameTime& gt)
                     if(pCoins[coinIndex].animationTime > Coins::FadeTime)
                     {
                         pCoins[coinIndex].animationFinished = true;
-                        gameObj.second->isDrawEnabled = false;
+                        gO->isDrawEnabled = false;
                     }
                     else
                     {
-                        auto pos = gameObj.second->getPosition();
-                        auto rot = gameObj.second->getRotation();
+                        auto pos = gO->getPosition();
+                        auto rot = gO->getRotation();
                         float y = Coins::BaseHeight * 2.25f * gt.DeltaTime();
                         float yRot = XM_2PI * 2.5f * gt.DeltaTime();
                         float scale = Coins::BaseScale * std::clamp((-0.5f * (pCoins[coinIndex].animationTime) / Coins::FadeTime) + 1.0f, 0.5f, 1.0f);
 
-                        gameObj.second->setPosition({
+                        gO->setPosition({
                             pos.x, pos.y + y, pos.z
                                                     });
-                        gameObj.second->setRotation({
+                        gO->setRotation({
                             rot.x, rot.y + yRot, rot.z
                                                     });
 
-                        gameObj.second->setScale({
+                        gO->setScale({
                             scale, scale, scale });
                     }
 
                 }
                 else
                 {
-                    auto pos = gameObj.second->getPosition();
-                    auto rot = gameObj.second->getRotation();
+                    auto pos = gO->getPosition();
+                    auto rot = gO->getRotation();
                     float y = Coins::BaseHeight + (std::sinf(gt.TotalTime()) * 0.3f);
                     float yRot = std::fmodf(gt.TotalTime() * 0.5f, XM_2PI);
-                    gameObj.second->setPosition({
+                    gO->setPosition({
                         pos.x, y, pos.z
                                                 });
-                    gameObj.second->setRotation({
+                    gO->setRotation({
                         rot.x, yRot, rot.z
                                                 });
                 }
 
             }
 
-            if(gameObj.first.rfind("BANNER", 0) == 0 && gstate == GameState::TITLE)
+            if(gO->Name.rfind("BANNER", 0) == 0 && gstate == GameState::TITLE)
             {
-                auto rot = gameObj.second->getRotation();
+                auto rot = gO->getRotation();
 
                 float scale = 2.5f + (std::cos(gt.TotalTime() * 0.5f) * 0.25f);
                 float x = -XM_PIDIV4 / 4.0f + std::sin(gt.TotalTime() * 0.5f) * (XM_PIDIV4 / 2.0f);
 
-                gameObj.second->setScale({ scale, scale,scale });
-                gameObj.second->setRotation({ x, rot.y, rot.z });
+                gO->setScale({ scale, scale,scale });
+                gO->setRotation({ x, rot.y, rot.z });
             }
 
         }
         
     }
 
-    /*update order of light objects*/
+    /*world matrices of everything the game logic moved, uploaded by updateBuffers() after this*/
+    transformSystem.flush(jobs);
 
-    const auto cameraPos = aCamera->getTarget();
+    /*assign point and spot lights to the view space clusters*/
+    updateLightClusters(aCamera);
 
-    /*order point lights by shortest distance from camera*/
     if (gstate == GameState::EDITOR)
     {
-        auto lPtr = mLightObjects[ServiceProvider::getEditSettings()->currentLightSelectionIndex].get();
-
-        std::sort(mLightObjects.begin() + AMOUNT_DIRECTIONAL,
-                  mLightObjects.end() - AMOUNT_SPOT,
-                  [&](const std::unique_ptr<LightObject>& a, const std::unique_ptr<LightObject>& b)
-                  {
-                      XMVECTOR lengthA = XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&a->getPosition()), cameraPos));
-                      XMVECTOR lengthB = XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&b->getPosition()), cameraPos));
-
-                      XMFLOAT3 t{}, s{};
-                      XMStoreFloat3(&t, lengthA);
-                      XMStoreFloat3(&s, lengthB);
-
-                      return t.x < s.x;
-                  });
-
-        for (UINT i = 3; i < mLightObjects.size() - 1; i++)
-        {
-            if (mLightObjects[i].get() == lPtr)
-            {
-                ServiceProvider::getEditSettings()->currentLightSelectionIndex = i;
-                ServiceProvider::getEditSettings()->currentLightSelectionPointIndex = i;
-                break;
-            }
-        }
-
         // update hitbox game object
         auto sel = ServiceProvider::getEditSettings()->currentSelection;
 
         if(sel != nullptr && ServiceProvider::getEditSettings()->toolMode == EditTool::ObjectCollision)
         {
 
-            mGameObjects["HITBOX_EDIT"]->isDrawEnabled = true;
+            mGameObjects["HITBOX_EDIT"_id]->isDrawEnabled = true;
 
-            mGameObjects["HITBOX_EDIT"]->setPosition(sel->getPosition());
-            mGameObjects["HITBOX_EDIT"]->setRotation(sel->getRotation());
+            mGameObjects["HITBOX_EDIT"_id]->setPosition(sel->getPosition());
+            mGameObjects["HITBOX_EDIT"_id]->setRotation(sel->getRotation());
 
             XMFLOAT3 scale{};
             XMStoreFloat3(&scale, XMVectorMultiply(XMLoadFloat3(&sel->extents), XMVectorSet(2.0f, 2.0f, 2.0f, 2.0f)));
@@ -771,22 +808,22 @@ void Level::update(const GameTime& gt)
             switch(sel->getShape())
             {
                 case BOX_SHAPE_PROXYTYPE: 
-                    mGameObjects["HITBOX_EDIT"]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["box"].get();
+                    mGameObjects["HITBOX_EDIT"_id]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["box"_id].get();
                     
                     break;
 
                 case SPHERE_SHAPE_PROXYTYPE: 
-                    mGameObjects["HITBOX_EDIT"]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["sphere"].get();
+                    mGameObjects["HITBOX_EDIT"_id]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["sphere"_id].get();
                     XMStoreFloat3(&scale, XMVectorSwizzle<XM_SWIZZLE_X, XM_SWIZZLE_X, XM_SWIZZLE_X, XM_SWIZZLE_X>(XMLoadFloat3(&scale)));
                     break;
 
                 case CYLINDER_SHAPE_PROXYTYPE:
-                    mGameObjects["HITBOX_EDIT"]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["cylinder"].get();
+                    mGameObjects["HITBOX_EDIT"_id]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["cylinder"_id].get();
                     XMStoreFloat3(&scale, XMVectorSwizzle<XM_SWIZZLE_X, XM_SWIZZLE_Y, XM_SWIZZLE_X, XM_SWIZZLE_X>(XMLoadFloat3(&scale)));
                     break;
 
                 case CAPSULE_SHAPE_PROXYTYPE: 
-                    mGameObjects["HITBOX_EDIT"]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["cylinder"].get();
+                    mGameObjects["HITBOX_EDIT"_id]->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["cylinder"_id].get();
                     XMStoreFloat3(&scale, XMVectorSwizzle<XM_SWIZZLE_X, XM_SWIZZLE_Y, XM_SWIZZLE_X, XM_SWIZZLE_X>(XMLoadFloat3(&scale)));
                     break;
 
@@ -795,38 +832,14 @@ void Level::update(const GameTime& gt)
             }
 
 
-            mGameObjects["HITBOX_EDIT"]->setScale(scale);
+            mGameObjects["HITBOX_EDIT"_id]->setScale(scale);
 
         }
         else
         {
-            mGameObjects["HITBOX_EDIT"]->isDrawEnabled = false;
+            mGameObjects["HITBOX_EDIT"_id]->isDrawEnabled = false;
         }
     }
-    else
-    {
-        std::sort(mLightObjects.begin() + AMOUNT_DIRECTIONAL,
-                  mLightObjects.end() - AMOUNT_SPOT,
-                  [&](const std::unique_ptr<LightObject>& a, const std::unique_ptr<LightObject>& b)
-                  {
-                      XMVECTOR lengthA = XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&a->getPosition()), cameraPos));
-                      XMVECTOR lengthB = XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&b->getPosition()), cameraPos));
-
-                      XMFLOAT3 t{}, s{};
-                      XMStoreFloat3(&t, lengthA);
-                      XMStoreFloat3(&s, lengthB);
-
-                      return t.x < s.x;
-                  });
-    }
-
-
-
-    for (UINT i = 3; i < (MAX_LIGHTS - 1); i++)
-    {
-        if (i < mLightObjects.size() - 1)
-            mCurrentLightObjects[i] = mLightObjects[i].get();
-    }
 
     /*water*/
     for (auto& w : mWater)
@@ -863,45 +876,14 @@ void Level::draw()
 
     /*sort the transparent objects by distance from camera*/
     const auto aCamera = ServiceProvider::getActiveCamera();
-    const auto cameraPos = aCamera->getPosition();
-
-    std::sort(std::begin(renderOrder[(int)RenderType::DefaultTransparency]),
-              std::end(renderOrder[(int)RenderType::DefaultTransparency]),
-              [&](const GameObject* a, const GameObject* b)
-              {
-                  const auto posA = a->getPosition();
-                  const auto posB = b->getPosition();
-                  XMVECTOR lengthA = XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&posA), cameraPos));
-                  XMVECTOR lengthB = XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&posB), cameraPos));
 
-                  XMFLOAT3 t{}, s{};
-                  XMStoreFloat3(&t, lengthA);
-                  XMStoreFloat3(&s, lengthB);
-
-                  return t.x > s.x;
-              });
+    transparencySorter.sort(renderOrder[(int)RenderType::DefaultTransparency], aCamera->getPosition());
 
     // draw the gameobjects
-    UINT objectsDrawn = 0;
-
-
-    for (UINT i = 0; i < renderOrder.size(); i++)
-    {
-        if (renderOrder[i].empty())continue;
-        if (i == (UINT)RenderType::Terrain) continue;
-
-        /*set PSO*/
+    buildDrawPackets();
+    submitDrawPackets();
 
-        renderResource->setPSO(RenderType(i));
-
-        for (const auto& gameObject : renderOrder[i])
-        {
-            objectsDrawn += gameObject->draw();
-        }
-
-    }
-
-    ServiceProvider::getDebugInfo()->DrawnGameObjects = objectsDrawn + 1;
+    ServiceProvider::getDebugInfo()->DrawnGameObjects = (int)packetObjects.size() + 1;
 
     /* Draw the hitboxes of the GameObjects if enabled */
     if (renderResource->isHitBoxDrawEnabled())
@@ -931,6 +913,126 @@ void Level::draw()
 
 }
 
+void Level::buildDrawPackets()
+{
+    drawPackets.clear();
+    packetObjects.clear();
+
+    const XMVECTOR cameraPos = ServiceProvider::getActiveCamera()->getPosition();
+
+    for (UINT i = 0; i < renderOrder.size(); i++)
+    {
+        if (renderOrder[i].empty()) continue;
+        if (i == (UINT)RenderType::Terrain) continue;
+
+        /*blended render types keep the order of the render order list*/
+        const bool keepOrder = i > (UINT)RenderType::Outline;
+
+        for (UINT order = 0; order < renderOrder[i].size(); order++)
+        {
+            const auto gameObject = renderOrder[i][order];
+
+            if (!gameObject->isVisible()) continue;
+
+            const UINT objectIndex = (UINT)packetObjects.size();
+            packetObjects.push_back(gameObject);
+
+            const auto rItem = gameObject->renderItem.get();
+            const auto& meshes = rItem->getModel()->meshes;
+
+            const auto pos = gameObject->getPosition();
+            const float depth = keepOrder ? 0.0f : XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&pos), cameraPos)));
+
+            for (UINT m = 0; m < meshes.size(); m++)
+            {
+                if (keepOrder)
+                {
+                    drawPackets.add(DrawPacketBuilder::makeOrderedKey(i, order, m), objectIndex, m);
+                }
+                else
+                {
+                    const UINT material = rItem->MaterialOverwrite != nullptr ? rItem->MaterialOverwrite->MatCBIndex : meshes[m]->material->MatCBIndex;
+                    drawPackets.add(DrawPacketBuilder::makeOpaqueKey(i, meshes[m]->DrawId, material, depth), objectIndex, m);
+                }
+            }
+        }
+    }
+
+    drawPackets.sort();
+}
+
+void Level::submitDrawPackets()
+{
+    auto renderResource = ServiceProvider::getRenderResource();
+    auto cmdList = renderResource->cmdList;
+    const auto frameResource = renderResource->getCurrentFrameResource();
+
+    const D3D12_GPU_VIRTUAL_ADDRESS objectCBBase = frameResource->ObjectCB->getResource()->GetGPUVirtualAddress();
+    const D3D12_GPU_VIRTUAL_ADDRESS skinnedCBBase = frameResource->SkinnedCB->getResource()->GetGPUVirtualAddress();
+    const UINT objectCBSize = d3dUtil::CalcConstantBufferSize(sizeof(ObjectConstants));
+    const UINT skinnedCBSize = d3dUtil::CalcConstantBufferSize(sizeof(SkinnedConstants));
+
+    /*currently bound state, only changes are sent to the command list*/
+    UINT currentPSO = UINT_MAX;
+    const Mesh* currentMesh = nullptr;
+    D3D_PRIMITIVE_TOPOLOGY currentTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    D3D12_GPU_VIRTUAL_ADDRESS currentObjCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS currentSkinnedCB = 0;
+
+    for (const auto& packet : drawPackets.getPackets())
+    {
+        const auto rItem = packetObjects[packet.object]->renderItem.get();
+        const Mesh* mesh = rItem->getModel()->meshes[packet.mesh].get();
+
+        const UINT pso = DrawPacketBuilder::getPSO(packet.sortKey);
+
+        if (pso != currentPSO)
+        {
+            renderResource->setPSO(RenderType(pso));
+            currentPSO = pso;
+        }
+
+        if (mesh != currentMesh)
+        {
+            const auto vbv = mesh->VertexBufferView();
+            const auto ibv = mesh->IndexBufferView();
+            cmdList->IASetVertexBuffers(0, 1, &vbv);
+            cmdList->IASetIndexBuffer(&ibv);
+            currentMesh = mesh;
+        }
+
+        if (rItem->PrimitiveType != currentTopology)
+        {
+            cmdList->IASetPrimitiveTopology(rItem->PrimitiveType);
+            currentTopology = rItem->PrimitiveType;
+        }
+
+        const D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCBBase + (long long)rItem->ObjCBIndex[packet.mesh] * objectCBSize;
+
+        if (objCBAddress != currentObjCB)
+        {
+            cmdList->SetGraphicsRootConstantBufferView(0, objCBAddress);
+            currentObjCB = objCBAddress;
+        }
+
+        if (rItem->isSkinned())
+        {
+            const D3D12_GPU_VIRTUAL_ADDRESS skinnedCBAddress = skinnedCBBase + (long long)rItem->SkinnedCBIndex * skinnedCBSize;
+
+            if (skinnedCBAddress != currentSkinnedCB)
+            {
+                cmdList->SetGraphicsRootConstantBufferView(6, skinnedCBAddress);
+                currentSkinnedCB = skinnedCBAddress;
+            }
+        }
+
+        /*one draw per packet, the object constants are a root cbv per draw.
+        runs with the same pso, mesh and material (key >> 16 of opaque keys) could become one instanced draw
+        once the shaders read the object constants from a per instance buffer, see drawpacketbenchmark for the saved draws*/
+        cmdList->DrawIndexedInstanced(mesh->IndexCount, 1, 0, 0, 0);
+    }
+}
+
 bool Level::save()
 {
     auto startTime = std::chrono::system_clock::now();
@@ -1306,23 +1408,197 @@ void Level::drawShadow()
 
     UINT objectsDrawn = 0;
 
-    /*draw shadows*/
-    for (UINT i = 0; i < shadowRenderOrder.size(); i++)
+    /*draw shadows, casters were collected in update()*/
+    for (UINT i = 0; i < shadowCasters.size(); i++)
     {
-        if (shadowRenderOrder[i].empty()) continue;
+        if (shadowCasters[i].empty()) continue;
 
         renderResource->setPSO(ShadowRenderType((int)ShadowRenderType::ShadowDefault + i));
 
-        for (const auto& gameObject : shadowRenderOrder[i])
+        for (const auto& gameObject : shadowCasters[i])
+        {
+            objectsDrawn += gameObject->drawShadow();
+        }
+    }
+
+    ServiceProvider::getDebugInfo()->DrawnShadowObjects = objectsDrawn + 1;
+}
+
+void Level::updateLightClusters(Camera* camera)
+{
+    /*bounds of all point and spot lights, directional lights are not clustered*/
+    clusterLights.clear();
+
+    for (size_t i = AMOUNT_DIRECTIONAL; i < mLightObjects.size(); i++)
+    {
+        LightObject& light = *mLightObjects[i];
+        ClusterLight bounds;
+
+        bounds.position = light.getPosition();
+        bounds.range = light.getFallOffEnd();
+
+        if (light.getLightType() == LightType::Spot)
+        {
+            XMStoreFloat3(&bounds.direction, XMVector3Normalize(XMLoadFloat3(&light.getDirection())));
+            bounds.cosCone = ClusterLight::spotCone(light.getSpotPower());
+        }
+
+        clusterLights.push_back(bounds);
+    }
+
+    lightClusters.build(camera->getFovY(), camera->getAspect(), lightClusterNear, (std::min)(camera->getFarZ(), lightClusterFar));
+    lightClusters.assign(clusterLights.data(), (UINT)clusterLights.size(), camera->getView());
+
+    /*until the shaders read the cluster lists the pass constants only have room for a few lights, take the closest visible ones.
+    point lights are stored before the spot lights*/
+    constexpr UINT pointSlots = MAX_LIGHTS - AMOUNT_DIRECTIONAL - AMOUNT_SPOT;
+    const UINT pointLightCount = (UINT)(mLightObjects.size() - AMOUNT_DIRECTIONAL - AMOUNT_SPOT);
+    const XMVECTOR eye = camera->getPosition();
+
+    lightClusters.selectNearest(clusterLights.data(), eye, 0, pointLightCount, pointSlots, slotLights);
+
+    for (UINT i = 0; i < pointSlots; i++)
+    {
+        mCurrentLightObjects[(size_t)AMOUNT_DIRECTIONAL + i] = i < slotLights.size() ? mLightObjects[(size_t)slotLights[i] + AMOUNT_DIRECTIONAL].get() : nullptr;
+    }
+
+    lightClusters.selectNearest(clusterLights.data(), eye, pointLightCount, (UINT)clusterLights.size(), AMOUNT_SPOT, slotLights);
+
+    for (UINT i = 0; i < (UINT)AMOUNT_SPOT; i++)
+    {
+        mCurrentLightObjects[(size_t)AMOUNT_DIRECTIONAL + pointSlots + i] = i < slotLights.size() ? mLightObjects[(size_t)slotLights[i] + AMOUNT_DIRECTIONAL].get() : nullptr;
+    }
+}
+
+void Level::cullByPVS(Camera* camera)
+{
+    if (!mazePVS.isReady()) return;
+
+    const XMFLOAT3 camPos = camera->getPosition3f();
+    const BoundingBox& wallBox = mazeWalls[0]->getCollider().getFrustumBox();
+
+    /*the sets only know what is visible between the walls, a camera above them sees everything*/
+    if (camPos.y > wallBox.Center.y + wallBox.Extents.y) return;
+
+    const float baseX = -mazeBaseWidth * mazePVS.columns() / 2.0f;
+    const float baseZ = mazeBaseWidth * mazePVS.rows() / 2.0f;
+
+    auto cellX = [&](float x) { return (int)std::floor((x - baseX) / mazeBaseWidth); };
+    auto cellY = [&](float z) { return (int)std::floor((baseZ - z) / mazeBaseWidth); };
+
+    if (!mazePVS.selectCell(cellX(camPos.x), cellY(camPos.z))) return;
+
+    for (const auto& gO : frustumObjects)
+    {
+        if (!gO->getIsInFrustum() || !gO->isFrustumCulled) continue;
+
+        const BoundingBox& box = gO->getCollider().getFrustumBox();
+
+        const int x0 = cellX(box.Center.x - box.Extents.x);
+        const int x1 = cellX(box.Center.x + box.Extents.x);
+        const int y0 = cellY(box.Center.z + box.Extents.z);
+        const int y1 = cellY(box.Center.z - box.Extents.z);
+
+        /*objects reaching out of the maze are left to the occlusion culling*/
+        if (x0 < 0 || y0 < 0 || x1 >= mazePVS.columns() || y1 >= mazePVS.rows()) continue;
+
+        bool visible = false;
+
+        for (int y = y0; y <= y1 && !visible; y++)
         {
-            if (gameObject->currentlyInShadowSphere)
+            for (int x = x0; x <= x1 && !visible; x++)
             {
-                objectsDrawn += gameObject->drawShadow();
+                visible = mazePVS.isVisible(x, y);
             }
         }
+
+        if (!visible)
+        {
+            gO->setInViewFrustum(false);
+        }
     }
+}
 
-    ServiceProvider::getDebugInfo()->DrawnShadowObjects = objectsDrawn + 1;
+void Level::cullOccluded(Camera* camera)
+{
+    occlusionCuller.begin(XMMatrixMultiply(camera->getView(), camera->getProj()));
+
+    /*open walls are not drawn, walls outside of the frustum can not hide anything*/
+    for (const auto& w : mazeWalls)
+    {
+        if (w->isDrawEnabled && w->getIsInFrustum())
+        {
+            occlusionCuller.addWallOccluder(w->getCollider().getFrustumBox());
+        }
+    }
+
+    if (terrainOccluders.empty())
+    {
+        buildTerrainOccluders();
+    }
+
+    for (const auto& q : terrainOccluders)
+    {
+        occlusionCuller.addOccluder(q.data());
+    }
+
+    auto jobs = ServiceProvider::getJobSystem();
+
+    occlusionCuller.rasterize(jobs);
+
+    jobs->parallelFor((UINT)frustumObjects.size(), 64, [&](UINT first, UINT last)
+    {
+        for (UINT i = first; i < last; i++)
+        {
+            GameObject* gO = frustumObjects[i];
+
+            if (gO->getIsInFrustum() && gO->isFrustumCulled &&
+                !occlusionCuller.isVisible(gO->getCollider().getFrustumBox()))
+            {
+                gO->setInViewFrustum(false);
+            }
+        }
+    });
+}
+
+void Level::buildTerrainOccluders()
+{
+    terrainOccluders.clear();
+
+    const float size = mTerrain->terrainSize;
+    const float cellSize = size / terrainOccluderGrid;
+    const int verticesPerCell = (int)std::ceil(cellSize / mTerrain->cellSpacing);
+
+    for (int cz = 0; cz < terrainOccluderGrid; cz++)
+    {
+        for (int cx = 0; cx < terrainOccluderGrid; cx++)
+        {
+            const float x0 = -size / 2.0f + cx * cellSize;
+            const float z0 = -size / 2.0f + cz * cellSize;
+
+            /*the terrain is linear between the height map vertices, so the lowest vertex is the lowest point*/
+            float minHeight = MathHelper::Infinity;
+
+            for (int vz = 0; vz <= verticesPerCell; vz++)
+            {
+                for (int vx = 0; vx <= verticesPerCell; vx++)
+                {
+                    /*getHeight() returns 0 outside of the terrain, stay inside at the borders*/
+                    const float x = std::clamp((std::min)(x0 + vx * mTerrain->cellSpacing, x0 + cellSize), -size / 2.0f + 0.01f, size / 2.0f - 0.01f);
+                    const float z = std::clamp((std::min)(z0 + vz * mTerrain->cellSpacing, z0 + cellSize), -size / 2.0f + 0.01f, size / 2.0f - 0.01f);
+
+                    minHeight = (std::min)(minHeight, mTerrain->getHeight(x, z));
+                }
+            }
+
+            minHeight -= 0.1f;
+
+            terrainOccluders.push_back({ XMFLOAT3(x0, minHeight, z0),
+                                         XMFLOAT3(x0 + cellSize, minHeight, z0),
+                                         XMFLOAT3(x0 + cellSize, minHeight, z0 + cellSize),
+                                         XMFLOAT3(x0, minHeight, z0 + cellSize) });
+        }
+    }
 }
 
 bool Level::existsLightByName(const std::string& name)
@@ -1351,6 +1627,8 @@ void Level::calculateRenderOrderSizes()
         shadowRenderOrderSize[(int)gameOject.second->renderItem->shadowType]++;
     }
 
+    buildUpdateLists();
+
     for (int i = 0; i < renderOrderSize.size(); i++)
     {
         renderOrder.push_back(std::vector<GameObject*>(renderOrderSize[i]));
@@ -1361,6 +1639,11 @@ void Level::calculateRenderOrderSizes()
         shadowRenderOrder.push_back(std::vector<GameObject*>(shadowRenderOrderSize[i]));
     }
 
+    shadowCasterCache.dirty = true;
+
+    /*new or changed objects have to be uploaded*/
+    ServiceProvider::getRenderResource()->markAllDirty();
+
     calculateRenderOrder();
     calculateShadowRenderOrder();
 }
@@ -1372,6 +1655,7 @@ void Level::addGameObject(json goJson)
 
     /*put in quadtree and recalculate render orders*/
     addGameObjectToQuadTree(mGameObjects[goJson["Name"]].get());
+    quadTree.pack();
     calculateRenderOrderSizes();
 }
 
@@ -1379,17 +1663,106 @@ void Level::addGameObjectToQuadTree(GameObject* go)
 {
     if (go->gameObjectType == ObjectType::Sky ||
         go->gameObjectType == ObjectType::Debug ||
-        go->gameObjectType == ObjectType::Terrain ||
-        go->motionType != ObjectMotionType::Static) return; // dont add non static game objects to the tree
+        go->gameObjectType == ObjectType::Terrain)
+    {
+        untrackedObjects.push_back(go);
+        return;
+    }
+
+    /*all other objects are kept in the culling tree, transform changes are reported by markMoved()*/
+    go->cullingHandle = cullingTree.insert(go, go->getCollider().getFrustumBox());
+    go->pickHandle = pickTree.insert(go, go->getCollider().getPickBox());
 
-    if (!quadTree.insert(go))
+    if (go->motionType != ObjectMotionType::Static) return; // dont add non static game objects to the static tree
+
+    /*static objects are only moved by game logic and the editor, their transform changes are batched*/
+    go->transformSystem = &transformSystem;
+    go->transformHandle = transformSystem.add(go);
+
+    if (!quadTree.insert(go, go->getCollider().getFrustumBox()))
     {
         LOG(Severity::Debug, "GameObject " << go->Name << " not quad tree insertable!");
+        unindexedObjects.push_back(go);
     }
 
 }
 
 
+void Level::markMoved(GameObject* go)
+{
+    if (go->cullingQueued || go->cullingHandle == LooseQuadTree::INVALID_HANDLE) return;
+
+    go->cullingQueued = true;
+
+    /*objects can be moved from update jobs*/
+    std::lock_guard<std::mutex> lock(movedLock);
+    movedObjects.push_back(go);
+}
+
+void Level::applyMovedObjects()
+{
+    bool staticTreeChanged = false;
+
+    for (auto& gO : movedObjects)
+    {
+        cullingTree.update(gO->cullingHandle, gO->getCollider().getFrustumBox());
+        pickTree.update(gO->pickHandle, gO->getCollider().getPickBox());
+        gO->cullingQueued = false;
+
+        /*static objects moved by game logic or the editor (e.g. coins) would keep their old quad tree leaves,
+        they are checked with the dynamic shadow casters from now on*/
+        if (gO->motionType == ObjectMotionType::Static &&
+            std::find(unindexedObjects.begin(), unindexedObjects.end(), gO) == unindexedObjects.end() &&
+            quadTree.remove(gO))
+        {
+            unindexedObjects.push_back(gO);
+
+            if (!gO->isShadowForced)
+            {
+                dynamicShadowCasters.push_back(gO);
+            }
+
+            staticTreeChanged = true;
+        }
+    }
+
+    movedObjects.clear();
+
+    if (staticTreeChanged)
+    {
+        quadTree.pack();
+        shadowCasterCache.dirty = true;
+    }
+}
+
+GameObject* Level::pickGameObject(FXMVECTOR origin, FXMVECTOR direction, float& dist)
+{
+    /*edits of this frame are not applied yet*/
+    applyMovedObjects();
+
+    return pickTree.intersect(origin, direction, dist);
+}
+
+void Level::buildUpdateLists()
+{
+    updateObjects.clear();
+    scriptedObjects.clear();
+
+    for (const auto& gameObj : mGameObjects)
+    {
+        GameObject* gO = gameObj.second.get();
+
+        updateObjects.push_back(gO);
+
+        if (gameObj.first.rfind("ENDG", 0) == 0 ||
+            gameObj.first.rfind("&COIN", 0) == 0 ||
+            gameObj.first.rfind("BANNER", 0) == 0)
+        {
+            scriptedObjects.push_back(gO);
+        }
+    }
+}
+
 void Level::calculateRenderOrder()
 {
     /* Order of render items*/
@@ -1398,6 +1771,8 @@ void Level::calculateRenderOrder()
         v.clear();
     }
 
+    transparencySorter.invalidate();
+
     for (const auto& gameObject : mGameObjects)
     {
         renderOrder[(int)gameObject.second->renderItem->renderType].push_back(&(*gameObject.second));
@@ -1412,6 +1787,8 @@ void Level::calculateShadowRenderOrder()
         v.clear();
     }
 
+    dynamicShadowCasters.clear();
+
     for (const auto& gameObject : mGameObjects)
     {
         if (gameObject.second->renderItem->renderType == RenderType::Sky ||
@@ -1419,7 +1796,153 @@ void Level::calculateShadowRenderOrder()
             gameObject.second->renderItem->renderType == RenderType::Terrain) continue;
 
         shadowRenderOrder[(long long)gameObject.second->renderItem->shadowType].push_back(&(*gameObject.second));
+
+        /*everything the quadtree can not answer for is checked every frame*/
+        if (gameObject.second->motionType != ObjectMotionType::Static ||
+            gameObject.second->isShadowForced)
+        {
+            dynamicShadowCasters.push_back(gameObject.second.get());
+        }
+    }
+
+    for (const auto& gO : unindexedObjects)
+    {
+        if (!gO->isShadowForced)
+        {
+            dynamicShadowCasters.push_back(gO);
+        }
+    }
+}
+
+void Level::buildShadowCasters(bool fullScan)
+{
+    shadowCasters.resize((int)ShadowRenderType::COUNT);
+
+    for (auto& v : shadowCasters)
+    {
+        v.clear();
+    }
+
+    /*nothing to collect before the first shadow transform*/
+    const XMFLOAT4X4* shadowViewProj = ServiceProvider::getRenderResource()->getShadowViewProj();
+
+    if (!shadowViewProj) return;
+
+    const XMMATRIX viewProj = XMLoadFloat4x4(shadowViewProj);
+    auto& cache = shadowCasterCache;
+
+    /*center of the light volume and the distance to its corners*/
+    XMVECTOR det;
+    const XMMATRIX invViewProj = XMMatrixInverse(&det, viewProj);
+    const XMVECTOR center = XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.5f, 1.0f), invViewProj);
+    const float radius = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMVector3TransformCoord(XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f), invViewProj), center)));
+
+    FrustumPlanes planes(viewProj);
+
+    /*direction of the near plane*/
+    const XMVECTOR direction = XMVector3Normalize(planes.planes[4]);
+
+    /*the light matrices are from the last frame, cover about as much as the volume moved in the last frame.
+    a turn of the light moves the corners by up to radius * |change of the direction|*/
+    float lagMargin = 0.0f;
+
+    if (cache.hasFrame)
+    {
+        const float moved = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, XMLoadFloat3(&cache.frameCenter))));
+        const float turned = XMVectorGetX(XMVector3Length(XMVectorSubtract(direction, XMLoadFloat3(&cache.frameDirection))));
+
+        lagMargin = shadowCasterLagScale * (moved + radius * turned);
     }
+
+    XMStoreFloat3(&cache.frameCenter, center);
+    XMStoreFloat3(&cache.frameDirection, direction);
+    cache.hasFrame = true;
+
+    planes.expand(lagMargin);
+
+    shadowCandidates.clear();
+
+    /*objects can be moved out of their quadtree cell in the editor, check all of them*/
+    if (fullScan)
+    {
+        cache.dirty = true;
+
+        for (const auto& v : shadowRenderOrder)
+        {
+            shadowCandidates.insert(shadowCandidates.end(), v.begin(), v.end());
+        }
+    }
+    else
+    {
+        const float moved = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, XMLoadFloat3(&cache.center))));
+        const float turned = XMVectorGetX(XMVector3Length(XMVectorSubtract(direction, XMLoadFloat3(&cache.lightDirection))));
+
+        /*the cached casters stay valid as long as no point of the volume, including the lag margin, moved farther than the rebuild distance*/
+        if (cache.dirty || moved + radius * turned + lagMargin > shadowCasterRebuildDistance)
+        {
+            buildStaticShadowCasters(planes);
+            XMStoreFloat3(&cache.center, center);
+            XMStoreFloat3(&cache.lightDirection, direction);
+        }
+
+        shadowCandidates.insert(shadowCandidates.end(), cache.staticCasters.begin(), cache.staticCasters.end());
+        shadowCandidates.insert(shadowCandidates.end(), dynamicShadowCasters.begin(), dynamicShadowCasters.end());
+    }
+
+    /*candidates are tested against the light volume in one batch*/
+    shadowCuller.clear();
+
+    for (const auto& gO : shadowCandidates)
+    {
+        shadowCuller.add(gO->getCollider().getFrustumBox());
+    }
+
+    shadowCuller.cull(planes);
+
+    for (UINT i = 0; i < (UINT)shadowCandidates.size(); i++)
+    {
+        GameObject* gO = shadowCandidates[i];
+
+        if (gO->isShadowForced || shadowCuller.isVisible(i))
+        {
+            gO->currentlyInLightVolume = true;
+            shadowCasters[(int)gO->renderItem->shadowType].push_back(gO);
+        }
+    }
+}
+
+void Level::buildStaticShadowCasters(const FrustumPlanes& planes)
+{
+    auto& cache = shadowCasterCache;
+    std::vector<UINT> shadowLeaves;
+
+    /*enlarge the light volume so the list stays valid while it moves less than the rebuild distance*/
+    FrustumPlanes cachePlanes = planes;
+    cachePlanes.expand(shadowCasterRebuildDistance);
+
+    quadTree.searchCollision(cachePlanes, shadowLeaves);
+
+    cache.staticCasters.clear();
+
+    for (const auto& n : shadowLeaves)
+    {
+        for (const auto& gO : quadTree.getLeafObjects(n))
+        {
+            /*forced casters are already part of the dynamic casters*/
+            if (!gO->isShadowEnabled || gO->isShadowForced) continue;
+
+            if (cachePlanes.classify(gO->getCollider().getFrustumBox()) != DISJOINT)
+            {
+                cache.staticCasters.push_back(gO);
+            }
+        }
+    }
+
+    /*objects can be stored in multiple nodes*/
+    std::sort(cache.staticCasters.begin(), cache.staticCasters.end());
+    cache.staticCasters.erase(std::unique(cache.staticCasters.begin(), cache.staticCasters.end()), cache.staticCasters.end());
+
+    cache.dirty = false;
 }
 
 bool Level::existsList(const nlohmann::json& j, const std::vector<std::string>& key)
@@ -1453,7 +1976,7 @@ bool Level::parseSky(const json& skyJson)
     rItem->TexTransform = MathHelper::identity4x4();
     rItem->ObjCBIndex.push_back(amountObjectCBs++);
     rItem->MaterialOverwrite = renderResource->mMaterials[skyJson["Material"]].get();
-    rItem->staticModel = renderResource->mModels["sphere"].get();
+    rItem->staticModel = renderResource->mModels["sphere"_id].get();
     rItem->renderType = RenderType::Sky;
 
     gameObject->Name = "SKY_SPHERE";
@@ -1600,7 +2123,7 @@ bool Level::parseGameObjects(const json& gameObjectJson)
     debugObject->renderItem->renderType = RenderType::Default;
     debugObject->gameObjectType = ObjectType::Debug;
     debugObject->isCollisionEnabled = false;
-    debugObject->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["quad"].get();
+    debugObject->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["quad"_id].get();
 
     mGameObjects["debugQuad"] = std::move(debugObject);
 
@@ -1628,7 +2151,7 @@ bool Level::parseTerrain(const json& terrainJson)
     terrainObject->renderItem->renderType = RenderType::Terrain;
     terrainObject->gameObjectType = ObjectType::Terrain;
     terrainObject->renderItem->staticModel = mTerrain->terrainModel.get();
-    terrainObject->renderItem->MaterialOverwrite = ServiceProvider::getRenderResource()->mMaterials["terrain"].get();
+    terrainObject->renderItem->MaterialOverwrite = ServiceProvider::getRenderResource()->mMaterials["terrain"_id].get();
     XMStoreFloat4x4(&terrainObject->renderItem->TexTransform, XMMatrixScaling((float)mTerrain->terrainSlices / 4.0f,
                     (float)mTerrain->terrainSlices / 4.0f, (float)mTerrain->terrainSlices / 4.0f));
 
@@ -1732,7 +2255,7 @@ bool Level::parseWater(const json& waterJson)
         waterObject->isFrustumCulled = true;
         waterObject->gameObjectType = ObjectType::Water;
 
-        waterObject->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["watergrid"].get();
+        waterObject->renderItem->staticModel = ServiceProvider::getRenderResource()->mModels["watergrid"_id].get();
         waterObject->renderItem->MaterialOverwrite = ServiceProvider::getRenderResource()->mMaterials[entry["Material"]].get();
         waterObject->renderItem->renderType = RenderType::Water;
         waterObject->renderItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST;
@@ -1747,7 +2270,7 @@ bool Level::parseWater(const json& waterJson)
         waterObject->getCollider().setBaseBoxes(cBox);
         waterObject->updateTransforms();
 
-        waterObject->renderItem->NumFramesDirty = gNumFrameResources;
+        ServiceProvider::getRenderResource()->markDirty(waterObject->renderItem.get());
         mGameObjects[waterObject->Name] = std::move(waterObject);
 
         /*create water material updater if needed*/
@@ -8,7 +8,17 @@
 #include "../core/grass.h"
 #include "../core/particlesystem.h"
 #include "../util/quadtree.h"
+#include "../util/loosequadtree.h"
+#include "../util/pickbvh.h"
+#include "../util/frustumculling.h"
+#include "../util/occlusionculler.h"
+#include "../util/jobsystem.h"
+#include "../core/transformsystem.h"
+#include "../render/lightclusters.h"
+#include "../render/depthsort.h"
+#include "../render/drawpacket.h"
 #include "../maze/maze.h"
+#include "../maze/mazepvs.h"
 
 
 inline const std::string LEVEL_PATH = "data/level";
@@ -80,14 +90,38 @@ public:
     /*exists light name*/
     bool existsLightByName(const std::string& name);
 
+    /*per cluster light lists of the current frame, indices are mLightObjects indices minus AMOUNT_DIRECTIONAL*/
+    const LightClusters& getLightClusters() const
+    {
+        return lightClusters;
+    }
+
     /*need to call this if new object is added or render type is changed*/
     void calculateRenderOrderSizes();
 
     void addGameObject(json goJson);
 
+    /*queues an object whose transform changed, its culling tree node is updated in the next update()*/
+    void markMoved(GameObject* go);
+
+    /*
+    ray picking for the editor, sky, terrain, debug and not selectable objects are ignored
+    @param ray origin
+    @param normalized ray direction
+    @param distance to the hit is stored here
+    @returns closest hit object or nullptr
+    */
+    GameObject* pickGameObject(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float& dist);
+
+    /*all pickable objects ordered by their pick handle*/
+    const std::vector<GameObject*>& getPickableObjects() const
+    {
+        return pickTree.getObjects();
+    }
+
     std::unique_ptr<Terrain> mTerrain;
 
-    std::unordered_map<std::string, std::unique_ptr<GameObject>> mGameObjects;
+    IdMap<GameObject> mGameObjects;
     std::unordered_map<std::string, PhyRestore> mPhyRestore;
 
     std::array<LightObject*, MAX_LIGHTS> mCurrentLightObjects;
@@ -114,6 +148,87 @@ private:
     QuadTree quadTree;
     void addGameObjectToQuadTree(GameObject* go);
 
+    /*static objects that did not fit into the quad tree or were moved after loading, they are checked as dynamic shadow casters*/
+    std::vector<GameObject*> unindexedObjects;
+
+    /*camera culling for all objects including moving ones, sky, terrain and debug objects are not stored*/
+    LooseQuadTree cullingTree;
+    std::vector<GameObject*> movedObjects;
+    std::vector<GameObject*> untrackedObjects;
+    std::vector<GameObject*> frustumObjects;
+    BoxCuller frustumCuller;
+    std::mutex movedLock;
+
+    /*moves the queued objects to their new culling tree node and pick box, moved static objects leave the static quad tree*/
+    void applyMovedObjects();
+
+    /*pick boxes of the same objects as in the culling tree*/
+    PickBVH pickTree;
+
+    /*deferred transforms of the static objects, flushed before the culling trees are updated and after the game logic*/
+    TransformSystem transformSystem;
+
+    /*hides objects in maze cells that can not be seen from the cell of the camera*/
+    void cullByPVS(Camera* camera);
+
+    /*cell to cell visibility of the current maze, rebuilt in the background by updateToGrid()*/
+    MazePVS mazePVS;
+
+    /*hides objects in the camera frustum that are behind closed maze walls or the terrain*/
+    void cullOccluded(Camera* camera);
+    void buildTerrainOccluders();
+
+    OcclusionCuller occlusionCuller;
+    std::vector<GameObject*> mazeWalls;
+
+    /*horizontal quads at the lowest terrain height of a coarse grid, always below the real terrain*/
+    std::vector<std::array<DirectX::XMFLOAT3, 4>> terrainOccluders;
+    const int terrainOccluderGrid = 16;
+
+    /*objects grouped by how they are updated, rebuilt with the render order sizes*/
+    void buildUpdateLists();
+
+    std::vector<GameObject*> updateObjects;
+    std::vector<GameObject*> scriptedObjects;
+
+    /*static casters inside the enlarged light volume, only rebuilt if the light turned or the volume moved too far*/
+    struct ShadowCasterCache
+    {
+        std::vector<GameObject*> staticCasters;
+        DirectX::XMFLOAT3 center = { 0.0f,0.0f,0.0f };
+        DirectX::XMFLOAT3 lightDirection = { 0.0f,0.0f,0.0f };
+        bool dirty = true;
+
+        /*light volume in the last frame, its movement and turn predict the lag of the light matrices*/
+        DirectX::XMFLOAT3 frameCenter = { 0.0f,0.0f,0.0f };
+        DirectX::XMFLOAT3 frameDirection = { 0.0f,0.0f,0.0f };
+        bool hasFrame = false;
+    };
+
+    /*collect the shadow casters of the current frame per shadow render type*/
+    void buildShadowCasters(bool fullScan);
+    void buildStaticShadowCasters(const FrustumPlanes& planes);
+
+    std::vector<std::vector<GameObject*>> shadowCasters;
+
+    ShadowCasterCache shadowCasterCache;
+    std::vector<GameObject*> dynamicShadowCasters;
+    const float shadowCasterRebuildDistance = 4.0f;
+    const float shadowCasterLagScale = 1.5f;
+
+    /*casters of the current frame before the batched test against the shadow bounds*/
+    std::vector<GameObject*> shadowCandidates;
+    BoxCuller shadowCuller;
+
+    /*clustered light assignment of all point and spot lights, fills the point and spot light slots of mCurrentLightObjects*/
+    void updateLightClusters(Camera* camera);
+
+    LightClusters lightClusters;
+    std::vector<ClusterLight> clusterLights;
+    std::vector<UINT> slotLights;
+    const float lightClusterNear = 1.0f;
+    const float lightClusterFar = 500.0f;
+
     /* total amount of object cbs used in the level*/
     int amountObjectCBs = 1;
 
@@ -130,6 +245,16 @@ private:
     void calculateShadowRenderOrder();
 
     std::vector<std::vector<GameObject*>> renderOrder;
+
+    /*keeps the transparent render order sorted back to front*/
+    DepthSorter transparencySorter;
+
+    /*sorted draw packets of all visible objects, see draw()*/
+    void buildDrawPackets();
+    void submitDrawPackets();
+
+    DrawPacketBuilder drawPackets;
+    std::vector<GameObject*> packetObjects;
     std::vector<std::vector<GameObject*>> shadowRenderOrder;
 
     const std::string prefixSouth = "&WS";
@@ -137,6 +262,12 @@ private:
     const std::string prefixNorth = "&WN";
     const std::string prefixWest = "&WW";
 
+    /*maze walls by cell index, western walls by row*/
+    std::vector<StringId> eastWallIds;
+    std::vector<StringId> southWallIds;
+    std::vector<StringId> westWallIds;
+    std::vector<StringId> coinIds;
+
     bool exists(const nlohmann::json& j, const std::string& key)
     {
         return j.find(key) != j.end();
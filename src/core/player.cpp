@@ -43,22 +43,6 @@ void Player::update(const GameTime& gt)
     // update animation for skinned objects
     if(gameObjectType == ObjectType::Skinned)
     {
-        if(renderItem->currentClip != nullptr)
-        {
-            renderItem->animationTimer += gt.DeltaTime() * animationTimeScale;
-
-            if(renderItem->animationTimer >= renderItem->currentClip->getEndTime())
-            {
-                renderItem->animationTimer = fmod(renderItem->animationTimer, renderItem->currentClip->getEndTime());
-            }
-
-            if(renderItem->animationTimer <= renderItem->currentClip->getStartTime())
-            {
-                renderItem->animationTimer = renderItem->currentClip->getEndTime() - fmod(renderItem->animationTimer, renderItem->currentClip->getEndTime());
-            }
-        }
-
-        if(currentlyInFrustum || !isFrustumCulled)
-            renderItem->skinnedModel->calculateFinalTransforms(renderItem->currentClip, renderItem->finalTransforms, renderItem->animationTimer);
+        updateAnimation(gt);
     }
 }
\ No newline at end of file
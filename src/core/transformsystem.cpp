@@ -0,0 +1,178 @@
+#include "transformsystem.h"
+#include "../core/gameobject.h"
+
+using namespace DirectX;
+
+void TransformSystem::clear()
+{
+    objects.clear();
+
+    positionX.clear(); positionY.clear(); positionZ.clear();
+    rotationX.clear(); rotationY.clear(); rotationZ.clear();
+    scaleX.clear(); scaleY.clear(); scaleZ.clear();
+
+    dirty.clear();
+    dirtyList.clear();
+}
+
+UINT TransformSystem::add(GameObject* go)
+{
+    const UINT handle = (UINT)objects.size();
+
+    objects.push_back(go);
+
+    positionX.push_back(go->Position.x); positionY.push_back(go->Position.y); positionZ.push_back(go->Position.z);
+    rotationX.push_back(go->Rotation.x); rotationY.push_back(go->Rotation.y); rotationZ.push_back(go->Rotation.z);
+    scaleX.push_back(go->Scale.x); scaleY.push_back(go->Scale.y); scaleZ.push_back(go->Scale.z);
+
+    if ((handle & 63) == 0)
+    {
+        dirty.push_back(0);
+    }
+
+    return handle;
+}
+
+void TransformSystem::setPosition(UINT handle, const DirectX::XMFLOAT3& position)
+{
+    positionX[handle] = position.x;
+    positionY[handle] = position.y;
+    positionZ[handle] = position.z;
+}
+
+void TransformSystem::setRotation(UINT handle, const DirectX::XMFLOAT3& rotation)
+{
+    rotationX[handle] = rotation.x;
+    rotationY[handle] = rotation.y;
+    rotationZ[handle] = rotation.z;
+}
+
+void TransformSystem::setScale(UINT handle, const DirectX::XMFLOAT3& scale)
+{
+    scaleX[handle] = scale.x;
+    scaleY[handle] = scale.y;
+    scaleZ[handle] = scale.z;
+}
+
+void TransformSystem::flush(JobSystem* jobs)
+{
+    dirtyList.clear();
+
+    for (UINT w = 0; w < (UINT)dirty.size(); w++)
+    {
+        std::uint64_t bits = dirty[w];
+
+        for (UINT b = 0; bits != 0; b++, bits >>= 1)
+        {
+            if (bits & 1)
+            {
+                dirtyList.push_back(w * 64 + b);
+            }
+        }
+
+        dirty[w] = 0;
+    }
+
+    if (dirtyList.empty()) return;
+
+    if (jobs)
+    {
+        jobs->parallelFor((UINT)dirtyList.size(), CHUNK_SIZE, [&](UINT first, UINT last)
+        {
+            computeRange(first, last);
+        });
+    }
+    else
+    {
+        computeRange(0, (UINT)dirtyList.size());
+    }
+
+    /*the upload and culling queues take a lock, fill them once from this thread*/
+    for (const auto& handle : dirtyList)
+    {
+        objects[handle]->markTransformChanged();
+    }
+}
+
+void TransformSystem::computeRange(UINT first, UINT last)
+{
+    for (UINT i = first; i < last; i += 4)
+    {
+        /*gather 4 objects, missing lanes repeat the first one and are not stored*/
+        UINT h[4];
+
+        for (UINT lane = 0; lane < 4; lane++)
+        {
+            h[lane] = dirtyList[i + lane < last ? i + lane : i];
+        }
+
+        const auto gather = [&h](const std::vector<float>& v)
+        {
+            return XMVectorSet(v[h[0]], v[h[1]], v[h[2]], v[h[3]]);
+        };
+
+        XMVECTOR sinPitch, cosPitch, sinYaw, cosYaw, sinRoll, cosRoll;
+        XMVectorSinCos(&sinPitch, &cosPitch, gather(rotationX));
+        XMVectorSinCos(&sinYaw, &cosYaw, gather(rotationY));
+        XMVectorSinCos(&sinRoll, &cosRoll, gather(rotationZ));
+
+        /*rows of XMMatrixRotationRollPitchYaw for all 4 objects*/
+        const XMVECTOR sinRollSinPitch = XMVectorMultiply(sinRoll, sinPitch);
+        const XMVECTOR cosRollSinPitch = XMVectorMultiply(cosRoll, sinPitch);
+
+        XMMATRIX rotation;
+        rotation.r[0] = XMVectorMultiplyAdd(sinRollSinPitch, sinYaw, XMVectorMultiply(cosRoll, cosYaw));
+        rotation.r[1] = XMVectorMultiply(sinRoll, cosPitch);
+        rotation.r[2] = XMVectorNegativeMultiplySubtract(cosRoll, sinYaw, XMVectorMultiply(sinRollSinPitch, cosYaw));
+        rotation.r[3] = XMVectorZero();
+        const XMMATRIX row0 = XMMatrixTranspose(rotation);
+
+        rotation.r[0] = XMVectorNegativeMultiplySubtract(sinRoll, cosYaw, XMVectorMultiply(cosRollSinPitch, sinYaw));
+        rotation.r[1] = XMVectorMultiply(cosRoll, cosPitch);
+        rotation.r[2] = XMVectorMultiplyAdd(cosRollSinPitch, cosYaw, XMVectorMultiply(sinRoll, sinYaw));
+        const XMMATRIX row1 = XMMatrixTranspose(rotation);
+
+        rotation.r[0] = XMVectorMultiply(cosPitch, sinYaw);
+        rotation.r[1] = XMVectorNegate(sinPitch);
+        rotation.r[2] = XMVectorMultiply(cosPitch, cosYaw);
+        const XMMATRIX row2 = XMMatrixTranspose(rotation);
+
+        XMMATRIX translation;
+        translation.r[0] = gather(positionX);
+        translation.r[1] = gather(positionY);
+        translation.r[2] = gather(positionZ);
+        translation.r[3] = XMVectorSplatOne();
+        translation = XMMatrixTranspose(translation);
+
+        const XMMATRIX scale = XMMatrixTranspose(XMMATRIX(gather(scaleX), gather(scaleY), gather(scaleZ), XMVectorZero()));
+
+        for (UINT lane = 0; lane < 4 && i + lane < last; lane++)
+        {
+            GameObject* go = objects[h[lane]];
+            RenderItem* rItem = go->renderItem.get();
+
+            const XMMATRIX rotationMatrix(row0.r[lane], row1.r[lane], row2.r[lane], g_XMIdentityR3);
+            XMStoreFloat4x4(&go->rotationQuat, rotationMatrix);
+
+            /*scale * rotation * translation with a diagonal scale only scales the rows*/
+            XMMATRIX world(XMVectorMultiply(row0.r[lane], XMVectorSplatX(scale.r[lane])),
+                           XMVectorMultiply(row1.r[lane], XMVectorSplatY(scale.r[lane])),
+                           XMVectorMultiply(row2.r[lane], XMVectorSplatZ(scale.r[lane])),
+                           translation.r[lane]);
+
+            /*for skinned objects apply scene root transform*/
+            if (go->gameObjectType == ObjectType::Skinned)
+            {
+                world = XMLoadFloat4x4(&rItem->skinnedModel->rootTransform) * world;
+            }
+
+            XMStoreFloat4x4(&rItem->World, world);
+
+            XMStoreFloat4x4(&rItem->TexTransform, XMMatrixScalingFromVector(XMLoadFloat3(&go->TextureScale)) *
+                            XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&go->TextureRotation)) *
+                            XMMatrixTranslationFromVector(XMLoadFloat3(&go->TextureTranslation)));
+
+            go->collider.update(rItem->World);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../util/d3dUtil.h"
+#include "../util/jobsystem.h"
+#include <cstdint>
+
+class GameObject;
+
+/*
+local transforms of game objects as structure of arrays.
+setters only store the new position, rotation or scale and set a dirty bit, flush() then computes the
+world matrices of all dirty objects 4 at a time, updates their colliders and queues them for upload once per frame.
+not thread safe, transforms are changed and flushed on the main thread.
+*/
+class TransformSystem
+{
+public:
+
+    /*default constructor*/
+    explicit TransformSystem() = default;
+
+    /*default destructor*/
+    ~TransformSystem() = default;
+
+    /*removes all objects, their handles become invalid*/
+    void clear();
+
+    /*
+    takes over the transform of an object, changes to it are deferred until the next flush()
+    @param game object
+    @returns handle of the object
+    */
+    UINT add(GameObject* go);
+
+    void setPosition(UINT handle, const DirectX::XMFLOAT3& position);
+    void setRotation(UINT handle, const DirectX::XMFLOAT3& rotation);
+    void setScale(UINT handle, const DirectX::XMFLOAT3& scale);
+
+    /*recompute the world matrix of the object in the next flush()*/
+    void markDirty(UINT handle)
+    {
+        dirty[handle >> 6] |= std::uint64_t(1) << (handle & 63);
+    }
+
+    /*
+    computes world matrices, texture transforms and colliders of all dirty objects
+    @param job system the objects are distributed on, nullptr computes on the calling thread
+    */
+    void flush(JobSystem* jobs);
+
+    UINT size() const
+    {
+        return (UINT)objects.size();
+    }
+
+private:
+
+    /*objects per job, a multiple of the 4 objects processed at once*/
+    static constexpr UINT CHUNK_SIZE = 64;
+
+    /*computes the objects dirtyList[first, last)*/
+    void computeRange(UINT first, UINT last);
+
+    std::vector<GameObject*> objects;
+
+    /*local transform, rotation as pitch yaw roll like GameObject::setRotation()*/
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    std::vector<std::uint64_t> dirty;
+    std::vector<UINT> dirtyList;
+};
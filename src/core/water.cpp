@@ -127,7 +127,7 @@ void Water::update(const GameTime& gt)
         material->MiscFloat2 = heightScale.y;
 
         /*finish*/
-        material->NumFramesDirty = gNumFrameResources;
+        ServiceProvider::getRenderResource()->markDirty(material);
 
         updateTime -= updFixedTime;
     }
@@ -0,0 +1,196 @@
+#include "mazepvs.h"
+#include <algorithm>
+#include <cmath>
+
+void MazePVS::build(Grid& grid)
+{
+    wait();
+
+    ready.store(false, std::memory_order_release);
+
+    width = grid.columns();
+    height = grid.rows();
+    selectedCell = -1;
+
+    openEast.assign(width * height, false);
+    openSouth.assign(width * height, false);
+
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const Cell* cell = grid(x, y);
+
+            openEast[y * width + x] = cell->e != nullptr && cell->isLinked(cell->e);
+            openSouth[y * width + x] = cell->s != nullptr && cell->isLinked(cell->s);
+        }
+    }
+
+    /*the copied passages are all the background thread needs*/
+    task = std::async(std::launch::async, [this]()
+                      {
+                          compute();
+                          ready.store(true, std::memory_order_release);
+                      });
+}
+
+void MazePVS::wait()
+{
+    if(task.valid())
+    {
+        task.wait();
+    }
+}
+
+bool MazePVS::selectCell(int x, int y)
+{
+    if(!isReady() || x < 0 || y < 0 || x >= width || y >= height)
+    {
+        return false;
+    }
+
+    const int index = y * width + x;
+
+    if(index == selectedCell)
+    {
+        return true;
+    }
+
+    selectedRow.assign(wordsPerRow, 0);
+
+    for(std::uint32_t i = rowOffsets[index]; i < rowOffsets[index + 1]; i++)
+    {
+        selectedRow[wordIndices[i]] = words[i];
+    }
+
+    selectedCell = index;
+
+    return true;
+}
+
+bool MazePVS::isStabbable(const Quadrant& q)
+{
+    /*the gap between the highest lower and the lowest upper bound is convex in a, search its minimum*/
+    auto gap = [&](float a)
+    {
+        float lower = -INFINITY;
+        float upper = INFINITY;
+
+        for(const auto& b : q.lower) lower = (std::max)(lower, b.slope * a + b.offset);
+        for(const auto& b : q.upper) upper = (std::min)(upper, b.slope * a + b.offset);
+
+        return lower - upper;
+    };
+
+    float a0 = -1.0f;
+    float a1 = 0.0f;
+
+    for(int i = 0; i < 40; i++)
+    {
+        const float m0 = a0 + (a1 - a0) / 3.0f;
+        const float m1 = a1 - (a1 - a0) / 3.0f;
+
+        if(gap(m0) < gap(m1))
+        {
+            a1 = m1;
+        }
+        else
+        {
+            a0 = m0;
+        }
+    }
+
+    /*the tolerance lets lines graze wall corners, it can only add cells*/
+    return gap((a0 + a1) / 2.0f) <= 1e-4f;
+}
+
+void MazePVS::walk(Quadrant& q, int x, int y, std::vector<std::uint64_t>& visible) const
+{
+    const int cx = q.sourceX + q.signX * x;
+    const int cy = q.sourceY + q.signY * y;
+
+    const int index = cy * width + cx;
+    visible[index >> 6] |= std::uint64_t(1) << (index & 63);
+
+    /*passage to the next column, the line has to pass the segment from (x + 1, y) to (x + 1, y + 1)*/
+    const int nx = cx + q.signX;
+
+    if(nx >= 0 && nx < width && isOpenEast((std::min)(cx, nx), cy))
+    {
+        q.lower.push_back({ -(float)(x + y + 2), -(float)(y + 1) });
+        q.upper.push_back({ -(float)(x + y + 1), -(float)y });
+
+        if(isStabbable(q))
+        {
+            walk(q, x + 1, y, visible);
+        }
+
+        q.lower.pop_back();
+        q.upper.pop_back();
+    }
+
+    /*passage to the next row, the line has to pass the segment from (x, y + 1) to (x + 1, y + 1)*/
+    const int ny = cy + q.signY;
+
+    if(ny >= 0 && ny < height && isOpenSouth(cx, (std::min)(cy, ny)))
+    {
+        q.lower.push_back({ -(float)(x + y + 1), -(float)(y + 1) });
+        q.upper.push_back({ -(float)(x + y + 2), -(float)(y + 1) });
+
+        if(isStabbable(q))
+        {
+            walk(q, x, y + 1, visible);
+        }
+
+        q.lower.pop_back();
+        q.upper.pop_back();
+    }
+}
+
+void MazePVS::compute()
+{
+    const int cellCount = width * height;
+    wordsPerRow = (cellCount + 63) / 64;
+
+    rowOffsets.assign(1, 0);
+    wordIndices.clear();
+    words.clear();
+
+    std::vector<std::uint64_t> visible(wordsPerRow);
+    Quadrant q;
+
+    for(int cy = 0; cy < height; cy++)
+    {
+        for(int cx = 0; cx < width; cx++)
+        {
+            std::fill(visible.begin(), visible.end(), 0);
+
+            /*the mirrored quadrants cover all line directions*/
+            for(int signY = -1; signY <= 1; signY += 2)
+            {
+                for(int signX = -1; signX <= 1; signX += 2)
+                {
+                    q.sourceX = cx;
+                    q.sourceY = cy;
+                    q.signX = signX;
+                    q.signY = signY;
+                    q.lower.clear();
+                    q.upper.clear();
+
+                    walk(q, 0, 0, visible);
+                }
+            }
+
+            for(int w = 0; w < wordsPerRow; w++)
+            {
+                if(visible[w] != 0)
+                {
+                    wordIndices.push_back(static_cast<std::uint32_t>(w));
+                    words.push_back(visible[w]);
+                }
+            }
+
+            rowOffsets.push_back(static_cast<std::uint32_t>(words.size()));
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "grid.h"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+/*
+potentially visible set of a maze, for every cell the cells that can be seen through open passages.
+a straight line only crosses cells monotonically in x and y, so the passages of every monotone path from a cell
+are walked per quadrant and a cell is visible if one line stabs all passages on the way (walls have no thickness and
+lines through wall corners count as visible, so the sets are conservative).
+every row of the cell to cell matrix is stored as compressed bitset that only keeps the non empty words.
+*/
+class MazePVS
+{
+    public:
+
+    MazePVS() = default;
+
+    ~MazePVS()
+    {
+        wait();
+    }
+
+    MazePVS(const MazePVS&) = delete;
+    MazePVS& operator=(const MazePVS&) = delete;
+
+    /*
+    copies the open passages of the grid and computes the visible sets on a background thread,
+    a build that is still running is finished first
+    @param grid with the linked cells of the current maze
+    */
+    void build(Grid& grid);
+
+    /*
+    @returns whether the last build is finished, the sets can only be used after that
+    */
+    [[nodiscard]] bool isReady() const
+    {
+        return ready.load(std::memory_order_acquire);
+    }
+
+    /*blocks until the background build is done*/
+    void wait();
+
+    /*
+    decodes the visible set of a cell for isVisible(), does nothing if the cell is already selected
+    @param column of the cell
+    @param row of the cell
+    @returns false if the cell is outside of the maze or the sets are not ready
+    */
+    bool selectCell(int x, int y);
+
+    /*
+    @param column of the cell
+    @param row of the cell
+    @returns whether the cell can be seen from the selected cell
+    */
+    [[nodiscard]] bool isVisible(int x, int y) const
+    {
+        const int index = y * width + x;
+        return (selectedRow[index >> 6] >> (index & 63)) & 1;
+    }
+
+    [[nodiscard]] int columns() const
+    {
+        return width;
+    }
+
+    [[nodiscard]] int rows() const
+    {
+        return height;
+    }
+
+    /*
+    @returns size of the compressed sets in bytes
+    */
+    [[nodiscard]] size_t compressedSize() const
+    {
+        return rowOffsets.size() * sizeof(std::uint32_t) + wordIndices.size() * sizeof(std::uint32_t) + words.size() * sizeof(std::uint64_t);
+    }
+
+    private:
+
+    /*
+    linear bound value = slope * a + offset on the offset c of the lines a * x + (1 + a) * y + c = 0, a in [-1, 0],
+    which are all lines with a direction in the first quadrant
+    */
+    struct LineBound
+    {
+        float slope;
+        float offset;
+    };
+
+    /*passages walked from the source cell, in quadrant local coordinates*/
+    struct Quadrant
+    {
+        int sourceX;
+        int sourceY;
+        int signX;
+        int signY;
+        std::vector<LineBound> lower;
+        std::vector<LineBound> upper;
+    };
+
+    void compute();
+
+    /*
+    marks a cell and continues through its passages in +x and +y of the quadrant while a line stabs all passages
+    @param quadrant of the walk
+    @param x of the cell relative to the source cell, mirrored into the first quadrant
+    @param y of the cell relative to the source cell, mirrored into the first quadrant
+    @param visible set of the source cell
+    */
+    void walk(Quadrant& q, int x, int y, std::vector<std::uint64_t>& visible) const;
+
+    /*@returns whether a line exists that satisfies all lower and upper bounds*/
+    static bool isStabbable(const Quadrant& q);
+
+    [[nodiscard]] bool isOpenEast(int x, int y) const
+    {
+        return openEast[y * width + x];
+    }
+
+    [[nodiscard]] bool isOpenSouth(int x, int y) const
+    {
+        return openSouth[y * width + x];
+    }
+
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+
+    /*passage to the east and south neighbour of every cell*/
+    std::vector<bool> openEast;
+    std::vector<bool> openSouth;
+
+    /*compressed rows, row i owns the non zero words [rowOffsets[i], rowOffsets[i+1])*/
+    std::vector<std::uint32_t> rowOffsets;
+    std::vector<std::uint32_t> wordIndices;
+    std::vector<std::uint64_t> words;
+
+    std::vector<std::uint64_t> selectedRow;
+    int selectedCell = -1;
+
+    std::future<void> task;
+    std::atomic<bool> ready{ false };
+};
@@ -203,7 +203,7 @@ void BulletController::updateAction(btCollisionWorld* collisionWorld, btScalar d
 
     if(player->previousCState == CharacterState::Fall && player->currentCState != CharacterState::Fall)
     {
-        player->setAnimation(SP_ANIM("geo_Idle"));
+        player->setAnimation(SP_ANIM("geo_Idle"), false, animationFadeTime);
     }
 
     if(currentVelocity < MathHelper::Epsilon)
@@ -219,11 +219,11 @@ void BulletController::updateAction(btCollisionWorld* collisionWorld, btScalar d
             
             if(player->currentCState == CharacterState::Fall)
             {
-                player->setAnimation(SP_ANIM("geo_Fall"), false);
+                player->setAnimation(SP_ANIM("geo_Fall"), false, animationFadeTime);
             }
             else
             {
-                player->setAnimation(SP_ANIM("geo_Idle"));
+                player->setAnimation(SP_ANIM("geo_Idle"), false, animationFadeTime);
             }
         }
     }
@@ -237,11 +237,11 @@ void BulletController::updateAction(btCollisionWorld* collisionWorld, btScalar d
 
         if(pressedRun)
         {
-            player->setAnimation(SP_ANIM("geo_Run"), keepAnimTime);
+            player->setAnimation(SP_ANIM("geo_Run"), keepAnimTime, animationFadeTime);
         }
         else
         {
-            player->setAnimation(SP_ANIM("geo_Walk"), keepAnimTime);
+            player->setAnimation(SP_ANIM("geo_Walk"), keepAnimTime, animationFadeTime);
         }
 
         isIdle = false;
@@ -79,6 +79,7 @@ class BulletController final : public btActionInterface
     const float offGroundThreshold = 0.2f;
     const float minimumJumpTime = 0.1f;
     const float fallJumpGracePeriod = 0.125f;
+    const float animationFadeTime = 0.2f;
 
     const float walkSpeed = 3.0f;
     const float runSpeed = 6.0f;
@@ -0,0 +1,544 @@
+#include "animation.h"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+
+using namespace DirectX;
+
+namespace
+{
+    /*same layout as MathHelper::printMatrix, which needs the log*/
+    void printMatrix(std::stringstream& str, const XMFLOAT4X4& m)
+    {
+        std::stringstream rows;
+        rows << std::fixed << std::setprecision(2) << "\n";
+
+        for (int r = 0; r < 4; r++)
+        {
+            rows << m(r, 0) << " | " << m(r, 1) << " | " << m(r, 2) << " | " << m(r, 3) << "\n";
+        }
+
+        str << rows.str();
+    }
+}
+
+void BoneAnimation::interpolate(float time, XMFLOAT4X4& matrix) const
+{
+    unsigned int cursor = 0;
+    interpolate(time, matrix, cursor);
+}
+
+void BoneAnimation::interpolate(float time, KeyFrame& keyFrame) const
+{
+    unsigned int cursor = 0;
+    interpolate(time, keyFrame, cursor);
+}
+
+void BoneAnimation::interpolate(float time, XMFLOAT4X4& matrix, unsigned int& cursor) const
+{
+    XMVECTOR S, P, Q;
+    sample(time, cursor, S, P, Q);
+
+    XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+    XMStoreFloat4x4(&matrix, XMMatrixAffineTransformation(S, zero, Q, P));
+}
+
+void BoneAnimation::interpolate(float time, KeyFrame& keyFrame, unsigned int& cursor) const
+{
+    XMVECTOR S, P, Q;
+    sample(time, cursor, S, P, Q);
+
+    keyFrame.timeStamp = time;
+    XMStoreFloat3(&keyFrame.translation, P);
+    XMStoreFloat3(&keyFrame.scale, S);
+    XMStoreFloat4(&keyFrame.rotationQuat, Q);
+}
+
+unsigned int BoneAnimation::findKey(float time, unsigned int& cursor) const
+{
+    const unsigned int lastInterval = (unsigned int)keyFrames.size() - 2;
+
+    if (cursor > lastInterval)
+    {
+        cursor = 0;
+    }
+
+    /*playback usually stays in the same interval or moves on to the next one*/
+    if (time >= keyFrames[cursor].timeStamp)
+    {
+        if (time <= keyFrames[(size_t)cursor + 1].timeStamp)
+        {
+            return cursor;
+        }
+
+        if (cursor < lastInterval && time <= keyFrames[(size_t)cursor + 2].timeStamp)
+        {
+            return ++cursor;
+        }
+    }
+
+    /*seek or loop, first key after time*/
+    const auto next = std::upper_bound(keyFrames.begin(), keyFrames.end(), time,
+                                       [](float t, const KeyFrame& key) { return t < key.timeStamp; });
+
+    cursor = (unsigned int)std::clamp<std::ptrdiff_t>((next - keyFrames.begin()) - 1, 0, lastInterval);
+
+    return cursor;
+}
+
+void BoneAnimation::sample(float time, unsigned int& cursor, XMVECTOR& S, XMVECTOR& P, XMVECTOR& Q) const
+{
+    if (time <= keyFrames.front().timeStamp)
+    {
+        S = XMLoadFloat3(&keyFrames.front().scale);
+        P = XMLoadFloat3(&keyFrames.front().translation);
+        Q = XMLoadFloat4(&keyFrames.front().rotationQuat);
+    }
+    else if (time >= keyFrames.back().timeStamp)
+    {
+        S = XMLoadFloat3(&keyFrames.back().scale);
+        P = XMLoadFloat3(&keyFrames.back().translation);
+        Q = XMLoadFloat4(&keyFrames.back().rotationQuat);
+    }
+    else
+    {
+        const unsigned int i = findKey(time, cursor);
+        const KeyFrame& k0 = keyFrames[i];
+        const KeyFrame& k1 = keyFrames[(size_t)i + 1];
+
+        float lerpPercent = (time - k0.timeStamp) / (k1.timeStamp - k0.timeStamp);
+
+        S = XMVectorLerp(XMLoadFloat3(&k0.scale), XMLoadFloat3(&k1.scale), lerpPercent);
+        P = XMVectorLerp(XMLoadFloat3(&k0.translation), XMLoadFloat3(&k1.translation), lerpPercent);
+        Q = XMQuaternionSlerp(XMLoadFloat4(&k0.rotationQuat), XMLoadFloat4(&k1.rotationQuat), lerpPercent);
+    }
+}
+
+
+
+float AnimationClip::getStartTime()
+{
+    if (startTime != -1.0f)
+    {
+        return startTime;
+    }
+
+    float result = FLT_MAX;
+
+    for (const auto& i : boneAnimations)
+    {
+        result = MathHelper::minH(result, i.getStartTime());
+    }
+
+    startTime = result;
+
+    return result;
+}
+
+
+
+float AnimationClip::getEndTime()
+{
+    if (endTime != -1.0f)
+    {
+        return endTime;
+    }
+
+    float result = 0.0f;
+
+    for (const auto& i : boneAnimations)
+    {
+        result = MathHelper::maxH(result, i.getEndTime());
+    }
+
+    endTime = result;
+
+    return result;
+}
+
+void AnimationClip::interpolate(float t, std::vector<XMFLOAT4X4>& boneTransforms) const
+{
+    for (unsigned int i = 0; i < boneTransforms.size(); ++i)
+    {
+        if(!boneAnimations[i].isEmpty)
+            boneAnimations[i].interpolate(t, boneTransforms[i]);
+    }
+}
+
+void AnimationClip::interpolate(float t, std::vector<KeyFrame>& keyTransforms) const
+{
+    for (unsigned int i = 0; i < keyTransforms.size(); ++i)
+    {
+        if (!boneAnimations[i].isEmpty)
+            boneAnimations[i].interpolate(t, keyTransforms[i]);
+    }
+}
+
+void AnimationClip::interpolate(float t, std::vector<XMFLOAT4X4>& boneTransforms, std::vector<unsigned int>& cursors) const
+{
+    if (cursors.size() < boneTransforms.size())
+    {
+        cursors.resize(boneTransforms.size(), 0);
+    }
+
+    for (unsigned int i = 0; i < boneTransforms.size(); ++i)
+    {
+        if (!boneAnimations[i].isEmpty)
+            boneAnimations[i].interpolate(t, boneTransforms[i], cursors[i]);
+    }
+}
+
+void AnimationClip::releaseKeyFrames()
+{
+    getStartTime();
+    getEndTime();
+
+    for (auto& bone : boneAnimations)
+    {
+        std::vector<KeyFrame>().swap(bone.keyFrames);
+    }
+}
+
+void SkinnedRig::bakeSkeleton()
+{
+    skeleton.build(nodeTree, boneCount);
+}
+
+void SkinnedRig::calculateFinalTransforms(SkinningScratch& scratch, AnimationClip* currentClip, float timePos, std::vector<unsigned int>* keyCursors, unsigned int maxDepth,
+                                            AnimationBlend* blend, const BonePalette& finalTransforms, const BonePalette& uploadTransforms) const
+{
+    auto& localPose = scratch.localPose;
+    auto& globalPose = scratch.globalPose;
+
+    /*start from the bind pose, the clip overwrites every animated bone*/
+    std::copy(skeleton.bindLocal.begin(), skeleton.bindLocal.end(), localPose.begin());
+
+    if (currentClip && currentClip->sampler.isValid())
+    {
+        const bool hasCursors = keyCursors && keyCursors->size() >= currentClip->sampler.getBoneCount();
+
+        currentClip->sampler.sample(timePos, scratch.sampledPose, hasCursors ? keyCursors->data() : nullptr);
+
+        const bool blended = blend && blendPose(scratch, currentClip, *blend);
+
+        /*bones that only the previous clip animates fade to their bind pose instead of snapping to it*/
+        currentClip->sampler.toMatrices(scratch.sampledPose, localPose.data(), boneCount, !blended);
+    }
+    else if (currentClip && keyCursors)
+    {
+        currentClip->interpolate(timePos, localPose, *keyCursors);
+    }
+    else if (currentClip)
+    {
+        currentClip->interpolate(timePos, localPose);
+    }
+
+    /*calculate global transforms, parents are always done before their children*/
+    for (const int bone : skeleton.order)
+    {
+        const int parent = skeleton.parents[bone];
+
+        /*masked bones follow their parent in bind pose*/
+        XMMATRIX toRoot = XMLoadFloat4x4(skeleton.depths[bone] > maxDepth ? &skeleton.bindLocal[bone] : &localPose[bone]);
+
+        if (parent >= 0)
+        {
+            toRoot = toRoot * XMLoadFloat4x4(&globalPose[parent]);
+        }
+
+        XMStoreFloat4x4(&globalPose[bone], toRoot);
+
+        const XMMATRIX offset = XMLoadFloat4x4(&skeleton.offsets[bone]);
+        const XMMATRIX finalTransform = XMMatrixTranspose(offset * toRoot);
+
+        if ((unsigned int)bone < finalTransforms.count)
+        {
+            XMStoreFloat4x4(&finalTransforms.transforms[bone], finalTransform);
+        }
+
+        /*only written, never read back, upload heaps are write combined*/
+        if ((unsigned int)bone < uploadTransforms.count)
+        {
+            XMStoreFloat4x4(&uploadTransforms.transforms[bone], finalTransform);
+        }
+    }
+
+}
+
+bool SkinnedRig::blendPose(SkinningScratch& scratch, const AnimationClip* currentClip, AnimationBlend& blend) const
+{
+    const unsigned int bones = currentClip->sampler.getBoneCount();
+
+    if (!blend.isActive() || skeleton.bindPose.boneCount != bones)
+    {
+        return false;
+    }
+
+    /*bones the current clip does not animate are blended from their bind pose*/
+    currentClip->sampler.fillUnanimated(scratch.sampledPose, skeleton.bindPose);
+
+    /*the previous clip is sampled into the second buffer and faded out against the current pose*/
+    if (blend.isFading())
+    {
+        if (const LocalPose* source = sampleFadeSource(scratch, bones, blend))
+        {
+            PoseSampler::blendPoses(*source, scratch.sampledPose, blend.fadeWeight(), scratch.sampledPose);
+        }
+    }
+
+    for (auto& layer : blend.additive)
+    {
+        const PoseSampler& sampler = layer.clip->sampler;
+
+        if (!sampler.isValid() || sampler.getBoneCount() != bones || layer.weight <= 0.0f) continue;
+
+        layer.cursors.resize(bones, 0);
+        sampler.sample(layer.time, scratch.blendPose, layer.cursors.data());
+        PoseSampler::addPose(scratch.sampledPose, scratch.blendPose, sampler.getReferencePose(), layer.weight);
+    }
+
+    return true;
+}
+
+const LocalPose* SkinnedRig::sampleFadeSource(SkinningScratch& scratch, unsigned int bones, AnimationBlend& blend) const
+{
+    if (blend.hasFrozenPose)
+    {
+        return blend.frozenPose.boneCount == bones ? &blend.frozenPose : nullptr;
+    }
+
+    const AnimationClip* clip = blend.fadeOut.clip;
+
+    if (clip == nullptr || !clip->sampler.isValid() || clip->sampler.getBoneCount() != bones)
+    {
+        return nullptr;
+    }
+
+    blend.fadeOut.cursors.resize(bones, 0);
+    clip->sampler.sample(blend.fadeOut.time, scratch.blendPose, blend.fadeOut.cursors.data());
+    clip->sampler.fillUnanimated(scratch.blendPose, skeleton.bindPose);
+
+    return &scratch.blendPose;
+}
+
+bool SkinnedRig::freezeFade(SkinningScratch& scratch, const AnimationClip* currentClip, float timePos, std::vector<unsigned int>* keyCursors, AnimationBlend& blend) const
+{
+    if (currentClip == nullptr || !currentClip->sampler.isValid())
+    {
+        return false;
+    }
+
+    const unsigned int bones = currentClip->sampler.getBoneCount();
+
+    if (skeleton.bindPose.boneCount != bones)
+    {
+        return false;
+    }
+
+    const LocalPose* source = sampleFadeSource(scratch, bones, blend);
+
+    if (source == nullptr)
+    {
+        return false;
+    }
+
+    const bool hasCursors = keyCursors && keyCursors->size() >= bones;
+
+    currentClip->sampler.sample(timePos, scratch.sampledPose, hasCursors ? keyCursors->data() : nullptr);
+    currentClip->sampler.fillUnanimated(scratch.sampledPose, skeleton.bindPose);
+
+    /*the source may be the frozen pose itself*/
+    PoseSampler::blendPoses(*source, scratch.sampledPose, blend.fadeWeight(), blend.frozenPose);
+    blend.hasFrozenPose = true;
+
+    return true;
+}
+
+void AnimationInstance::startFade(float duration)
+{
+    AnimationBlend& blend = animationBlend;
+
+    if (blend.isFading() && rig != nullptr && rig->freezeFade(skinningScratch, currentClip, animationTimer, &keyCursors, blend))
+    {
+        blend.fadeOut = AnimationLayer();
+    }
+    else
+    {
+        blend.hasFrozenPose = false;
+        blend.fadeOut.clip = currentClip;
+        blend.fadeOut.time = animationTimer;
+        blend.fadeOut.cursors = std::move(keyCursors);
+    }
+
+    blend.fadeDuration = duration;
+    blend.fadeElapsed = 0.0f;
+}
+
+void Skeleton::build(const NodeTree& tree, unsigned int boneCount)
+{
+    order.clear();
+    parents.assign(boneCount, -1);
+    bindLocal.assign(boneCount, MathHelper::identity4x4());
+    offsets.assign(boneCount, MathHelper::identity4x4());
+    depths.assign(boneCount, 0);
+
+    if (tree.boneRoot == nullptr) return;
+
+    /*depth first from the bone root, a node is added before its children*/
+    std::vector<const Node*> stack = { tree.boneRoot };
+
+    while (!stack.empty())
+    {
+        const Node* node = stack.back();
+        stack.pop_back();
+
+        if (node->isBone && node->boneIndex >= 0 && node->boneIndex < (int)boneCount)
+        {
+            const int bone = node->boneIndex;
+
+            order.push_back(bone);
+            parents[bone] = node->parent != nullptr && node->parent->isBone ? node->parent->boneIndex : -1;
+            bindLocal[bone] = node->transform;
+            offsets[bone] = node->boneOffset;
+        }
+
+        for (auto i = node->children.rbegin(); i != node->children.rend(); ++i)
+        {
+            stack.push_back(*i);
+        }
+    }
+
+    for (const int bone : order)
+    {
+        depths[bone] = parents[bone] >= 0 ? depths[parents[bone]] + 1 : 0;
+    }
+
+    /*decomposed once, laid out like a sampled pose*/
+    bindPose.resize(boneCount);
+
+    for (unsigned int g = 0; g < bindPose.groupCount(); g++)
+    {
+        XMMATRIX translation, scale, rotation;
+
+        for (unsigned int lane = 0; lane < 4; lane++)
+        {
+            const unsigned int bone = g * 4 + lane;
+
+            scale.r[lane] = g_XMOne;
+            rotation.r[lane] = XMQuaternionIdentity();
+            translation.r[lane] = XMVectorZero();
+
+            if (bone < boneCount)
+            {
+                XMMatrixDecompose(&scale.r[lane], &rotation.r[lane], &translation.r[lane], XMLoadFloat4x4(&bindLocal[bone]));
+            }
+        }
+
+        translation = XMMatrixTranspose(translation);
+        scale = XMMatrixTranspose(scale);
+        rotation = XMMatrixTranspose(rotation);
+
+        XMVECTOR out[LocalPose::CHANNELS];
+
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            out[c] = translation.r[c];
+            out[c + 3] = scale.r[c];
+        }
+
+        for (unsigned int c = 0; c < 4; c++)
+        {
+            out[c + 6] = rotation.r[c];
+        }
+
+        bindPose.store(g, out);
+    }
+}
+
+
+Node* NodeTree::findNodeByBoneIndex(int index) const
+{
+    Node* retNode = nullptr;
+
+    std::function<void(Node*)> searchTree = [&](Node* node)
+    {
+        if (node->boneIndex == index)
+        {
+            retNode = node;
+        }
+
+        for (auto i = 0; i < node->children.size(); i++)
+        {
+            searchTree(node->children[i]);
+        }
+
+        return;
+    };
+
+    searchTree(root);
+
+    return retNode;
+}
+
+
+std::string NodeTree::toString()
+{
+    std::stringstream ret;
+    printNodes(ret, root, 0);
+
+    return ret.str();
+}
+
+void NodeTree::printNodes(std::stringstream& str, Node* node, int depth)
+{   
+
+    str << std::string((long long)depth * 3, ' ') << std::string(2, '-') << ">" << node->name;
+
+    if (node->isBone)
+    {
+        str << " (Bone [" << node->boneIndex << "])";
+    }
+    else
+    {
+        str << " (Not a bone)";
+    }
+
+    if (node->parent != nullptr)
+    {
+        str << " child of node " << node->parent->name;
+    }
+    else
+    {
+        str << " root node";
+    }
+
+    DirectX::XMMATRIX trf = DirectX::XMLoadFloat4x4(&node->transform);
+
+    if (DirectX::XMMatrixIsIdentity(trf))
+    {
+        str << " (Identity Transform)";
+    }
+    str << "\n";
+
+    if (!DirectX::XMMatrixIsIdentity(trf))
+    {
+        printMatrix(str, node->transform);
+    }
+    else
+    {
+        str << "\n";
+    }
+
+    if (node->isBone)
+    {
+        str << "\nBone Offset:\n";
+        printMatrix(str, node->boneOffset);
+        str << "\n";
+    }
+
+    for (unsigned int i = 0; i < node->children.size(); i++)
+    {
+        printNodes(str, node->children[i], depth + 1);
+    }
+
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <climits>
+#include <cfloat>
+#include "../util/mathhelper.h"
+#include "posesampler.h"
+
+/*
+cpu side of skinned animation: clips, skeletons and the pose state of an instance.
+needs no device or window, the benchmark and tests build it on every platform.
+*/
+
+/*animation clips*/
+struct KeyFrame
+{
+    explicit KeyFrame() : timeStamp(0.0f),
+        translation(0.0f, 0.0f, 0.0f),
+        scale(1.0f, 1.0f, 1.0f),
+        rotationQuat(0.0f, 0.0f, 0.0f, 1.0f)
+    {
+    }
+    ~KeyFrame() = default;
+
+    float timeStamp;
+    DirectX::XMFLOAT3 translation;
+    DirectX::XMFLOAT3 scale;
+    DirectX::XMFLOAT4 rotationQuat;
+};
+
+struct BoneAnimation
+{
+    std::vector<KeyFrame> keyFrames;
+    bool isEmpty = false;
+
+    float getStartTime() const
+    {
+        if (isEmpty) return FLT_MAX;
+
+        return keyFrames.front().timeStamp;
+    }
+
+    float getEndTime() const
+    {
+        if (isEmpty) return -FLT_MAX;
+
+        return keyFrames.back().timeStamp;
+    }
+
+    void interpolate(float time, DirectX::XMFLOAT4X4& matrix) const;
+    void interpolate(float time, KeyFrame& keyFrame) const;
+
+    /*
+    same as above with a cursor that remembers the last key interval of one instance,
+    advancing playback finds its keys in constant time, seeks and loops use a binary search
+    @param time
+    @param key cursor of this bone, 0 for a new instance
+    */
+    void interpolate(float time, DirectX::XMFLOAT4X4& matrix, unsigned int& cursor) const;
+    void interpolate(float time, KeyFrame& keyFrame, unsigned int& cursor) const;
+
+private:
+
+    /*
+    @returns index of the key that starts the interval containing time, time has to be between the first and last key
+    */
+    unsigned int findKey(float time, unsigned int& cursor) const;
+
+    void sample(float time, unsigned int& cursor, DirectX::XMVECTOR& S, DirectX::XMVECTOR& P, DirectX::XMVECTOR& Q) const;
+};
+
+
+struct AnimationClip
+{
+    std::vector<BoneAnimation> boneAnimations;
+    std::string name;
+
+    /*keys of all bones for sampling 4 at a time, only valid if at least one bone is animated*/
+    PoseSampler sampler;
+
+private:
+    float startTime = -1.0f;
+    float endTime = -1.0f;
+
+public:
+
+    float getStartTime();
+    float getEndTime();
+    void interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms) const;
+    void interpolate(float t, std::vector<KeyFrame>& keyTransforms) const;
+
+    /*same as above with one key cursor per bone, see BoneAnimation::interpolate*/
+    void interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms, std::vector<unsigned int>& cursors) const;
+
+    /*
+    frees the keys of the bone animations once the sampler holds them, start and end time are kept.
+    the interpolate functions and the times of single bones can not be used afterwards
+    */
+    void releaseKeyFrames();
+};
+
+struct Node
+{
+    std::string name = "";
+    Node* parent = nullptr;
+
+    bool isBone = false;
+    int boneIndex = -1;
+
+    DirectX::XMFLOAT4X4 transform = {};
+    DirectX::XMFLOAT4X4 boneOffset = {};
+
+    DirectX::XMFLOAT4X4 globalTransform = {};
+
+    std::vector<Node*> children;
+
+    ~Node()
+    {
+        for (auto i = 0; i < children.size(); i++)
+        {
+            delete children[i];
+        }
+    }
+};
+
+struct NodeTree
+{
+    NodeTree()
+    {
+        root = new Node();
+    }
+
+    ~NodeTree()
+    {
+        delete root;
+    }
+
+
+    Node* root = nullptr;
+    Node* boneRoot = nullptr;
+
+    Node* findNodeByBoneIndex(int index) const;
+    std::string toString();
+
+private:
+    void printNodes(std::stringstream& str, Node* node, int depth = 0);
+};
+
+/*bone hierarchy of the node tree flattened into arrays, parents are always evaluated before their children*/
+struct Skeleton
+{
+    /*bone indices in evaluation order*/
+    std::vector<int> order;
+
+    /*per bone index: parent bone (-1 if the parent node is no bone), local bind transform and bone offset*/
+    std::vector<int> parents;
+    std::vector<DirectX::XMFLOAT4X4> bindLocal;
+    std::vector<DirectX::XMFLOAT4X4> offsets;
+
+    /*per bone: amount of bone ancestors*/
+    std::vector<unsigned int> depths;
+
+    /*bind transforms as sampled pose, blends take it for bones that are not animated by a clip*/
+    LocalPose bindPose;
+
+    /*
+    @param node tree with bone root set
+    @param amount of bones
+    */
+    void build(const NodeTree& tree, unsigned int boneCount);
+};
+
+/*a clip played on top of or faded out against the current clip of an instance*/
+struct AnimationLayer
+{
+    AnimationClip* clip = nullptr;
+    float time = 0.0f;
+    float weight = 1.0f;
+
+    /*one key cursor per bone of the clip*/
+    std::vector<unsigned int> cursors;
+};
+
+/*crossfade from the previous clip and additive layers of one skinned instance*/
+struct AnimationBlend
+{
+    /*previous clip, its weight falls from 1 to 0 over the fade duration*/
+    AnimationLayer fadeOut;
+    float fadeDuration = 0.0f;
+    float fadeElapsed = 0.0f;
+
+    /*pose of an interrupted fade, faded out instead of the previous clip*/
+    LocalPose frozenPose;
+    bool hasFrozenPose = false;
+
+    /*clips whose difference to their first key is added to the pose*/
+    std::vector<AnimationLayer> additive;
+
+    bool hasFadeSource() const
+    {
+        return fadeOut.clip != nullptr || hasFrozenPose;
+    }
+
+    bool isFading() const
+    {
+        return hasFadeSource() && fadeElapsed < fadeDuration;
+    }
+
+    void stopFade()
+    {
+        fadeOut = AnimationLayer();
+        hasFrozenPose = false;
+    }
+
+    bool isActive() const
+    {
+        return isFading() || !additive.empty();
+    }
+
+    /*@returns smoothed weight of the current clip during the crossfade*/
+    float fadeWeight() const
+    {
+        return fadeDuration > 0.0f ? MathHelper::smoothStepH(0.0f, fadeDuration, fadeElapsed) : 1.0f;
+    }
+};
+
+/*pose buffers of one skinned instance, sized once so evaluating a pose never allocates*/
+struct SkinningScratch
+{
+    std::vector<DirectX::XMFLOAT4X4> localPose;
+    std::vector<DirectX::XMFLOAT4X4> globalPose;
+    LocalPose sampledPose;
+
+    /*second sample of a crossfade or additive layer*/
+    LocalPose blendPose;
+
+    void resize(unsigned int boneCount)
+    {
+        localPose.resize(boneCount);
+        globalPose.resize(boneCount);
+        sampledPose.resize(boneCount);
+        blendPose.resize(boneCount);
+    }
+};
+
+/*destination of final bone matrices, transposed for the shader and laid out like SkinnedConstants::BoneTransforms*/
+struct BonePalette
+{
+    DirectX::XMFLOAT4X4* transforms = nullptr;
+
+    /*bones beyond the count are not written*/
+    unsigned int count = 0;
+};
+
+/*bones of a skinned model, shared by all of its instances*/
+struct SkinnedRig
+{
+    unsigned int boneCount = 0;
+    std::vector<int> boneHierarchy;
+    NodeTree nodeTree;
+    Skeleton skeleton;
+    DirectX::XMFLOAT4X4 rootTransform = {};
+
+    /*builds the skeleton from the node tree, called once after loading*/
+    void bakeSkeleton();
+
+    /*
+    clips with a valid sampler are sampled 4 bones at a time, the others bone by bone.
+    blending happens on the sampled local poses, a blended pose still needs only one walk of the hierarchy
+    @param pose buffers of the instance, sized for this model
+    @param clip to sample, nullptr for the bind pose
+    @param time in the clip
+    @param key cursors of the instance, nullptr samples without cursors
+    @param bones deeper in the skeleton keep their bind pose
+    @param optional crossfade and additive layers, only applied to clips with a valid sampler
+    @param final bone matrices
+    @param optional second destination that receives the same matrices, e.g. a mapped upload buffer
+    */
+    void calculateFinalTransforms(SkinningScratch& scratch, AnimationClip* currentClip, float timePos, std::vector<unsigned int>* keyCursors, unsigned int maxDepth,
+                                  AnimationBlend* blend, const BonePalette& finalTransforms, const BonePalette& uploadTransforms = BonePalette()) const;
+
+    /*
+    stores the pose of a running fade in its frozen pose, additive layers are not part of it
+    @param pose buffers of the instance
+    @param clip that fades in, its time and key cursors
+    @param running fade
+    @returns false if the pose could not be sampled, the fade is left as it is then
+    */
+    bool freezeFade(SkinningScratch& scratch, const AnimationClip* currentClip, float timePos, std::vector<unsigned int>* keyCursors, AnimationBlend& blend) const;
+
+private:
+
+    /*
+    applies the crossfade and additive layers to the sampled pose of the current clip
+    @returns true if the pose was blended, it holds every bone then
+    */
+    bool blendPose(SkinningScratch& scratch, const AnimationClip* currentClip, AnimationBlend& blend) const;
+
+    /*@returns frozen pose or sampled pose of the previous clip with the bind pose for bones it does not animate, nullptr if it does not fit*/
+    const LocalPose* sampleFadeSource(SkinningScratch& scratch, unsigned int bones, AnimationBlend& blend) const;
+};
+
+/*animation state of one skinned instance*/
+struct AnimationInstance
+{
+    const SkinnedRig* rig = nullptr;
+
+    AnimationClip* currentClip = nullptr;
+    float animationTimer = 0.0f;
+
+    std::vector<DirectX::XMFLOAT4X4> finalTransforms;
+
+    /*last key interval per bone of the current clip*/
+    std::vector<unsigned int> keyCursors;
+
+    /*bones deeper in the skeleton keep their bind pose, set by the animation lod*/
+    unsigned int animatedBoneDepth = UINT_MAX;
+
+    /*pose buffers of the rig, sized when the rig is set*/
+    SkinningScratch skinningScratch;
+
+    /*crossfade and additive layers on top of the current clip*/
+    AnimationBlend animationBlend;
+
+    /*
+    fades out the current clip, called before the next clip is set.
+    a fade that is still running is frozen into the pose it shows at this moment and faded out instead,
+    so interrupting a fade does not jump back to its previous clip
+    @param fade duration
+    */
+    void startFade(float duration);
+};
@@ -0,0 +1,156 @@
+#include "depthsort.h"
+#include "../core/gameobject.h"
+#include <cstring>
+
+using namespace DirectX;
+
+void DepthSorter::sort(std::vector<GameObject*>& objects, DirectX::FXMVECTOR cameraPos)
+{
+    if (objects.size() < 2) return;
+
+    computeKeys(objects, cameraPos);
+
+    const float moved = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(cameraPos, XMLoadFloat3(&previousCameraPos))));
+
+    /*the vector still holds last frames order, only use it if it is the same set of objects*/
+    if (hasPreviousOrder && previousCount == objects.size() && moved < coherentDistance * coherentDistance)
+    {
+        insertionSort(objects);
+    }
+    else
+    {
+        radixSort(objects);
+    }
+
+    XMStoreFloat3(&previousCameraPos, cameraPos);
+    previousCount = objects.size();
+    hasPreviousOrder = true;
+}
+
+void DepthSorter::computeKeys(const std::vector<GameObject*>& objects, DirectX::FXMVECTOR cameraPos)
+{
+    const size_t count = objects.size();
+    const size_t padded = (count + 3) & ~(size_t)3;
+
+    posX.resize(padded);
+    posY.resize(padded);
+    posZ.resize(padded);
+    distances.resize(padded);
+    keys.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto p = objects[i]->getPosition();
+        posX[i] = p.x;
+        posY[i] = p.y;
+        posZ[i] = p.z;
+    }
+
+    /*squared distances for 4 objects at once*/
+    const XMVECTOR cx = XMVectorSplatX(cameraPos);
+    const XMVECTOR cy = XMVectorSplatY(cameraPos);
+    const XMVECTOR cz = XMVectorSplatZ(cameraPos);
+
+    for (size_t i = 0; i < padded; i += 4)
+    {
+        const XMVECTOR dx = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&posX[i])), cx);
+        const XMVECTOR dy = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&posY[i])), cy);
+        const XMVECTOR dz = XMVectorSubtract(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&posZ[i])), cz);
+
+        const XMVECTOR d2 = XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz)));
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&distances[i]), d2);
+    }
+
+    /*positive floats keep their order as integers, invert so ascending keys are back to front*/
+    for (size_t i = 0; i < count; i++)
+    {
+        UINT bits = 0;
+        std::memcpy(&bits, &distances[i], sizeof(UINT));
+        keys[i] = ~bits;
+    }
+}
+
+void DepthSorter::insertionSort(std::vector<GameObject*>& objects)
+{
+    const size_t count = objects.size();
+
+    /*give up on the coherent order if it needs too many moves*/
+    size_t budget = count * 8;
+
+    for (size_t i = 1; i < count; i++)
+    {
+        const UINT key = keys[i];
+        GameObject* obj = objects[i];
+        size_t j = i;
+
+        while (j > 0 && keys[j - 1] > key)
+        {
+            keys[j] = keys[j - 1];
+            objects[j] = objects[j - 1];
+            j--;
+
+            if (--budget == 0)
+            {
+                keys[j] = key;
+                objects[j] = obj;
+                radixSort(objects);
+                return;
+            }
+        }
+
+        keys[j] = key;
+        objects[j] = obj;
+    }
+}
+
+void DepthSorter::radixSort(std::vector<GameObject*>& objects)
+{
+    const size_t count = objects.size();
+
+    tmpKeys.resize(count);
+    tmpObjects.resize(count);
+
+    UINT* srcKeys = keys.data();
+    UINT* dstKeys = tmpKeys.data();
+    GameObject** srcObjects = objects.data();
+    GameObject** dstObjects = tmpObjects.data();
+
+    /*lsd radix sort, 4 passes of 8 bit*/
+    for (UINT shift = 0; shift < 32; shift += 8)
+    {
+        std::array<size_t, 256> offsets{};
+
+        for (size_t i = 0; i < count; i++)
+        {
+            offsets[(srcKeys[i] >> shift) & 0xFF]++;
+        }
+
+        /*all keys share this byte, nothing to do*/
+        if (offsets[(srcKeys[0] >> shift) & 0xFF] == count) continue;
+
+        size_t sum = 0;
+        for (auto& o : offsets)
+        {
+            const size_t c = o;
+            o = sum;
+            sum += c;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t dst = offsets[(srcKeys[i] >> shift) & 0xFF]++;
+            dstKeys[dst] = srcKeys[i];
+            dstObjects[dst] = srcObjects[i];
+        }
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcObjects, dstObjects);
+    }
+
+    /*result ended up in the temporary buffers*/
+    if (srcObjects != objects.data())
+    {
+        std::copy(srcObjects, srcObjects + count, objects.data());
+        std::copy(srcKeys, srcKeys + count, keys.data());
+    }
+}
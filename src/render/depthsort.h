@@ -0,0 +1,57 @@
+#pragma once
+
+class GameObject;
+
+#include "../util/d3dUtil.h"
+
+/*
+sorts game objects back to front with 32 bit depth keys.
+if the camera moved only a little since the last call the previous order is reused
+and fixed with an insertion sort, otherwise the keys are radix sorted.
+*/
+class DepthSorter
+{
+public:
+
+    /*default constructor*/
+    explicit DepthSorter() = default;
+
+    /*default destructor*/
+    ~DepthSorter() = default;
+
+    /*
+    sorts the objects by descending distance to the camera, the vector is sorted in place
+    @param objects to sort, should be the same vector every frame
+    @param camera position
+    */
+    void sort(std::vector<GameObject*>& objects, DirectX::FXMVECTOR cameraPos);
+
+    /*forces a full sort on the next call*/
+    void invalidate()
+    {
+        hasPreviousOrder = false;
+    }
+
+private:
+
+    void computeKeys(const std::vector<GameObject*>& objects, DirectX::FXMVECTOR cameraPos);
+    void insertionSort(std::vector<GameObject*>& objects);
+    void radixSort(std::vector<GameObject*>& objects);
+
+    std::vector<UINT> keys;
+    std::vector<UINT> tmpKeys;
+    std::vector<GameObject*> tmpObjects;
+
+    /*positions as structure of arrays for the key computation*/
+    std::vector<float> posX;
+    std::vector<float> posY;
+    std::vector<float> posZ;
+    std::vector<float> distances;
+
+    DirectX::XMFLOAT3 previousCameraPos = { 0.0f,0.0f,0.0f };
+    size_t previousCount = 0;
+    bool hasPreviousOrder = false;
+
+    /*camera movement below which the last order is expected to be almost sorted*/
+    const float coherentDistance = 1.0f;
+};
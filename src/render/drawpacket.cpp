@@ -0,0 +1,69 @@
+#include "drawpacket.h"
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+std::uint64_t DrawPacketBuilder::makeOpaqueKey(std::uint32_t pso, std::uint32_t mesh, std::uint32_t material, float depth)
+{
+    /*upper 16 bit of a positive float keep the order*/
+    std::uint32_t depthBits = 0;
+    depth = (std::max)(depth, 0.0f);
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    return (static_cast<std::uint64_t>(pso & 0xFF) << 56) |
+        (static_cast<std::uint64_t>(mesh & 0xFFFFFF) << 32) |
+        (static_cast<std::uint64_t>(material & 0xFFFF) << 16) |
+        static_cast<std::uint64_t>(depthBits >> 16);
+}
+
+std::uint64_t DrawPacketBuilder::makeOrderedKey(std::uint32_t pso, std::uint32_t order, std::uint32_t subIndex)
+{
+    return (static_cast<std::uint64_t>(pso & 0xFF) << 56) |
+        (static_cast<std::uint64_t>(order) << 24) |
+        static_cast<std::uint64_t>(subIndex & 0xFFFFFF);
+}
+
+void DrawPacketBuilder::sort()
+{
+    const size_t count = packets.size();
+
+    if (count < 2) return;
+
+    tmpPackets.resize(count);
+
+    DrawPacket* src = packets.data();
+    DrawPacket* dst = tmpPackets.data();
+
+    /*8 passes of 8 bit, skip bytes that are equal for all keys*/
+    for (std::uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::array<size_t, 256> offsets{};
+
+        for (size_t i = 0; i < count; i++)
+        {
+            offsets[(src[i].sortKey >> shift) & 0xFF]++;
+        }
+
+        if (offsets[(src[0].sortKey >> shift) & 0xFF] == count) continue;
+
+        size_t sum = 0;
+        for (auto& o : offsets)
+        {
+            const size_t c = o;
+            o = sum;
+            sum += c;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            dst[offsets[(src[i].sortKey >> shift) & 0xFF]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != packets.data())
+    {
+        std::copy(src, src + count, packets.data());
+    }
+}
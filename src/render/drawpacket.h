@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+compact draw command, object and mesh are indices into the lists of whoever submits the packets
+*/
+struct DrawPacket
+{
+    std::uint64_t sortKey = 0;
+    std::uint32_t object = 0;
+    std::uint32_t mesh = 0;
+};
+
+/*
+collects draw packets and sorts them by their 64 bit key, does not know anything about the renderer
+
+key layouts:
+opaque:  pso(8) | mesh(24) | material(16) | depth(16)
+ordered: pso(8) | order(32) | sub index(24)
+*/
+class DrawPacketBuilder
+{
+public:
+
+    /*default constructor*/
+    explicit DrawPacketBuilder() = default;
+
+    /*default destructor*/
+    ~DrawPacketBuilder() = default;
+
+    /*
+    key that groups by pipeline state, then mesh and material, front to back inside a group
+    @param pipeline state id (0-255)
+    @param mesh id, only the lower 24 bit are used
+    @param material id, only the lower 16 bit are used
+    @param non negative view depth or squared distance
+    */
+    static std::uint64_t makeOpaqueKey(std::uint32_t pso, std::uint32_t mesh, std::uint32_t material, float depth);
+
+    /*
+    key that keeps a given order inside a pipeline state, e.g. for already depth sorted transparent objects
+    @param pipeline state id (0-255)
+    @param position in the wanted order
+    @param sub index that keeps e.g. meshes of one object in order
+    */
+    static std::uint64_t makeOrderedKey(std::uint32_t pso, std::uint32_t order, std::uint32_t subIndex);
+
+    /*
+    @returns pipeline state id stored in a key
+    */
+    static std::uint32_t getPSO(std::uint64_t key)
+    {
+        return static_cast<std::uint32_t>(key >> 56);
+    }
+
+    void clear()
+    {
+        packets.clear();
+    }
+
+    void add(std::uint64_t key, std::uint32_t object, std::uint32_t mesh)
+    {
+        packets.push_back({ key, object, mesh });
+    }
+
+    /*sorts all packets ascending by key (stable lsd radix sort)*/
+    void sort();
+
+    const std::vector<DrawPacket>& getPackets() const
+    {
+        return packets;
+    }
+
+    size_t size() const
+    {
+        return packets.size();
+    }
+
+private:
+
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> tmpPackets;
+};
@@ -2,6 +2,7 @@
 
 #include "../util/d3dUtil.h"
 #include "../render/uploadbuffer.h"
+#include "../util/skinnedmodelparser.h"
 
 struct ObjectConstants
 {
@@ -99,16 +100,6 @@ struct ParticleVertex
     UINT Visible;
 };
 
-struct SkinnedVertex
-{
-    DirectX::XMFLOAT3 Pos;
-    DirectX::XMFLOAT3 Normal;
-    DirectX::XMFLOAT2 TexC;
-    DirectX::XMFLOAT3 TangentU;
-    DirectX::XMFLOAT3 BoneWeights;
-    BYTE BoneIndices[4];
-};
-
 class FrameResource
 {
 public:
@@ -129,6 +120,11 @@ public:
 
     std::unique_ptr<UploadBuffer<SkinnedConstants>> SkinnedCB = nullptr;
 
+    // Render items and materials that still have to be uploaded to this frame resource.
+    std::vector<RenderItem*> DirtyObjects;
+    std::vector<RenderItem*> DirtySkinned;
+    std::vector<Material*> DirtyMaterials;
+
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
     UINT64 Fence = 0;
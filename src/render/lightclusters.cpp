@@ -0,0 +1,300 @@
+#include "lightclusters.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+/*one bit per lane of a comparison result*/
+static inline int moveMask(FXMVECTOR v)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+    return _mm_movemask_ps(v);
+#else
+    XMUINT4 m;
+    XMStoreUInt4(&m, v);
+    return (m.x >> 31) | ((m.y >> 31) << 1) | ((m.z >> 31) << 2) | ((m.w >> 31) << 3);
+#endif
+}
+
+/*loads 4 consecutive floats of a structure of arrays*/
+static inline XMVECTOR load4(const std::vector<float>& v, unsigned int index)
+{
+    return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&v[index]));
+}
+
+void LightClusters::build(float fovY, float aspect, float nearZ, float farZ)
+{
+    if (!minX.empty() && fovY == mFovY && aspect == mAspect && nearZ == mNearZ && farZ == mFarZ)
+    {
+        return;
+    }
+
+    mFovY = fovY;
+    mAspect = aspect;
+    mNearZ = nearZ;
+    mFarZ = farZ;
+    invLogFarNear = (float)(SLICES - 1) / std::log(farZ / nearZ);
+
+    /*slice 0 reaches from the camera to nearZ, the others are distributed exponentially*/
+    sliceBounds[0] = 0.0f;
+
+    for (unsigned int k = 1; k <= SLICES; k++)
+    {
+        sliceBounds[k] = nearZ * std::pow(farZ / nearZ, (float)(k - 1) / (float)(SLICES - 1));
+    }
+
+    minX.resize(CLUSTER_COUNT);
+    maxX.resize(CLUSTER_COUNT);
+    minY.resize(CLUSTER_COUNT);
+    maxY.resize(CLUSTER_COUNT);
+    centerX.resize(CLUSTER_COUNT);
+    centerY.resize(CLUSTER_COUNT);
+    centerZ.resize(CLUSTER_COUNT);
+    radius.resize(CLUSTER_COUNT);
+
+    const float tanHalfY = std::tan(0.5f * fovY);
+    const float tanHalfX = aspect * tanHalfY;
+
+    for (unsigned int s = 0; s < SLICES; s++)
+    {
+        const float z0 = sliceBounds[s];
+        const float z1 = sliceBounds[s + 1];
+
+        for (unsigned int ty = 0; ty < TILES_Y; ty++)
+        {
+            const float y0 = (1.0f - 2.0f * (float)(ty + 1) / TILES_Y) * tanHalfY;
+            const float y1 = (1.0f - 2.0f * (float)ty / TILES_Y) * tanHalfY;
+
+            for (unsigned int tx = 0; tx < TILES_X; tx++)
+            {
+                const float x0 = (-1.0f + 2.0f * (float)tx / TILES_X) * tanHalfX;
+                const float x1 = (-1.0f + 2.0f * (float)(tx + 1) / TILES_X) * tanHalfX;
+
+                const unsigned int index = s * TILES_PER_SLICE + ty * TILES_X + tx;
+
+                /*aabb around the 8 corners of the sub frustum*/
+                minX[index] = (std::min)({ x0 * z0, x0 * z1, x1 * z0, x1 * z1 });
+                maxX[index] = (std::max)({ x0 * z0, x0 * z1, x1 * z0, x1 * z1 });
+                minY[index] = (std::min)({ y0 * z0, y0 * z1, y1 * z0, y1 * z1 });
+                maxY[index] = (std::max)({ y0 * z0, y0 * z1, y1 * z0, y1 * z1 });
+
+                /*sphere around the aabb*/
+                const float ex = 0.5f * (maxX[index] - minX[index]);
+                const float ey = 0.5f * (maxY[index] - minY[index]);
+                const float ez = 0.5f * (z1 - z0);
+
+                centerX[index] = minX[index] + ex;
+                centerY[index] = minY[index] + ey;
+                centerZ[index] = z0 + ez;
+                radius[index] = std::sqrt(ex * ex + ey * ey + ez * ez);
+            }
+        }
+    }
+}
+
+void LightClusters::assign(const ClusterLight* lights, unsigned int count, DirectX::FXMMATRIX view)
+{
+    clusterOffsets.assign((size_t)CLUSTER_COUNT + 1, 0);
+    pairCluster.clear();
+    pairLight.clear();
+    clusterLightIndices.clear();
+    visibleLights.clear();
+
+    if (minX.empty()) return;
+
+    const XMVECTOR zero = XMVectorZero();
+
+    for (unsigned int i = 0; i < count && i < MAX_CLUSTERED_LIGHTS; i++)
+    {
+        const ClusterLight& light = lights[i];
+        const float r = light.range;
+
+        XMFLOAT3 c{};
+        XMStoreFloat3(&c, XMVector3TransformCoord(XMLoadFloat3(&light.position), view));
+
+        /*completely behind the camera or beyond the last slice*/
+        if (c.z + r < 0.0f || c.z - r > mFarZ) continue;
+
+        const unsigned int firstSlice = sliceFromDepth(c.z - r);
+        const unsigned int lastSlice = sliceFromDepth(c.z + r);
+
+        const XMVECTOR cx = XMVectorReplicate(c.x);
+        const XMVECTOR cy = XMVectorReplicate(c.y);
+        const XMVECTOR cz = XMVectorReplicate(c.z);
+
+        /*cone of a spot light in view space, a cluster is outside if its bounding sphere is outside of the cone*/
+        const bool isSpot = light.cosCone > -1.0f;
+        const XMVECTOR direction = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&light.direction), view));
+        const XMVECTOR dx = XMVectorSplatX(direction);
+        const XMVECTOR dy = XMVectorSplatY(direction);
+        const XMVECTOR dz = XMVectorSplatZ(direction);
+        const XMVECTOR cosCone = XMVectorReplicate(light.cosCone);
+        const XMVECTOR sinCone = XMVectorReplicate(std::sqrt((std::max)(1.0f - light.cosCone * light.cosCone, 0.0f)));
+        const XMVECTOR range = XMVectorReplicate(r);
+
+        /*clusters behind the apex can only be culled for cones up to 180 degrees*/
+        const XMVECTOR backCull = light.cosCone >= 0.0f ? XMVectorTrueInt() : XMVectorFalseInt();
+
+        bool touched = false;
+
+        for (unsigned int s = firstSlice; s <= lastSlice; s++)
+        {
+            /*distance along z is the same for all tiles of the slice*/
+            const float distanceZ = (std::max)({ sliceBounds[s] - c.z, c.z - sliceBounds[s + 1], 0.0f });
+            const float remaining = r * r - distanceZ * distanceZ;
+
+            if (remaining < 0.0f) continue;
+
+            const XMVECTOR r2 = XMVectorReplicate(remaining);
+            const unsigned int base = s * TILES_PER_SLICE;
+
+            /*sphere vs aabb for 4 tiles at once*/
+            for (unsigned int t = 0; t < TILES_PER_SLICE; t += 4)
+            {
+                const unsigned int index = base + t;
+
+                const XMVECTOR distanceX = XMVectorMax(XMVectorMax(XMVectorSubtract(load4(minX, index), cx), XMVectorSubtract(cx, load4(maxX, index))), zero);
+                const XMVECTOR distanceY = XMVectorMax(XMVectorMax(XMVectorSubtract(load4(minY, index), cy), XMVectorSubtract(cy, load4(maxY, index))), zero);
+                const XMVECTOR d2 = XMVectorMultiplyAdd(distanceX, distanceX, XMVectorMultiply(distanceY, distanceY));
+
+                XMVECTOR inside = XMVectorLessOrEqual(d2, r2);
+
+                if (isSpot && moveMask(inside) != 0)
+                {
+                    const XMVECTOR vx = XMVectorSubtract(load4(centerX, index), cx);
+                    const XMVECTOR vy = XMVectorSubtract(load4(centerY, index), cy);
+                    const XMVECTOR vz = XMVectorSubtract(load4(centerZ, index), cz);
+                    const XMVECTOR sphereRadius = load4(radius, index);
+
+                    const XMVECTOR lengthSq = XMVectorMultiplyAdd(vx, vx, XMVectorMultiplyAdd(vy, vy, XMVectorMultiply(vz, vz)));
+                    const XMVECTOR alongAxis = XMVectorMultiplyAdd(vx, dx, XMVectorMultiplyAdd(vy, dy, XMVectorMultiply(vz, dz)));
+                    const XMVECTOR fromAxis = XMVectorSqrt(XMVectorMax(XMVectorSubtract(lengthSq, XMVectorMultiply(alongAxis, alongAxis)), zero));
+
+                    /*distance of the sphere center to the cone surface*/
+                    const XMVECTOR toCone = XMVectorSubtract(XMVectorMultiply(cosCone, fromAxis), XMVectorMultiply(alongAxis, sinCone));
+
+                    XMVECTOR outside = XMVectorGreater(toCone, sphereRadius);
+                    outside = XMVectorOrInt(outside, XMVectorGreater(alongAxis, XMVectorAdd(sphereRadius, range)));
+                    outside = XMVectorOrInt(outside, XMVectorAndInt(backCull, XMVectorLess(alongAxis, XMVectorNegate(sphereRadius))));
+
+                    inside = XMVectorAndCInt(inside, outside);
+                }
+
+                const int hits = moveMask(inside);
+
+                if (hits == 0) continue;
+
+                for (unsigned int lane = 0; lane < 4; lane++)
+                {
+                    if (hits & (1 << lane))
+                    {
+                        pairCluster.push_back(index + lane);
+                        pairLight.push_back((std::uint16_t)i);
+                        clusterOffsets[(size_t)index + lane + 1]++;
+                    }
+                }
+
+                touched = true;
+            }
+        }
+
+        if (touched)
+        {
+            visibleLights.push_back(i);
+        }
+    }
+
+    /*counts to offsets*/
+    for (unsigned int c = 1; c <= CLUSTER_COUNT; c++)
+    {
+        clusterOffsets[c] += clusterOffsets[c - 1];
+    }
+
+    /*scatter, lights are processed in ascending order so every cluster list stays sorted*/
+    clusterCursor.assign(clusterOffsets.begin(), clusterOffsets.end() - 1);
+    clusterLightIndices.resize(pairCluster.size());
+
+    for (size_t p = 0; p < pairCluster.size(); p++)
+    {
+        clusterLightIndices[clusterCursor[pairCluster[p]]++] = pairLight[p];
+    }
+}
+
+void LightClusters::selectNearest(const ClusterLight* lights, DirectX::FXMVECTOR eye, unsigned int first, unsigned int last, unsigned int slots,
+                                  std::vector<unsigned int>& selected)
+{
+    selected.clear();
+    selectedDistance.clear();
+
+    if (slots == 0) return;
+
+    /*the visible lights are ascending, equal distances keep that order*/
+    for (const auto i : visibleLights)
+    {
+        if (i < first || i >= last) continue;
+
+        const float distance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&lights[i].position), eye)));
+
+        if (selected.size() == slots && distance >= selectedDistance.back()) continue;
+
+        /*insertion into the small sorted list*/
+        if (selected.size() < slots)
+        {
+            selected.push_back(i);
+            selectedDistance.push_back(distance);
+        }
+
+        size_t j = selected.size() - 1;
+
+        while (j > 0 && selectedDistance[j - 1] > distance)
+        {
+            selected[j] = selected[j - 1];
+            selectedDistance[j] = selectedDistance[j - 1];
+            j--;
+        }
+
+        selected[j] = i;
+        selectedDistance[j] = distance;
+    }
+}
+
+unsigned int LightClusters::getClusterLights(unsigned int x, unsigned int y, unsigned int z, const std::uint16_t*& indices) const
+{
+    indices = nullptr;
+
+    if (x >= TILES_X || y >= TILES_Y || z >= SLICES || clusterOffsets.empty()) return 0;
+
+    const unsigned int index = z * TILES_PER_SLICE + y * TILES_X + x;
+    const unsigned int first = clusterOffsets[index];
+
+    indices = clusterLightIndices.data() + first;
+    return clusterOffsets[(size_t)index + 1] - first;
+}
+
+int LightClusters::getClusterIndex(const DirectX::XMFLOAT3& viewPos) const
+{
+    if (minX.empty() || viewPos.z < 0.0f || viewPos.z > mFarZ) return -1;
+
+    const unsigned int s = sliceFromDepth(viewPos.z);
+    const float tanHalfY = std::tan(0.5f * mFovY);
+    const float tanHalfX = mAspect * tanHalfY;
+
+    /*guard against the camera position itself*/
+    const float z = (std::max)(viewPos.z, 0.0001f);
+    const float ndcX = viewPos.x / (z * tanHalfX);
+    const float ndcY = viewPos.y / (z * tanHalfY);
+
+    if (ndcX < -1.0f || ndcX > 1.0f || ndcY < -1.0f || ndcY > 1.0f) return -1;
+
+    const unsigned int tx = (std::min)((unsigned int)((ndcX + 1.0f) * 0.5f * TILES_X), TILES_X - 1);
+    const unsigned int ty = (std::min)((unsigned int)((1.0f - ndcY) * 0.5f * TILES_Y), TILES_Y - 1);
+
+    return (int)(s * TILES_PER_SLICE + ty * TILES_X + tx);
+}
+
+unsigned int LightClusters::sliceFromDepth(float z) const
+{
+    if (z <= mNearZ) return 0;
+
+    const unsigned int s = 1 + (unsigned int)(std::log(z / mNearZ) * invLogFarNear);
+    return (std::min)(s, SLICES - 1);
+}
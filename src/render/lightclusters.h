@@ -0,0 +1,150 @@
+#pragma once
+
+#include "../util/mathhelper.h"
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+/*
+bounds of a point or spot light for the light clusters, a point light is a spot light with a cone of 360 degrees
+*/
+struct ClusterLight
+{
+    /*world space position and range (falloff end) of the light*/
+    DirectX::XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+    float range = 0.0f;
+
+    /*normalised world space direction of a spot light*/
+    DirectX::XMFLOAT3 direction = { 0.0f, -1.0f, 0.0f };
+
+    /*cosine of the half angle of the spot cone, -1 for point lights*/
+    float cosCone = -1.0f;
+
+    /*
+    @param spot power of the light, the spot factor is max(cos, 0)^power
+    @returns cosine of the angle where the spot factor drops below 1/256
+    */
+    static float spotCone(float spotPower)
+    {
+        return spotPower > 0.0f ? std::pow(1.0f / 256.0f, 1.0f / spotPower) : 0.0f;
+    }
+};
+
+/*
+bins point and spot lights into a view space cluster grid (tiles in x/y, exponential slices in z)
+and stores a compact light index list per cluster, so the amount of lights is not limited by a fixed light array.
+does not depend on the level or the renderer.
+*/
+class LightClusters
+{
+public:
+
+    static constexpr unsigned int TILES_X = 16;
+    static constexpr unsigned int TILES_Y = 8;
+    static constexpr unsigned int SLICES = 24;
+    static constexpr unsigned int TILES_PER_SLICE = TILES_X * TILES_Y;
+    static constexpr unsigned int CLUSTER_COUNT = TILES_PER_SLICE * SLICES;
+
+    /*the index lists store 16 bit light indices*/
+    static constexpr unsigned int MAX_CLUSTERED_LIGHTS = UINT16_MAX + 1;
+
+    /*default constructor*/
+    explicit LightClusters() = default;
+
+    /*default destructor*/
+    ~LightClusters() = default;
+
+    /*
+    builds the view space bounds of all clusters, does nothing if the projection did not change
+    @param vertical field of view
+    @param aspect ratio
+    @param depth at which the first exponential slice starts (everything closer is slice 0)
+    @param depth at which the last slice ends
+    */
+    void build(float fovY, float aspect, float nearZ, float farZ);
+
+    /*
+    assigns the lights to all clusters they intersect, lights after MAX_CLUSTERED_LIGHTS are ignored
+    @param lights in world space
+    @param amount of lights
+    @param view matrix of the camera
+    */
+    void assign(const ClusterLight* lights, unsigned int count, DirectX::FXMMATRIX view);
+
+    /*
+    @param cluster coordinates
+    @param pointer to the light indices of the cluster will be stored here, ascending
+    @returns amount of lights in the cluster
+    */
+    unsigned int getClusterLights(unsigned int x, unsigned int y, unsigned int z, const std::uint16_t*& indices) const;
+
+    /*
+    @param position in view space
+    @returns index of the cluster that contains the position or -1
+    */
+    int getClusterIndex(const DirectX::XMFLOAT3& viewPos) const;
+
+    /*
+    @returns indices of all lights that intersect at least one cluster, ascending
+    */
+    const std::vector<unsigned int>& getVisibleLights() const
+    {
+        return visibleLights;
+    }
+
+    /*
+    picks the nearest visible lights of the last assign for a fixed amount of light slots,
+    the candidates are kept in a small sorted list so the full light list is never sorted
+    @param lights of the last assign
+    @param world space position the distances are measured from
+    @param first light index that is a candidate
+    @param end of the candidate light indices
+    @param amount of slots
+    @param receives the light indices, nearest first and in the order of the lights for equal distances
+    */
+    void selectNearest(const ClusterLight* lights, DirectX::FXMVECTOR eye, unsigned int first, unsigned int last, unsigned int slots,
+                       std::vector<unsigned int>& selected);
+
+    /*
+    @returns amount of light indices stored over all clusters
+    */
+    unsigned int getTotalLightIndices() const
+    {
+        return (unsigned int)clusterLightIndices.size();
+    }
+
+private:
+
+    unsigned int sliceFromDepth(float z) const;
+
+    /*cluster bounds as structure of arrays, the z bounds are shared by all tiles of a slice*/
+    std::vector<float> minX;
+    std::vector<float> maxX;
+    std::vector<float> minY;
+    std::vector<float> maxY;
+    std::array<float, SLICES + 1> sliceBounds{};
+
+    /*bounding spheres of the clusters for the spot cone test*/
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+
+    /*clusterOffsets[i] to clusterOffsets[i+1] is the range of cluster i in clusterLightIndices*/
+    std::vector<unsigned int> clusterOffsets;
+    std::vector<unsigned int> clusterCursor;
+    std::vector<std::uint16_t> clusterLightIndices;
+    std::vector<unsigned int> visibleLights;
+
+    /*temporary cluster/light pairs and slot distances, kept as members to avoid per frame allocations*/
+    std::vector<unsigned int> pairCluster;
+    std::vector<std::uint16_t> pairLight;
+    std::vector<float> selectedDistance;
+
+    float mFovY = 0.0f;
+    float mAspect = 0.0f;
+    float mNearZ = 1.0f;
+    float mFarZ = 512.0f;
+    float invLogFarNear = 0.0f;
+};
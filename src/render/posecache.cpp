@@ -0,0 +1,193 @@
+#include "posecache.h"
+#include "../util/jobsystem.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+void PoseCache::setup(float step, unsigned int phaseCount)
+{
+    timeStep = (std::max)(step, 0.0f);
+    phases = phaseCount;
+
+    beginFrame(totalTime);
+}
+
+void PoseCache::beginFrame(float time)
+{
+    totalTime = time;
+    frame++;
+
+    std::fill(tablePalettes.begin(), tablePalettes.end(), UINT_MAX);
+    used = 0;
+    shared = 0;
+}
+
+void PoseCache::evaluate(const std::vector<AnimationInstance*>& instances, const std::vector<BonePalette>& uploads, JobSystem* jobs)
+{
+    uniqueRequests.clear();
+    sharedRequests.clear();
+
+    /*the table is only touched here, the jobs below never look up or insert keys*/
+    for (unsigned int i = 0; i < (unsigned int)instances.size(); i++)
+    {
+        request(instances[i], i);
+    }
+
+    auto upload = [&uploads](unsigned int item)
+    {
+        return item < uploads.size() ? uploads[item] : BonePalette();
+    };
+
+    auto evaluateUnique = [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i = first; i < last; i++)
+        {
+            const Request& r = uniqueRequests[i];
+            AnimationInstance* instance = instances[r.item];
+            auto& finalTransforms = instance->finalTransforms;
+
+            instance->rig->calculateFinalTransforms(instance->skinningScratch, instance->currentClip, r.time, &instance->keyCursors,
+                                                    instance->animatedBoneDepth, &instance->animationBlend,
+                                                    { finalTransforms.data(), (unsigned int)finalTransforms.size() }, upload(r.item));
+
+            /*sized when the request was made, so no job allocates*/
+            if (r.palette != UINT_MAX)
+            {
+                std::copy(finalTransforms.begin(), finalTransforms.end(), palettes[r.palette].begin());
+            }
+        }
+    };
+
+    auto copyShared = [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int i = first; i < last; i++)
+        {
+            const Request& r = sharedRequests[i];
+            const auto& palette = palettes[r.palette];
+            const BonePalette destination = upload(r.item);
+
+            std::copy(palette.begin(), palette.end(), instances[r.item]->finalTransforms.begin());
+
+            if (destination.transforms)
+            {
+                std::copy_n(palette.begin(), (std::min)(destination.count, (unsigned int)palette.size()), destination.transforms);
+            }
+        }
+    };
+
+    if (jobs)
+    {
+        jobs->parallelFor((unsigned int)uniqueRequests.size(), 2, evaluateUnique);
+        jobs->parallelFor((unsigned int)sharedRequests.size(), 16, copyShared);
+    }
+    else
+    {
+        evaluateUnique(0, (unsigned int)uniqueRequests.size());
+        copyShared(0, (unsigned int)sharedRequests.size());
+    }
+}
+
+bool PoseCache::request(AnimationInstance* instance, unsigned int item)
+{
+    AnimationClip* clip = instance->currentClip;
+    float time = instance->animationTimer;
+
+    /*blended poses are unique to their instance*/
+    if (clip == nullptr || timeStep <= 0.0f || instance->animationBlend.isActive())
+    {
+        uniqueRequests.push_back({ item, UINT_MAX, time });
+        return true;
+    }
+
+    if (phases > 0)
+    {
+        time = snapToPhase(clip, time);
+    }
+
+    /*every instance samples at the quantised time, so a shared pose is the same for all of them*/
+    const std::int64_t step = std::llround(time / timeStep);
+    time = (float)step * timeStep;
+
+    if ((used + 1) * 2 > tableKeys.size())
+    {
+        grow();
+    }
+
+    const Key key{ instance->rig, clip, step, instance->animatedBoneDepth };
+    unsigned int& entry = find(key);
+
+    if (entry != UINT_MAX)
+    {
+        sharedRequests.push_back({ item, entry, time });
+        shared++;
+        return false;
+    }
+
+    entry = used++;
+
+    if (entry == palettes.size())
+    {
+        palettes.emplace_back();
+        paletteKeys.emplace_back();
+    }
+
+    /*same size every frame for the same key, no allocation after the first frames*/
+    palettes[entry].resize(instance->finalTransforms.size());
+    paletteKeys[entry] = key;
+
+    uniqueRequests.push_back({ item, entry, time });
+    return true;
+}
+
+unsigned int& PoseCache::find(const Key& key)
+{
+    const size_t mask = tableKeys.size() - 1;
+    size_t i = key.hash() & mask;
+
+    while (tablePalettes[i] != UINT_MAX && !(tableKeys[i] == key))
+    {
+        i = (i + 1) & mask;
+    }
+
+    tableKeys[i] = key;
+
+    return tablePalettes[i];
+}
+
+void PoseCache::grow()
+{
+    const size_t size = (std::max)(tableKeys.size() * 2, (size_t)64);
+
+    tableKeys.assign(size, Key());
+    tablePalettes.assign(size, UINT_MAX);
+
+    for (unsigned int i = 0; i < used; i++)
+    {
+        find(paletteKeys[i]) = i;
+    }
+}
+
+float PoseCache::snapToPhase(AnimationClip* clip, float time) const
+{
+    const float duration = clip->getEndTime();
+
+    if (duration <= 0.0f)
+    {
+        return time;
+    }
+
+    /*offset of the instance to the shared clock, rounded to the closest phase*/
+    const float phaseLength = duration / phases;
+
+    float offset = std::fmod(time - totalTime, duration);
+
+    if (offset < 0.0f)
+    {
+        offset += duration;
+    }
+
+    offset = std::round(offset / phaseLength) * phaseLength;
+
+    return std::fmod(std::fmod(totalTime, duration) + offset, duration);
+}
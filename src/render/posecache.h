@@ -0,0 +1,133 @@
+#pragma once
+
+#include "animation.h"
+#include <functional>
+#include <cstdint>
+
+class JobSystem;
+
+/*
+bone palettes of the current frame keyed by skinned model, clip, quantised animation time and bone mask.
+instances that play the same clip at the same quantised time evaluate their pose once and copy it from then on,
+so the cost of skinning scales with the amount of unique poses instead of the amount of characters.
+with animation instancing the time of every instance is additionally snapped to one of a few phases per clip.
+the table and palettes are reused every frame, after the first frames evaluating poses does not allocate.
+*/
+class PoseCache
+{
+public:
+
+    /*default constructor*/
+    explicit PoseCache() = default;
+
+    /*default destructor*/
+    ~PoseCache() = default;
+
+    /*
+    @param seconds of animation time that share one pose, 0 disables the cache
+    @param amount of phases per clip instances are snapped to, 0 disables animation instancing
+    */
+    void setup(float timeStep, unsigned int phases);
+
+    /*
+    starts a new frame, the poses of the previous frame are discarded
+    @param total game time, the shared clock of the phases
+    */
+    void beginFrame(float totalTime);
+
+    /*
+    writes the poses of instances into their final transforms.
+    the instances are grouped by pose on the calling thread, then every unique pose is evaluated
+    and copied to the instances sharing it in parallel, each job only writes to its own instance and palette
+    @param instances with rig, current clip, animation time and key cursors, every instance at most once
+    @param optional second destination of the bone matrices per instance, e.g. the mapped constant buffer of the current frame
+    @param job system to run on, nullptr evaluates on the calling thread
+    */
+    void evaluate(const std::vector<AnimationInstance*>& instances, const std::vector<BonePalette>& uploads, JobSystem* jobs);
+
+    unsigned int getUniquePoses() const
+    {
+        return used;
+    }
+
+    unsigned int getSharedPoses() const
+    {
+        return shared;
+    }
+
+    /*@returns number of the current frame, used to spread animation updates over frames*/
+    unsigned int getFrame() const
+    {
+        return frame;
+    }
+
+private:
+
+    struct Key
+    {
+        const SkinnedRig* rig = nullptr;
+        const AnimationClip* clip = nullptr;
+        std::int64_t step = 0;
+        unsigned int boneDepth = 0;
+
+        bool operator==(const Key& other) const
+        {
+            return rig == other.rig && clip == other.clip && step == other.step && boneDepth == other.boneDepth;
+        }
+
+        size_t hash() const
+        {
+            size_t hash = std::hash<const void*>()(rig);
+            hash ^= std::hash<const void*>()(clip) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<std::int64_t>()(step) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<unsigned int>()(boneDepth) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+
+    /*
+    @param key of a pose
+    @returns palette index of the key in the table, UINT_MAX in a free entry that now belongs to the key
+    */
+    unsigned int& find(const Key& key);
+
+    /*doubles the table and inserts the keys of the current frame again*/
+    void grow();
+
+    /*@returns time of the phase closest to the time of the instance*/
+    float snapToPhase(AnimationClip* clip, float time) const;
+
+    /*pose of one instance in the current evaluation*/
+    struct Request
+    {
+        unsigned int item = 0;
+        unsigned int palette = UINT_MAX;
+        float time = 0.0f;
+    };
+
+    /*
+    groups an instance with the other instances of the frame
+    @param index of the instance
+    @returns true if the pose has to be evaluated, false if it is copied from another instance
+    */
+    bool request(AnimationInstance* instance, unsigned int item);
+
+    /*first instances of their pose and instances copying a pose, reused every frame*/
+    std::vector<Request> uniqueRequests;
+    std::vector<Request> sharedRequests;
+
+    /*open addressing table with a power of two size, at most half full*/
+    std::vector<Key> tableKeys;
+    std::vector<unsigned int> tablePalettes;
+
+    /*palettes of all frames so far, the first used ones belong to the current frame*/
+    std::vector<std::vector<DirectX::XMFLOAT4X4>> palettes;
+    std::vector<Key> paletteKeys;
+    unsigned int used = 0;
+    unsigned int shared = 0;
+
+    float timeStep = 0.0f;
+    unsigned int phases = 0;
+    float totalTime = 0.0f;
+    unsigned int frame = 0;
+};
@@ -0,0 +1,402 @@
+#include "posesampler.h"
+#include "animation.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+bool PoseSampler::build(const std::vector<BoneAnimation>& bones)
+{
+    times.clear();
+    keys.clear();
+    referencePose.resize(0);
+    boneCount = (unsigned int)bones.size();
+    groupCount = (boneCount + 3) / 4;
+    tracks.assign((size_t)groupCount * 4, Track());
+
+    auto sameKey = [](const KeyFrame& a, const KeyFrame& b)
+    {
+        return a.translation.x == b.translation.x && a.translation.y == b.translation.y && a.translation.z == b.translation.z &&
+               a.scale.x == b.scale.x && a.scale.y == b.scale.y && a.scale.z == b.scale.z &&
+               a.rotationQuat.x == b.rotationQuat.x && a.rotationQuat.y == b.rotationQuat.y &&
+               a.rotationQuat.z == b.rotationQuat.z && a.rotationQuat.w == b.rotationQuat.w;
+    };
+
+    for (unsigned int b = 0; b < boneCount; b++)
+    {
+        const std::vector<KeyFrame>& keyFrames = bones[b].keyFrames;
+
+        if (bones[b].isEmpty || keyFrames.empty())
+        {
+            continue;
+        }
+
+        /*a bone that never moves needs only one key*/
+        const bool still = std::all_of(keyFrames.begin(), keyFrames.end(), [&](const KeyFrame& k) { return sameKey(k, keyFrames.front()); });
+        const size_t count = still ? 1 : keyFrames.size();
+
+        tracks[b].first = (unsigned int)keys.size();
+        tracks[b].count = (unsigned int)count;
+
+        for (size_t k = 0; k < count; k++)
+        {
+            times.push_back(keyFrames[k].timeStamp);
+            keys.push_back({ keyFrames[k].translation, keyFrames[k].scale, keyFrames[k].rotationQuat });
+        }
+    }
+
+    if (keys.empty())
+    {
+        return false;
+    }
+
+    /*start of the clip, the reference of additive layers*/
+    sample(*std::min_element(times.begin(), times.end()), referencePose, nullptr);
+
+    return true;
+}
+
+unsigned int PoseSampler::findKey(const float* keyTimes, unsigned int count, float time, unsigned int& cursor)
+{
+    const unsigned int lastInterval = count - 2;
+
+    if (cursor > lastInterval)
+    {
+        cursor = 0;
+    }
+
+    /*playback usually stays in the same interval or moves on to the next one*/
+    if (time >= keyTimes[cursor])
+    {
+        if (time <= keyTimes[(size_t)cursor + 1])
+        {
+            return cursor;
+        }
+
+        if (cursor < lastInterval && time <= keyTimes[(size_t)cursor + 2])
+        {
+            return ++cursor;
+        }
+    }
+
+    /*seek or loop, first key after time*/
+    const float* next = std::upper_bound(keyTimes, keyTimes + count, time);
+
+    cursor = (unsigned int)std::clamp<std::ptrdiff_t>((next - keyTimes) - 1, 0, lastInterval);
+
+    return cursor;
+}
+
+void PoseSampler::sample(float time, LocalPose& pose, unsigned int* cursors, RotationBlend blend) const
+{
+    if (pose.boneCount != boneCount)
+    {
+        pose.resize(boneCount);
+    }
+
+    /*padding and bones without keys keep the identity transform*/
+    static const Key identity = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f) };
+
+    for (unsigned int g = 0; g < groupCount; g++)
+    {
+        /*every bone finds its own key interval, the lanes are transposed into the pose afterwards*/
+        XMMATRIX translation, scale, q0, q1;
+        XMFLOAT4A t(0.0f, 0.0f, 0.0f, 0.0f);
+
+        for (unsigned int lane = 0; lane < 4; lane++)
+        {
+            const unsigned int bone = g * 4 + lane;
+            const Track& track = tracks[bone];
+
+            const Key* k0 = &identity;
+            const Key* k1 = &identity;
+
+            if (track.count > 0)
+            {
+                const float* keyTimes = &times[track.first];
+                const unsigned int last = track.count - 1;
+
+                k0 = k1 = &keys[track.first];
+
+                /*outside of the track or a single key, copy a key*/
+                if (time >= keyTimes[last])
+                {
+                    k0 = k1 = &keys[(size_t)track.first + last];
+                }
+                else if (time > keyTimes[0])
+                {
+                    unsigned int scratch = 0;
+                    const unsigned int i = findKey(keyTimes, track.count, time, cursors ? cursors[bone] : scratch);
+
+                    k0 = &keys[(size_t)track.first + i];
+                    k1 = k0 + 1;
+                    reinterpret_cast<float*>(&t)[lane] = (time - keyTimes[i]) / (keyTimes[(size_t)i + 1] - keyTimes[i]);
+                }
+            }
+
+            const float lerp = reinterpret_cast<float*>(&t)[lane];
+
+            translation.r[lane] = XMVectorLerp(XMLoadFloat3(&k0->translation), XMLoadFloat3(&k1->translation), lerp);
+            scale.r[lane] = XMVectorLerp(XMLoadFloat3(&k0->scale), XMLoadFloat3(&k1->scale), lerp);
+            q0.r[lane] = XMLoadFloat4(&k0->rotation);
+            q1.r[lane] = XMLoadFloat4(&k1->rotation);
+        }
+
+        translation = XMMatrixTranspose(translation);
+        scale = XMMatrixTranspose(scale);
+        q0 = XMMatrixTranspose(q0);
+        q1 = XMMatrixTranspose(q1);
+
+        XMVECTOR out[LocalPose::CHANNELS];
+
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            out[c] = translation.r[c];
+            out[c + 3] = scale.r[c];
+        }
+
+        blendRotations(q0.r, q1.r, XMLoadFloat4A(&t), blend, out + 6);
+        pose.store(g, out);
+    }
+}
+
+void PoseSampler::blendRotations(const XMVECTOR* q0, const XMVECTOR* q1, FXMVECTOR t, RotationBlend blend, XMVECTOR* result)
+{
+    if (blend == RotationBlend::Slerp)
+    {
+        /*one quaternion per row*/
+        const XMMATRIX from = XMMatrixTranspose(XMMATRIX(q0[0], q0[1], q0[2], q0[3]));
+        const XMMATRIX to = XMMatrixTranspose(XMMATRIX(q1[0], q1[1], q1[2], q1[3]));
+
+        XMMATRIX slerped;
+
+        for (int i = 0; i < 4; i++)
+        {
+            slerped.r[i] = XMQuaternionSlerp(from.r[i], to.r[i], XMVectorGetByIndex(t, i));
+        }
+
+        slerped = XMMatrixTranspose(slerped);
+
+        for (int i = 0; i < 4; i++)
+        {
+            result[i] = slerped.r[i];
+        }
+
+        return;
+    }
+
+    const XMVECTOR dot = XMVectorMultiplyAdd(q0[0], q1[0],
+                         XMVectorMultiplyAdd(q0[1], q1[1],
+                         XMVectorMultiplyAdd(q0[2], q1[2],
+                         XMVectorMultiply(q0[3], q1[3]))));
+
+    /*take the shorter way around*/
+    const XMVECTOR sign = XMVectorSelect(g_XMOne, g_XMNegativeOne, XMVectorLess(dot, XMVectorZero()));
+
+    XMVECTOR factor = t;
+
+    if (blend == RotationBlend::CorrectedNlerp)
+    {
+        /*polynomial fit of the slerp angle, the error stays far below what is visible on a skeleton*/
+        const XMVECTOR d = XMVectorAbs(dot);
+        const XMVECTOR a = XMVectorMultiplyAdd(d, XMVectorMultiplyAdd(d, XMVectorMultiplyAdd(d, XMVectorReplicate(-1.43519f), XMVectorReplicate(3.55645f)), XMVectorReplicate(-3.2452f)), XMVectorReplicate(1.0904f));
+        const XMVECTOR b = XMVectorMultiplyAdd(d, XMVectorMultiplyAdd(d, XMVectorReplicate(0.215638f), XMVectorReplicate(-1.06021f)), XMVectorReplicate(0.848013f));
+
+        const XMVECTOR centered = XMVectorSubtract(t, g_XMOneHalf);
+        const XMVECTOR k = XMVectorMultiplyAdd(a, XMVectorMultiply(centered, centered), b);
+
+        factor = XMVectorMultiplyAdd(XMVectorMultiply(XMVectorMultiply(t, centered), XMVectorSubtract(t, g_XMOne)), k, factor);
+    }
+
+    XMVECTOR lengthSq = XMVectorZero();
+
+    for (int c = 0; c < 4; c++)
+    {
+        result[c] = XMVectorMultiplyAdd(factor, XMVectorSubtract(XMVectorMultiply(q1[c], sign), q0[c]), q0[c]);
+        lengthSq = XMVectorMultiplyAdd(result[c], result[c], lengthSq);
+    }
+
+    const XMVECTOR invLength = XMVectorReciprocalSqrt(lengthSq);
+
+    for (int c = 0; c < 4; c++)
+    {
+        result[c] = XMVectorMultiply(result[c], invLength);
+    }
+}
+
+XMVECTOR PoseSampler::blendRotation(FXMVECTOR q0, FXMVECTOR q1, float t, RotationBlend blend)
+{
+    /*the same rotation in every lane*/
+    const XMVECTOR from[4] = { XMVectorSplatX(q0), XMVectorSplatY(q0), XMVectorSplatZ(q0), XMVectorSplatW(q0) };
+    const XMVECTOR to[4] = { XMVectorSplatX(q1), XMVectorSplatY(q1), XMVectorSplatZ(q1), XMVectorSplatW(q1) };
+
+    XMVECTOR result[4];
+    blendRotations(from, to, XMVectorReplicate(t), blend, result);
+
+    return XMVectorSet(XMVectorGetX(result[0]), XMVectorGetX(result[1]), XMVectorGetX(result[2]), XMVectorGetX(result[3]));
+}
+
+void PoseSampler::fillUnanimated(LocalPose& pose, const LocalPose& rest) const
+{
+    const unsigned int groups = (std::min)(groupCount, (std::min)(pose.groupCount(), rest.groupCount()));
+
+    for (unsigned int g = 0; g < groups; g++)
+    {
+        const Track* groupTracks = &tracks[(size_t)g * 4];
+
+        /*lanes with keys keep the sampled value*/
+        const XMVECTOR animatedLanes = XMVectorSelectControl(groupTracks[0].count > 0 ? 1 : 0, groupTracks[1].count > 0 ? 1 : 0,
+                                                             groupTracks[2].count > 0 ? 1 : 0, groupTracks[3].count > 0 ? 1 : 0);
+
+        XMVECTOR out[LocalPose::CHANNELS];
+        XMVECTOR in[LocalPose::CHANNELS];
+        pose.load(g, out);
+        rest.load(g, in);
+
+        for (unsigned int c = 0; c < LocalPose::CHANNELS; c++)
+        {
+            out[c] = XMVectorSelect(in[c], out[c], animatedLanes);
+        }
+
+        pose.store(g, out);
+    }
+}
+
+void PoseSampler::blendPoses(const LocalPose& from, const LocalPose& to, float weight, LocalPose& result)
+{
+    const unsigned int groups = (std::min)(from.groupCount(), to.groupCount());
+
+    if (result.boneCount != from.boneCount)
+    {
+        result.resize(from.boneCount);
+    }
+
+    for (unsigned int g = 0; g < groups; g++)
+    {
+        /*loaded before the store, result may alias one of the inputs*/
+        XMVECTOR a[LocalPose::CHANNELS];
+        XMVECTOR b[LocalPose::CHANNELS];
+        from.load(g, a);
+        to.load(g, b);
+
+        XMVECTOR out[LocalPose::CHANNELS];
+
+        /*translation and scale*/
+        for (unsigned int c = 0; c < 6; c++)
+        {
+            out[c] = XMVectorLerp(a[c], b[c], weight);
+        }
+
+        blendRotations(a + 6, b + 6, XMVectorReplicate(weight), RotationBlend::Nlerp, out + 6);
+        result.store(g, out);
+    }
+}
+
+void PoseSampler::addPose(LocalPose& pose, const LocalPose& additive, const LocalPose& reference, float weight)
+{
+    const unsigned int groups = (std::min)(pose.groupCount(), (std::min)(additive.groupCount(), reference.groupCount()));
+
+    const XMVECTOR w = XMVectorReplicate(weight);
+    const XMVECTOR identity[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), g_XMOne };
+
+    for (unsigned int g = 0; g < groups; g++)
+    {
+        XMVECTOR out[LocalPose::CHANNELS];
+        XMVECTOR add[LocalPose::CHANNELS];
+        XMVECTOR ref[LocalPose::CHANNELS];
+        pose.load(g, out);
+        additive.load(g, add);
+        reference.load(g, ref);
+
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            out[c] = XMVectorMultiplyAdd(w, XMVectorSubtract(add[c], ref[c]), out[c]);
+        }
+
+        for (unsigned int c = 3; c < 6; c++)
+        {
+            out[c] = XMVectorMultiply(out[c], XMVectorLerp(g_XMOne, XMVectorDivide(add[c], ref[c]), weight));
+        }
+
+        /*delta = conjugate(reference) * additive, so that reference * delta is the additive rotation*/
+        const XMVECTOR conjugate[4] = { XMVectorNegate(ref[6]), XMVectorNegate(ref[7]), XMVectorNegate(ref[8]), ref[9] };
+
+        XMVECTOR delta[4];
+        multiplyRotations(conjugate, add + 6, delta);
+
+        XMVECTOR weighted[4];
+        blendRotations(identity, delta, w, RotationBlend::Nlerp, weighted);
+
+        const XMVECTOR base[4] = { out[6], out[7], out[8], out[9] };
+        multiplyRotations(base, weighted, out + 6);
+
+        pose.store(g, out);
+    }
+}
+
+void PoseSampler::multiplyRotations(const XMVECTOR* a, const XMVECTOR* b, XMVECTOR* result)
+{
+    const XMVECTOR ax = a[0], ay = a[1], az = a[2], aw = a[3];
+    const XMVECTOR bx = b[0], by = b[1], bz = b[2], bw = b[3];
+
+    /*hamilton product, one rotation per lane*/
+    result[0] = XMVectorSubtract(XMVectorAdd(XMVectorMultiply(aw, bx), XMVectorMultiply(ax, bw)), XMVectorSubtract(XMVectorMultiply(az, by), XMVectorMultiply(ay, bz)));
+    result[1] = XMVectorAdd(XMVectorSubtract(XMVectorMultiply(aw, by), XMVectorMultiply(ax, bz)), XMVectorAdd(XMVectorMultiply(ay, bw), XMVectorMultiply(az, bx)));
+    result[2] = XMVectorAdd(XMVectorSubtract(XMVectorAdd(XMVectorMultiply(aw, bz), XMVectorMultiply(ax, by)), XMVectorMultiply(ay, bx)), XMVectorMultiply(az, bw));
+    result[3] = XMVectorSubtract(XMVectorSubtract(XMVectorMultiply(aw, bw), XMVectorMultiply(ax, bx)), XMVectorAdd(XMVectorMultiply(ay, by), XMVectorMultiply(az, bz)));
+}
+
+void PoseSampler::toMatrices(const LocalPose& pose, XMFLOAT4X4* matrices, unsigned int count, bool animatedOnly) const
+{
+    count = (std::min)(count, (std::min)(boneCount, pose.boneCount));
+
+    const XMVECTOR one = g_XMOne;
+    const XMVECTOR two = XMVectorReplicate(2.0f);
+
+    for (unsigned int g = 0; g * 4 < count; g++)
+    {
+        XMVECTOR ch[LocalPose::CHANNELS];
+        pose.load(g, ch);
+
+        const XMVECTOR x = ch[6], y = ch[7], z = ch[8], w = ch[9];
+
+        const XMVECTOR xx = XMVectorMultiply(x, x), yy = XMVectorMultiply(y, y), zz = XMVectorMultiply(z, z);
+        const XMVECTOR xy = XMVectorMultiply(x, y), xz = XMVectorMultiply(x, z), yz = XMVectorMultiply(y, z);
+        const XMVECTOR xw = XMVectorMultiply(x, w), yw = XMVectorMultiply(y, w), zw = XMVectorMultiply(z, w);
+
+        /*rotation rows like XMMatrixRotationQuaternion, each scaled like XMMatrixScaling * rotation*/
+        const XMVECTOR m00 = XMVectorMultiply(XMVectorNegativeMultiplySubtract(two, XMVectorAdd(yy, zz), one), ch[3]);
+        const XMVECTOR m01 = XMVectorMultiply(XMVectorMultiply(two, XMVectorAdd(xy, zw)), ch[3]);
+        const XMVECTOR m02 = XMVectorMultiply(XMVectorMultiply(two, XMVectorSubtract(xz, yw)), ch[3]);
+
+        const XMVECTOR m10 = XMVectorMultiply(XMVectorMultiply(two, XMVectorSubtract(xy, zw)), ch[4]);
+        const XMVECTOR m11 = XMVectorMultiply(XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, zz), one), ch[4]);
+        const XMVECTOR m12 = XMVectorMultiply(XMVectorMultiply(two, XMVectorAdd(yz, xw)), ch[4]);
+
+        const XMVECTOR m20 = XMVectorMultiply(XMVectorMultiply(two, XMVectorAdd(xz, yw)), ch[5]);
+        const XMVECTOR m21 = XMVectorMultiply(XMVectorMultiply(two, XMVectorSubtract(yz, xw)), ch[5]);
+        const XMVECTOR m22 = XMVectorMultiply(XMVectorNegativeMultiplySubtract(two, XMVectorAdd(xx, yy), one), ch[5]);
+
+        /*transpose so every row holds one matrix row of each bone*/
+        const XMMATRIX row0 = XMMatrixTranspose(XMMATRIX(m00, m01, m02, XMVectorZero()));
+        const XMMATRIX row1 = XMMatrixTranspose(XMMATRIX(m10, m11, m12, XMVectorZero()));
+        const XMMATRIX row2 = XMMatrixTranspose(XMMATRIX(m20, m21, m22, XMVectorZero()));
+        const XMMATRIX row3 = XMMatrixTranspose(XMMATRIX(ch[0], ch[1], ch[2], one));
+
+        for (unsigned int lane = 0; lane < 4; lane++)
+        {
+            const unsigned int bone = g * 4 + lane;
+
+            if (bone >= count)
+            {
+                break;
+            }
+
+            if (animatedOnly && tracks[bone].count == 0)
+            {
+                continue;
+            }
+
+            XMStoreFloat4x4(&matrices[bone], XMMATRIX(row0.r[lane], row1.r[lane], row2.r[lane], row3.r[lane]));
+        }
+    }
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+struct BoneAnimation;
+
+/*interpolation of the rotation between two keys*/
+enum class RotationBlend
+{
+    Slerp,          /*exact, one bone at a time*/
+    Nlerp,          /*normalized lerp, good enough for short key intervals*/
+    CorrectedNlerp  /*nlerp with a polynomial correction of the interpolation factor, very close to slerp*/
+};
+
+/*
+local transforms of all bones as structure of arrays, 4 bones per group.
+the channels of a group are translation x y z, scale x y z and rotation x y z w,
+stored as aligned floats and loaded into registers per group.
+*/
+struct LocalPose
+{
+    static constexpr unsigned int CHANNELS = 10;
+
+    std::vector<DirectX::XMFLOAT4A> channels;
+    unsigned int boneCount = 0;
+
+    void resize(unsigned int bones)
+    {
+        boneCount = bones;
+        channels.resize((size_t)groupCount() * CHANNELS);
+    }
+
+    unsigned int groupCount() const
+    {
+        return (boneCount + 3) / 4;
+    }
+
+    DirectX::XMFLOAT4A* group(unsigned int g)
+    {
+        return &channels[(size_t)g * CHANNELS];
+    }
+
+    const DirectX::XMFLOAT4A* group(unsigned int g) const
+    {
+        return &channels[(size_t)g * CHANNELS];
+    }
+
+    /*
+    @param group index
+    @param receives the CHANNELS channels of the group
+    */
+    void load(unsigned int g, DirectX::XMVECTOR* out) const
+    {
+        const DirectX::XMFLOAT4A* in = group(g);
+
+        for (unsigned int c = 0; c < CHANNELS; c++)
+        {
+            out[c] = DirectX::XMLoadFloat4A(&in[c]);
+        }
+    }
+
+    /*
+    @param group index
+    @param CHANNELS channels of the group
+    */
+    void store(unsigned int g, const DirectX::XMVECTOR* in)
+    {
+        DirectX::XMFLOAT4A* out = group(g);
+
+        for (unsigned int c = 0; c < CHANNELS; c++)
+        {
+            DirectX::XMStoreFloat4A(&out[c], in[c]);
+        }
+    }
+};
+
+/*
+keys of an animation clip, every sample interpolates 4 bones at once into a structure of arrays pose.
+every bone keeps its own keys, reduced keys of compressed clips stay reduced and bones that never move store a single key.
+*/
+class PoseSampler
+{
+public:
+
+    /*default constructor*/
+    explicit PoseSampler() = default;
+
+    /*default destructor*/
+    ~PoseSampler() = default;
+
+    /*
+    copies the keys of a clip, the bone animations are not needed for sampling afterwards
+    @param bone animations of the clip
+    @returns false if no bone is animated, the sampler stays empty then
+    */
+    bool build(const std::vector<BoneAnimation>& bones);
+
+    bool isValid() const
+    {
+        return !keys.empty();
+    }
+
+    unsigned int getBoneCount() const
+    {
+        return boneCount;
+    }
+
+    /*@returns pose at the start of the clip, additive layers add their difference to it*/
+    const LocalPose& getReferencePose() const
+    {
+        return referencePose;
+    }
+
+    /*
+    @param time in the clip
+    @param pose that receives the local transforms, resized if needed
+    @param one key cursor per bone of the instance, 0 for a new instance, nullptr searches every key without cursor
+    @param rotation interpolation
+    */
+    void sample(float time, LocalPose& pose, unsigned int* cursors, RotationBlend blend = RotationBlend::CorrectedNlerp) const;
+
+    /*
+    writes the local matrices of the animated bones, bones without animation are left untouched
+    @param sampled pose
+    @param local matrices indexed by bone
+    @param amount of matrices
+    @param false writes every bone, for poses that were blended with other clips
+    */
+    void toMatrices(const LocalPose& pose, DirectX::XMFLOAT4X4* matrices, unsigned int count, bool animatedOnly = true) const;
+
+    /*
+    replaces the bones without keys in a sampled pose, they hold the identity after sampling
+    @param sampled pose of this clip
+    @param pose the bones take instead, usually the bind pose
+    */
+    void fillUnanimated(LocalPose& pose, const LocalPose& rest) const;
+
+    /*
+    interpolates the rotations of 4 bones
+    @param rotation x y z w of the first key
+    @param rotation x y z w of the second key
+    @param interpolation factor per bone
+    @param rotation x y z w result
+    */
+    static void blendRotations(const DirectX::XMVECTOR* q0, const DirectX::XMVECTOR* q1, DirectX::FXMVECTOR t, RotationBlend blend, DirectX::XMVECTOR* result);
+
+    /*
+    interpolates a single rotation exactly like sample does, for tools that have to predict the sampled values
+    @param first rotation
+    @param second rotation
+    @param interpolation factor
+    @param rotation interpolation
+    @returns normalised rotation
+    */
+    static DirectX::XMVECTOR blendRotation(DirectX::FXMVECTOR q0, DirectX::FXMVECTOR q1, float t, RotationBlend blend = RotationBlend::CorrectedNlerp);
+
+    /*
+    crossfades two poses of the same skeleton, rotations take the shorter way
+    @param pose at weight 0
+    @param pose at weight 1
+    @param weight of the second pose
+    @param result, may be one of the inputs
+    */
+    static void blendPoses(const LocalPose& from, const LocalPose& to, float weight, LocalPose& result);
+
+    /*
+    adds the difference between an additive pose and its reference pose on top of a pose
+    @param pose that receives the difference
+    @param sampled pose of the additive clip
+    @param reference pose of the additive clip, usually its first key
+    @param weight of the difference
+    */
+    static void addPose(LocalPose& pose, const LocalPose& additive, const LocalPose& reference, float weight);
+
+private:
+
+    /*result = a * b for 4 rotations, b is applied first*/
+    static void multiplyRotations(const DirectX::XMVECTOR* a, const DirectX::XMVECTOR* b, DirectX::XMVECTOR* result);
+
+    /*
+    @param key times of one bone
+    @param amount of keys, at least 2
+    @param time between the first and last key
+    @param key cursor of the bone
+    @returns index of the key that starts the interval containing time, see BoneAnimation::interpolate
+    */
+    static unsigned int findKey(const float* keyTimes, unsigned int count, float time, unsigned int& cursor);
+
+    struct Key
+    {
+        DirectX::XMFLOAT3 translation;
+        DirectX::XMFLOAT3 scale;
+        DirectX::XMFLOAT4 rotation;
+    };
+
+    /*keys of one bone in times and keys, no keys if the bone is not animated*/
+    struct Track
+    {
+        unsigned int first = 0;
+        unsigned int count = 0;
+    };
+
+    /*per bone, padded to whole groups*/
+    std::vector<Track> tracks;
+
+    /*keys of all tracks back to back*/
+    std::vector<float> times;
+    std::vector<Key> keys;
+
+    LocalPose referencePose;
+    unsigned int boneCount = 0;
+    unsigned int groupCount = 0;
+};
@@ -135,7 +135,7 @@ bool RenderResource::init(ID3D12Device* _device, ID3D12GraphicsCommandList* _cmd
                 else
                 {
                     LOG(Severity::Warning, "Model " << entry.path().stem().string() << " uses non existing material " << e->materialName << "!");
-                    e->material = mMaterials["default"].get();
+                    e->material = mMaterials["default"_id].get();
                     e->materialName = "default";
                 }
 
@@ -180,7 +180,7 @@ bool RenderResource::init(ID3D12Device* _device, ID3D12GraphicsCommandList* _cmd
                 else
                 {
                     LOG(Severity::Warning, "Model " << entry.path().stem().string() << " uses non existing material " << e->materialName << "!");
-                    e->material = mMaterials["default"].get();
+                    e->material = mMaterials["default"_id].get();
                     e->materialName = "default";
                 }
 
@@ -206,6 +206,11 @@ bool RenderResource::init(ID3D12Device* _device, ID3D12GraphicsCommandList* _cmd
 
         if (tClip)
         {
+            if (!tClip->sampler.isValid())
+            {
+                LOG(Severity::Warning, "Clip " << tClip->name << " can not be sampled as structure of arrays, falling back to sampling per bone.");
+            }
+
             animCounter++;
             mAnimations[tClip->name] = std::move(tClip);
         }
@@ -218,6 +223,9 @@ bool RenderResource::init(ID3D12Device* _device, ID3D12GraphicsCommandList* _cmd
 
     LOG(Severity::Info, "Successfully loaded " << animCounter << " animation clips.");
 
+    poseCache.setup(ServiceProvider::getSettings()->graphicSettings.AnimationTimeStep,
+                    ServiceProvider::getSettings()->graphicSettings.AnimationPhases);
+
 
     /*also generate some default shapes*/
 
@@ -1304,11 +1312,17 @@ bool RenderResource::buildMaterials()
 void RenderResource::updateBuffers(const GameTime& gt)
 {
     updateGameObjectConstantBuffers(gt);
+    evaluatePoses();
     updateSkinnedDataBuffers(gt);
     updateMaterialConstantBuffers(gt);
     updateShadowTransform(gt);
     updateMainPassConstantBuffers(gt);
     updateShadowPassConstantBuffers(gt);
+
+    if (mFullUploadFrames > 0)
+    {
+        mFullUploadFrames--;
+    }
 }
 
 void RenderResource::setPSO(RenderType renderType)
@@ -1378,65 +1392,206 @@ void RenderResource::updateShadowTransform(const GameTime& gt)
     XMStoreFloat4x4(&mLightView, lightView);
     XMStoreFloat4x4(&mLightProj, lightProj);
     XMStoreFloat4x4(&mShadowTransform, S);
+
+    XMStoreFloat4x4(&mShadowViewProj, lightView * lightProj);
+    mHasShadowViewProj = true;
 }
 
-void RenderResource::updateGameObjectConstantBuffers(const GameTime& gt)
+void RenderResource::markDirty(RenderItem* rItem)
 {
-    auto currObjectCB = mCurrentFrameResource->ObjectCB.get();
+    std::lock_guard<std::mutex> lock(mDirtyLock);
 
-    const auto updateSingleCB = [&](RenderItem* rI)
+    for (UINT i = 0; i < mFrameResources.size(); i++)
     {
-        // Only update the cbuffer data if the constants have changed.
-        if (rI->NumFramesDirty > 0)
+        const UINT bit = 1u << i;
+
+        if ((rItem->QueuedFrameResources & bit) == 0)
         {
-            for (int i = 0; i < rI->getModel()->meshes.size(); i++)
+            rItem->QueuedFrameResources |= bit;
+            mFrameResources[i]->DirtyObjects.push_back(rItem);
+        }
+    }
+}
+
+void RenderResource::markDirty(Material* material)
+{
+    std::lock_guard<std::mutex> lock(mDirtyLock);
+
+    for (UINT i = 0; i < mFrameResources.size(); i++)
+    {
+        const UINT bit = 1u << i;
+
+        if ((material->QueuedFrameResources & bit) == 0)
+        {
+            material->QueuedFrameResources |= bit;
+            mFrameResources[i]->DirtyMaterials.push_back(material);
+        }
+    }
+}
+
+void RenderResource::requestPose(RenderItem* rItem)
+{
+    std::lock_guard<std::mutex> lock(mPoseLock);
+
+    mPoseRequests.push_back(rItem);
+}
+
+void RenderResource::evaluatePoses()
+{
+    auto currSkinnedCB = mCurrentFrameResource->SkinnedCB.get();
+
+    mPoseInstances.clear();
+    mPoseUploads.clear();
+
+    for (auto rItem : mPoseRequests)
+    {
+        mPoseInstances.push_back(&rItem->animation);
+        mPoseUploads.push_back({ reinterpret_cast<XMFLOAT4X4*>(currSkinnedCB->getMappedData(rItem->SkinnedCBIndex)),
+                                 (UINT)(sizeof(SkinnedConstants::BoneTransforms) / sizeof(XMFLOAT4X4)) });
+    }
+
+    poseCache.evaluate(mPoseInstances, mPoseUploads, ServiceProvider::getJobSystem());
+
+    std::lock_guard<std::mutex> lock(mDirtyLock);
+
+    for (auto rItem : mPoseRequests)
+    {
+        for (UINT i = 0; i < mFrameResources.size(); i++)
+        {
+            const UINT bit = 1u << i;
+
+            /*the current frame resource already has the new matrices*/
+            if (i == (UINT)mCurrentFrameResourceIndex) continue;
+
+            if ((rItem->QueuedSkinnedFrameResources & bit) == 0)
             {
-                XMMATRIX world = XMLoadFloat4x4(&rI->World);
+                rItem->QueuedSkinnedFrameResources |= bit;
+                mFrameResources[i]->DirtySkinned.push_back(rItem);
+            }
+        }
+    }
 
-                ObjectConstants objConstants;
-                XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
+    mPoseRequests.clear();
+}
 
-                if (rI->renderType == RenderType::Water)
-                {
-                    XMStoreFloat4x4(&objConstants.WorldInvTranspose, MathHelper::inverseTranspose(world));
-                }
-                else if (rI->renderType == RenderType::Terrain)
-                {
-                    XMMATRIX texTransform = XMLoadFloat4x4(&rI->TexTransform);
-                    XMStoreFloat4x4(&objConstants.WorldInvTranspose, texTransform);
-                }
+void RenderResource::markSkinnedDirty(RenderItem* rItem)
+{
+    std::lock_guard<std::mutex> lock(mDirtyLock);
 
-                if (rI->MaterialOverwrite != nullptr)
-                {
-                    objConstants.MaterialIndex = rI->MaterialOverwrite->MatCBIndex;
-                }
-                else
-                {
-                    objConstants.MaterialIndex = rI->getModel()->meshes[i]->material->MatCBIndex;
-                }
+    for (UINT i = 0; i < mFrameResources.size(); i++)
+    {
+        const UINT bit = 1u << i;
+
+        if ((rItem->QueuedSkinnedFrameResources & bit) == 0)
+        {
+            rItem->QueuedSkinnedFrameResources |= bit;
+            mFrameResources[i]->DirtySkinned.push_back(rItem);
+        }
+    }
+}
 
-                currObjectCB->copyData(rI->ObjCBIndex[i], objConstants);
+void RenderResource::updateGameObjectConstantBuffers(const GameTime& gt)
+{
+    auto currObjectCB = mCurrentFrameResource->ObjectCB.get();
+    auto& dirtyObjects = mCurrentFrameResource->DirtyObjects;
+    const UINT frameBit = 1u << mCurrentFrameResourceIndex;
+
+    /*queue everything after structural changes*/
+    if (mFullUploadFrames > 0)
+    {
+        const auto queueItem = [&](RenderItem* rI)
+        {
+            if ((rI->QueuedFrameResources & frameBit) == 0)
+            {
+                rI->QueuedFrameResources |= frameBit;
+                dirtyObjects.push_back(rI);
             }
+        };
+
+        if (!ServiceProvider::getSettings()->miscSettings.EditModeEnabled)
+        {
+            queueItem(ServiceProvider::getPlayer()->renderItem.get());
+        }
 
-            // Next FrameResource need to be updated too.
-            rI->NumFramesDirty--;
+        for (auto& go : ServiceProvider::getActiveLevel()->mGameObjects)
+        {
+            queueItem(go.second->renderItem.get());
         }
-    };
+    }
 
+    if (dirtyObjects.empty()) return;
 
-    /*update the players game object*/
-    if (!ServiceProvider::getSettings()->miscSettings.EditModeEnabled)
+    /*ascending cb index so neighbouring cbs can be copied together*/
+    std::sort(dirtyObjects.begin(), dirtyObjects.end(), [](const RenderItem* a, const RenderItem* b)
+              {
+                  return a->ObjCBIndex[0] < b->ObjCBIndex[0];
+              });
+
+    const UINT elementSize = currObjectCB->getElementByteSize();
+    int runStart = -1;
+    UINT runCount = 0;
+
+    const auto flush = [&]()
     {
-        updateSingleCB(ServiceProvider::getPlayer()->renderItem.get());
-    } 
+        if (runCount > 0)
+        {
+            currObjectCB->copyRange(runStart, mObjectStaging.data(), runCount);
+        }
 
+        runCount = 0;
+    };
 
-    /*update all game objects which are part of the level*/
-    for (auto& go : ServiceProvider::getActiveLevel()->mGameObjects)
+    for (auto rI : dirtyObjects)
     {
-        updateSingleCB(go.second->renderItem.get());
+        rI->QueuedFrameResources &= ~frameBit;
+
+        XMMATRIX world = XMLoadFloat4x4(&rI->World);
+
+        for (int i = 0; i < rI->getModel()->meshes.size(); i++)
+        {
+            ObjectConstants objConstants;
+            XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(world));
+
+            if (rI->renderType == RenderType::Water)
+            {
+                XMStoreFloat4x4(&objConstants.WorldInvTranspose, MathHelper::inverseTranspose(world));
+            }
+            else if (rI->renderType == RenderType::Terrain)
+            {
+                XMMATRIX texTransform = XMLoadFloat4x4(&rI->TexTransform);
+                XMStoreFloat4x4(&objConstants.WorldInvTranspose, texTransform);
+            }
+
+            if (rI->MaterialOverwrite != nullptr)
+            {
+                objConstants.MaterialIndex = rI->MaterialOverwrite->MatCBIndex;
+            }
+            else
+            {
+                objConstants.MaterialIndex = rI->getModel()->meshes[i]->material->MatCBIndex;
+            }
+
+            /*start a new batch if this cb does not follow the previous one*/
+            const int cbIndex = (int)rI->ObjCBIndex[i];
+
+            if (cbIndex != runStart + (int)runCount)
+            {
+                flush();
+                runStart = cbIndex;
+            }
+
+            if (mObjectStaging.size() < ((size_t)runCount + 1) * elementSize)
+            {
+                mObjectStaging.resize(((size_t)runCount + 1) * elementSize);
+            }
+
+            memcpy(&mObjectStaging[(size_t)runCount * elementSize], &objConstants, sizeof(ObjectConstants));
+            runCount++;
+        }
     }
 
+    flush();
+    dirtyObjects.clear();
 }
 
 
@@ -1444,41 +1599,80 @@ void RenderResource::updateGameObjectConstantBuffers(const GameTime& gt)
 void RenderResource::updateMaterialConstantBuffers(const GameTime& gt)
 {
     auto currMaterialBuffer = mCurrentFrameResource->MaterialBuffer.get();
-    for (auto& e : ServiceProvider::getRenderResource()->mMaterials)
+    auto& dirtyMaterials = mCurrentFrameResource->DirtyMaterials;
+    const UINT frameBit = 1u << mCurrentFrameResourceIndex;
+
+    if (mFullUploadFrames > 0)
     {
-        Material* mat = e.second.get();
-        if (mat->NumFramesDirty > 0)
+        for (auto& e : mMaterials)
         {
-            XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
-            XMMATRIX disp1Transform = XMLoadFloat4x4(&mat->DisplacementTransform0);
-            XMMATRIX disp2Transform = XMLoadFloat4x4(&mat->DisplacementTransform1);
-            XMMATRIX n0Transform = XMLoadFloat4x4(&mat->NormalTransform0);
-            XMMATRIX n1Transform = XMLoadFloat4x4(&mat->NormalTransform1);
-
-            MaterialData matData;
-            matData.DiffuseAlbedo = mat->DiffuseAlbedo;
-            matData.FresnelR0 = mat->FresnelR0;
-            matData.Roughness = mat->Roughness;
-            XMStoreFloat4x4(&matData.MatTransform, XMMatrixTranspose(matTransform));
-            XMStoreFloat4x4(&matData.DisplacementTransform0, XMMatrixTranspose(disp1Transform));
-            XMStoreFloat4x4(&matData.DisplacementTransform1, XMMatrixTranspose(disp2Transform));
-            XMStoreFloat4x4(&matData.NormalTransform0, XMMatrixTranspose(n0Transform));
-            XMStoreFloat4x4(&matData.NormalTransform1, XMMatrixTranspose(n1Transform));
-
-            matData.DiffuseMapIndex = mat->DiffuseSrvHeapIndex;
-            matData.NormalMapIndex = mat->NormalSrvHeapIndex;
-            matData.Displacement1Index = mat->Displacement1HeapIndex;
-            matData.Displacement2Index = mat->Displacement2HeapIndex;
-            matData.MiscTexture1Index = mat->MiscTexture1Index;
-            matData.MiscTexture2Index = mat->MiscTexture2Index;
-            matData.MiscFloat1 = mat->MiscFloat1;
-            matData.MiscFloat2 = mat->MiscFloat2;
-
-            currMaterialBuffer->copyData(mat->MatCBIndex, matData);
-
-            mat->NumFramesDirty--;
+            if ((e.second->QueuedFrameResources & frameBit) == 0)
+            {
+                e.second->QueuedFrameResources |= frameBit;
+                dirtyMaterials.push_back(e.second.get());
+            }
         }
     }
+
+    if (dirtyMaterials.empty()) return;
+
+    std::sort(dirtyMaterials.begin(), dirtyMaterials.end(), [](const Material* a, const Material* b)
+              {
+                  return a->MatCBIndex < b->MatCBIndex;
+              });
+
+    mMaterialStaging.resize(dirtyMaterials.size());
+    int runStart = -1;
+    UINT runCount = 0;
+
+    for (auto mat : dirtyMaterials)
+    {
+        mat->QueuedFrameResources &= ~frameBit;
+
+        XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+        XMMATRIX disp1Transform = XMLoadFloat4x4(&mat->DisplacementTransform0);
+        XMMATRIX disp2Transform = XMLoadFloat4x4(&mat->DisplacementTransform1);
+        XMMATRIX n0Transform = XMLoadFloat4x4(&mat->NormalTransform0);
+        XMMATRIX n1Transform = XMLoadFloat4x4(&mat->NormalTransform1);
+
+        /*start a new batch if this material does not follow the previous one*/
+        if (mat->MatCBIndex != runStart + (int)runCount)
+        {
+            if (runCount > 0)
+            {
+                currMaterialBuffer->copyRange(runStart, mMaterialStaging.data(), runCount);
+            }
+
+            runStart = mat->MatCBIndex;
+            runCount = 0;
+        }
+
+        MaterialData& matData = mMaterialStaging[runCount++];
+        matData.DiffuseAlbedo = mat->DiffuseAlbedo;
+        matData.FresnelR0 = mat->FresnelR0;
+        matData.Roughness = mat->Roughness;
+        XMStoreFloat4x4(&matData.MatTransform, XMMatrixTranspose(matTransform));
+        XMStoreFloat4x4(&matData.DisplacementTransform0, XMMatrixTranspose(disp1Transform));
+        XMStoreFloat4x4(&matData.DisplacementTransform1, XMMatrixTranspose(disp2Transform));
+        XMStoreFloat4x4(&matData.NormalTransform0, XMMatrixTranspose(n0Transform));
+        XMStoreFloat4x4(&matData.NormalTransform1, XMMatrixTranspose(n1Transform));
+
+        matData.DiffuseMapIndex = mat->DiffuseSrvHeapIndex;
+        matData.NormalMapIndex = mat->NormalSrvHeapIndex;
+        matData.Displacement1Index = mat->Displacement1HeapIndex;
+        matData.Displacement2Index = mat->Displacement2HeapIndex;
+        matData.MiscTexture1Index = mat->MiscTexture1Index;
+        matData.MiscTexture2Index = mat->MiscTexture2Index;
+        matData.MiscFloat1 = mat->MiscFloat1;
+        matData.MiscFloat2 = mat->MiscFloat2;
+    }
+
+    if (runCount > 0)
+    {
+        currMaterialBuffer->copyRange(runStart, mMaterialStaging.data(), runCount);
+    }
+
+    dirtyMaterials.clear();
 }
 
 void RenderResource::updateShadowPassConstantBuffers(const GameTime& gt)
@@ -1516,38 +1710,45 @@ void RenderResource::updateShadowPassConstantBuffers(const GameTime& gt)
 
 void RenderResource::updateSkinnedDataBuffers(const GameTime& gt)
 {
-
     auto currSkinnedCB = mCurrentFrameResource->SkinnedCB.get();
+    auto& dirtySkinned = mCurrentFrameResource->DirtySkinned;
+    const UINT frameBit = 1u << mCurrentFrameResourceIndex;
 
-    const auto updateSingleSkinnedCB = [&](const GameObject* gO)
+    if (mFullUploadFrames > 0)
     {
-        if (gO->gameObjectType != ObjectType::Skinned) return;
-
-        auto e = gO->renderItem.get();
-
-        SkinnedConstants skinnedConstants{};
+        const auto queueSkinned = [&](const GameObject* gO)
+        {
+            if (gO->gameObjectType != ObjectType::Skinned) return;
 
-        std::copy(
-            std::begin(e->finalTransforms),
-            std::end(e->finalTransforms),
-            &skinnedConstants.BoneTransforms[0]);
+            if ((gO->renderItem->QueuedSkinnedFrameResources & frameBit) == 0)
+            {
+                gO->renderItem->QueuedSkinnedFrameResources |= frameBit;
+                dirtySkinned.push_back(gO->renderItem.get());
+            }
+        };
 
-        currSkinnedCB->copyData(e->SkinnedCBIndex, skinnedConstants);
-    };
+        if (!ServiceProvider::getSettings()->miscSettings.EditModeEnabled)
+        {
+            queueSkinned(ServiceProvider::getPlayer());
+        }
 
-    /*update player*/
-    if (!ServiceProvider::getSettings()->miscSettings.EditModeEnabled)
-    {
-        updateSingleSkinnedCB(ServiceProvider::getPlayer());
+        for (auto& go : ServiceProvider::getActiveLevel()->mGameObjects)
+        {
+            queueSkinned(go.second.get());
+        }
     }
-    
 
-    /*update level related skinned buffer*/
-    for (auto& go : ServiceProvider::getActiveLevel()->mGameObjects)
+    /*bone matrices are copied straight from the render item, unused bones keep their old values.
+    items evaluated this frame already wrote into this frame resource in evaluatePoses()*/
+    for (auto e : dirtySkinned)
     {
-        updateSingleSkinnedCB(go.second.get());
+        e->QueuedSkinnedFrameResources &= ~frameBit;
+
+        currSkinnedCB->copyPartial(e->SkinnedCBIndex, e->animation.finalTransforms.data(),
+                                   (std::min)(e->animation.finalTransforms.size(), (size_t)96) * sizeof(XMFLOAT4X4));
     }
 
+    dirtySkinned.clear();
 }
 
 void RenderResource::updateMainPassConstantBuffers(const GameTime& gt)
@@ -1619,6 +1820,9 @@ void RenderResource::buildFrameResource()
                                   250000, /*terrain vertices*/
                                   MAX_PARTICLE_SYSTEMS));
     }
+
+    /*nothing was uploaded yet*/
+    markAllDirty();
 }
 
 void RenderResource::cycleFrameResource()
@@ -1699,8 +1903,8 @@ void RenderResource::generateDefaultShapes()
     mModels["box"] = std::move(m);
 
     /*box hitbox*/
-    XMStoreFloat3(&mModels["box"]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
-    XMStoreFloat3(&mModels["box"]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
+    XMStoreFloat3(&mModels["box"_id]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
+    XMStoreFloat3(&mModels["box"_id]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
 
     std::unique_ptr<Mesh> hitboxBox = std::make_unique<Mesh>();
 
@@ -1716,7 +1920,7 @@ void RenderResource::generateDefaultShapes()
     hitboxBox->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
                                                              cmdList, indices.data(), ibByteSize, hitboxBox->IndexBufferUploader);
 
-    mModels["box"]->boundingBoxMesh = std::move(hitboxBox);
+    mModels["box"_id]->boundingBoxMesh = std::move(hitboxBox);
 
     /*quad*/
 
@@ -1818,13 +2022,13 @@ void RenderResource::generateDefaultShapes()
     v.y = 0.025f;
     vMax = XMLoadFloat3(&v);
 
-    XMStoreFloat3(&mModels["grid"]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
-    XMStoreFloat3(&mModels["grid"]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
+    XMStoreFloat3(&mModels["grid"_id]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
+    XMStoreFloat3(&mModels["grid"_id]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
 
 
-    GeometryGenerator::MeshData boxMeshGrid = geoGen.CreateBox(mModels["grid"]->baseModelBox.Extents.x * 2.f,
-                                                               mModels["grid"]->baseModelBox.Extents.y * 2.f,
-                                                               mModels["grid"]->baseModelBox.Extents.z * 2.f,
+    GeometryGenerator::MeshData boxMeshGrid = geoGen.CreateBox(mModels["grid"_id]->baseModelBox.Extents.x * 2.f,
+                                                               mModels["grid"_id]->baseModelBox.Extents.y * 2.f,
+                                                               mModels["grid"_id]->baseModelBox.Extents.z * 2.f,
                                                                0);
     vertices.clear();
     vertices.resize(boxMeshGrid.Vertices.size());
@@ -1833,7 +2037,7 @@ void RenderResource::generateDefaultShapes()
 
     for (size_t i = 0; i < boxMeshGrid.Vertices.size(); i++)
     {
-        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshGrid.Vertices[i].Position), XMLoadFloat3(&mModels["grid"]->baseModelBox.Center)));
+        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshGrid.Vertices[i].Position), XMLoadFloat3(&mModels["grid"_id]->baseModelBox.Center)));
         vertices[i].Normal = boxMeshGrid.Vertices[i].Normal;
         vertices[i].TexC = boxMeshGrid.Vertices[i].TexC;
         vertices[i].TangentU = boxMeshGrid.Vertices[i].TangentU;
@@ -1858,7 +2062,7 @@ void RenderResource::generateDefaultShapes()
     hitboxGrid->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
                                                               cmdList, indices.data(), ibByteSize, hitboxGrid->IndexBufferUploader);
 
-    mModels["grid"]->boundingBoxMesh = std::move(hitboxGrid);
+    mModels["grid"_id]->boundingBoxMesh = std::move(hitboxGrid);
 
 
     /*water grid*/
@@ -1919,12 +2123,12 @@ void RenderResource::generateDefaultShapes()
     v.y = 0.025f;
     vMax = XMLoadFloat3(&v);
 
-    XMStoreFloat3(&mModels["watergrid"]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
-    XMStoreFloat3(&mModels["watergrid"]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
+    XMStoreFloat3(&mModels["watergrid"_id]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
+    XMStoreFloat3(&mModels["watergrid"_id]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
 
-    GeometryGenerator::MeshData boxMeshWGrid = geoGen.CreateBox(mModels["watergrid"]->baseModelBox.Extents.x * 2.f,
-                                                               mModels["watergrid"]->baseModelBox.Extents.y * 2.f,
-                                                               mModels["watergrid"]->baseModelBox.Extents.z * 2.f,
+    GeometryGenerator::MeshData boxMeshWGrid = geoGen.CreateBox(mModels["watergrid"_id]->baseModelBox.Extents.x * 2.f,
+                                                               mModels["watergrid"_id]->baseModelBox.Extents.y * 2.f,
+                                                               mModels["watergrid"_id]->baseModelBox.Extents.z * 2.f,
                                                                0);
     vertices.clear();
     vertices.resize(boxMeshWGrid.Vertices.size());
@@ -1933,7 +2137,7 @@ void RenderResource::generateDefaultShapes()
 
     for (size_t i = 0; i < boxMeshWGrid.Vertices.size(); i++)
     {
-        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshWGrid.Vertices[i].Position), XMLoadFloat3(&mModels["watergrid"]->baseModelBox.Center)));
+        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshWGrid.Vertices[i].Position), XMLoadFloat3(&mModels["watergrid"_id]->baseModelBox.Center)));
         vertices[i].Normal = boxMeshWGrid.Vertices[i].Normal;
         vertices[i].TexC = boxMeshWGrid.Vertices[i].TexC;
         vertices[i].TangentU = boxMeshWGrid.Vertices[i].TangentU;
@@ -1958,7 +2162,7 @@ void RenderResource::generateDefaultShapes()
     hitboxWGrid->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
                                                               cmdList, indices.data(), ibByteSize, hitboxWGrid->IndexBufferUploader);
 
-    mModels["watergrid"]->boundingBoxMesh = std::move(hitboxWGrid);
+    mModels["watergrid"_id]->boundingBoxMesh = std::move(hitboxWGrid);
 
 
     /*sphere*/
@@ -2012,12 +2216,12 @@ void RenderResource::generateDefaultShapes()
 
     /*sphere hitbox*/
 
-    XMStoreFloat3(&mModels["sphere"]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
-    XMStoreFloat3(&mModels["sphere"]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
+    XMStoreFloat3(&mModels["sphere"_id]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
+    XMStoreFloat3(&mModels["sphere"_id]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
 
-    GeometryGenerator::MeshData boxMeshSp = geoGen.CreateBox(mModels["sphere"]->baseModelBox.Extents.x * 2.f,
-                                                             mModels["sphere"]->baseModelBox.Extents.y * 2.f,
-                                                             mModels["sphere"]->baseModelBox.Extents.z * 2.f,
+    GeometryGenerator::MeshData boxMeshSp = geoGen.CreateBox(mModels["sphere"_id]->baseModelBox.Extents.x * 2.f,
+                                                             mModels["sphere"_id]->baseModelBox.Extents.y * 2.f,
+                                                             mModels["sphere"_id]->baseModelBox.Extents.z * 2.f,
                                                              0);
     vertices.clear();
     vertices.resize(boxMeshSp.Vertices.size());
@@ -2026,7 +2230,7 @@ void RenderResource::generateDefaultShapes()
 
     for (size_t i = 0; i < boxMeshSp.Vertices.size(); i++)
     {
-        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshSp.Vertices[i].Position), XMLoadFloat3(&mModels["sphere"]->baseModelBox.Center)));
+        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshSp.Vertices[i].Position), XMLoadFloat3(&mModels["sphere"_id]->baseModelBox.Center)));
         vertices[i].Normal = boxMeshSp.Vertices[i].Normal;
         vertices[i].TexC = boxMeshSp.Vertices[i].TexC;
         vertices[i].TangentU = boxMeshSp.Vertices[i].TangentU;
@@ -2051,7 +2255,7 @@ void RenderResource::generateDefaultShapes()
     hitboxSphere->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
                                                                 cmdList, indices.data(), ibByteSize, hitboxSphere->IndexBufferUploader);
 
-    mModels["sphere"]->boundingBoxMesh = std::move(hitboxSphere);
+    mModels["sphere"_id]->boundingBoxMesh = std::move(hitboxSphere);
 
     /*cylinder*/
 
@@ -2105,12 +2309,12 @@ void RenderResource::generateDefaultShapes()
 
     /*cylinder hitbox*/
 
-    XMStoreFloat3(&mModels["cylinder"]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
-    XMStoreFloat3(&mModels["cylinder"]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
+    XMStoreFloat3(&mModels["cylinder"_id]->baseModelBox.Center, 0.5f * XMVectorAdd(vMin, vMax));
+    XMStoreFloat3(&mModels["cylinder"_id]->baseModelBox.Extents, 0.5f * XMVectorSubtract(vMin, vMax));
 
-    GeometryGenerator::MeshData boxMeshCyl = geoGen.CreateBox(mModels["cylinder"]->baseModelBox.Extents.x * 2.f,
-                                                              mModels["cylinder"]->baseModelBox.Extents.y * 2.f,
-                                                              mModels["cylinder"]->baseModelBox.Extents.z * 2.f,
+    GeometryGenerator::MeshData boxMeshCyl = geoGen.CreateBox(mModels["cylinder"_id]->baseModelBox.Extents.x * 2.f,
+                                                              mModels["cylinder"_id]->baseModelBox.Extents.y * 2.f,
+                                                              mModels["cylinder"_id]->baseModelBox.Extents.z * 2.f,
                                                               0);
     vertices.clear();
     vertices.resize(boxMeshCyl.Vertices.size());
@@ -2119,7 +2323,7 @@ void RenderResource::generateDefaultShapes()
 
     for (size_t i = 0; i < boxMeshCyl.Vertices.size(); i++)
     {
-        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshCyl.Vertices[i].Position), XMLoadFloat3(&mModels["cylinder"]->baseModelBox.Center)));
+        XMStoreFloat3(&vertices[i].Pos, XMVectorAdd(XMLoadFloat3(&boxMeshCyl.Vertices[i].Position), XMLoadFloat3(&mModels["cylinder"_id]->baseModelBox.Center)));
         vertices[i].Normal = boxMeshCyl.Vertices[i].Normal;
         vertices[i].TexC = boxMeshCyl.Vertices[i].TexC;
         vertices[i].TangentU = boxMeshCyl.Vertices[i].TangentU;
@@ -2144,5 +2348,5 @@ void RenderResource::generateDefaultShapes()
     hitboxCyl->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(device,
                                                              cmdList, indices.data(), ibByteSize, hitboxCyl->IndexBufferUploader);
 
-    mModels["cylinder"]->boundingBoxMesh = std::move(hitboxCyl);
+    mModels["cylinder"_id]->boundingBoxMesh = std::move(hitboxCyl);
 }
\ No newline at end of file
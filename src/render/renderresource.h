@@ -2,6 +2,7 @@
 
 #include "../util/d3dUtil.h"
 #include "../util/geogen.h"
+#include "../util/idmap.h"
 #include "../core/camera.h"
 #include "../core/gametime.h"
 #include "../render/frameresource.h"
@@ -9,7 +10,9 @@
 #include "../render/rendertarget.h"
 #include "../render/sobel.h"
 #include "../render/blur.h"
+#include "../render/posecache.h"
 #include <filesystem>
+#include <mutex>
 
 inline const std::string MODEL_PATH = "data/model";
 inline const std::string TEXTURE_PATH = "data/texture";
@@ -57,6 +60,24 @@ public:
 
     void updateBuffers(const GameTime& gt);
 
+    /*queue changed data for the upload to every frame resource, can be called from update jobs*/
+    void markDirty(RenderItem* rItem);
+    void markDirty(Material* material);
+    void markSkinnedDirty(RenderItem* rItem);
+
+    /*
+    requests the pose of a skinned item for this frame, can be called from update jobs.
+    updateBuffers() evaluates all requested poses in parallel, the bone matrices are written straight
+    into the mapped constant buffer of the current frame resource and queued for the other frame resources
+    */
+    void requestPose(RenderItem* rItem);
+
+    /*upload all objects and materials again, needed after objects were added*/
+    void markAllDirty()
+    {
+        mFullUploadFrames = gNumFrameResources;
+    }
+
     void setPSO(RenderType renderType);
     void setPSO(ShadowRenderType renderType);
     void setPSO(PostProcessRenderType renderType);
@@ -78,11 +99,14 @@ public:
 
     /*resources*/
     std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
-    std::unordered_map<std::string, std::unique_ptr<Model>> mModels;
+    IdMap<Model> mModels;
     std::unordered_map<std::string, std::unique_ptr<SkinnedModel>> mSkinnedModels;
-    std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
+    IdMap<Material> mMaterials;
     std::unordered_map < std::string, std::unique_ptr<AnimationClip>> mAnimations;
 
+    /*poses of skinned objects shared within a frame*/
+    PoseCache poseCache;
+
     UINT mRtvDescriptorSize = 0;
     UINT mDsvDescriptorSize = 0;
     UINT mCbvSrvUavDescriptorSize = 0;
@@ -105,6 +129,14 @@ public:
         return mShadowMap.get();
     }
 
+    /*
+    @returns view projection matrix of the shadow map of the last frame, nullptr before the first update
+    */
+    const DirectX::XMFLOAT4X4* getShadowViewProj() const
+    {
+        return mHasShadowViewProj ? &mShadowViewProj : nullptr;
+    }
+
     RenderTarget* getRenderTarget()
     {
         return mRenderTarget.get();
@@ -179,6 +211,10 @@ private:
     DirectX::XMFLOAT4X4 mLightProj = MathHelper::identity4x4();
     DirectX::XMFLOAT4X4 mShadowTransform = MathHelper::identity4x4();
 
+    /*light view projection of the shadow map*/
+    DirectX::XMFLOAT4X4 mShadowViewProj = MathHelper::identity4x4();
+    bool mHasShadowViewProj = false;
+
     UINT mNullCubeSrvIndex = 0;
     UINT mNullTexSrvIndex = 0;
 
@@ -207,6 +243,22 @@ private:
     FrameResource* mCurrentFrameResource = nullptr;
     int mCurrentFrameResourceIndex = 0;
 
+    /*frames in which everything is queued for upload*/
+    int mFullUploadFrames = 0;
+
+    /*guards the dirty queues of the frame resources*/
+    std::mutex mDirtyLock;
+
+    /*skinned items whose pose is evaluated this frame and their destination in the skinned constant buffer*/
+    std::mutex mPoseLock;
+    std::vector<RenderItem*> mPoseRequests;
+    std::vector<AnimationInstance*> mPoseInstances;
+    std::vector<BonePalette> mPoseUploads;
+
+    /*staging memory for batched uploads of contiguous buffer ranges*/
+    std::vector<BYTE> mObjectStaging;
+    std::vector<MaterialData> mMaterialStaging;
+
     PassConstants mMainPassConstants;
     PassConstants mShadowPassConstants;
 
@@ -225,6 +277,9 @@ private:
     void updateShadowPassConstantBuffers(const GameTime& gt);
     void updateSkinnedDataBuffers(const GameTime& gt);
 
+    /*animation phase, evaluates the requested poses on the job system*/
+    void evaluatePoses();
+
 
     bool exists(const nlohmann::json& j, const std::string& key)
     {
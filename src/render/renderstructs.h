@@ -12,14 +12,13 @@
 #include <iostream>
 #include <sstream>
 #include "../util/mathhelper.h"
+#include "animation.h"
 #include "../extern/json.hpp"
 
 using json = nlohmann::json;
 
 /*structs for materials, textures etc.*/
 
-extern int gNumFrameResources;
-
 struct Material
 {
     // Unique material name for lookup.
@@ -40,7 +39,8 @@ struct Material
     int MiscTexture1Index = -1;
     int MiscTexture2Index = -1;
 
-    int NumFramesDirty = gNumFrameResources;
+    // One bit per frame resource whose dirty queue contains this material.
+    UINT QueuedFrameResources = 0;
 
     // Material constant buffer data used for shading.
     DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -75,6 +75,10 @@ struct Mesh
 
     UINT IndexCount = 0;
 
+    // Unique id, used to group draws of the same mesh.
+    UINT DrawId = nextDrawId++;
+    inline static UINT nextDrawId = 0;
+
     D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
     {
         D3D12_VERTEX_BUFFER_VIEW vbv{};
@@ -118,125 +122,11 @@ struct Model
 };
 
 
-/*animation clips*/
-struct KeyFrame
-{
-    explicit KeyFrame() : timeStamp(0.0f),
-        translation(0.0f, 0.0f, 0.0f),
-        scale(1.0f, 1.0f, 1.0f),
-        rotationQuat(0.0f, 0.0f, 0.0f, 1.0f)
-    {
-    }
-    ~KeyFrame() = default;
-
-    float timeStamp;
-    DirectX::XMFLOAT3 translation;
-    DirectX::XMFLOAT3 scale;
-    DirectX::XMFLOAT4 rotationQuat;
-};
-
-struct BoneAnimation
-{
-    std::vector<KeyFrame> keyFrames;
-    bool isEmpty = false;
-
-    float getStartTime() const
-    {
-        if (isEmpty) return D3D12_FLOAT32_MAX;
-
-        return keyFrames.front().timeStamp;
-    }
-
-    float getEndTime() const
-    {
-        if (isEmpty) return -D3D12_FLOAT32_MAX;
-
-        return keyFrames.back().timeStamp;
-    }
-
-    void interpolate(float time, DirectX::XMFLOAT4X4& matrix) const;
-    void interpolate(float time, KeyFrame& keyFrame) const;
-};
-
-
-struct AnimationClip
-{
-    std::vector<BoneAnimation> boneAnimations;
-    std::string name;
-
-private:
-    float startTime = -1.0f;
-    float endTime = -1.0f;
-
-public:
-
-    float getStartTime();
-    float getEndTime();
-    void interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms) const;
-    void interpolate(float t, std::vector<KeyFrame>& keyTransforms) const;
-};
-
-struct Node
-{
-    std::string name = "";
-    Node* parent = nullptr;
-
-    bool isBone = false;
-    int boneIndex = -1;
-
-    DirectX::XMFLOAT4X4 transform = {};
-    DirectX::XMFLOAT4X4 boneOffset = {};
-
-    DirectX::XMFLOAT4X4 globalTransform = {};
-
-    std::vector<Node*> children;
-
-    ~Node()
-    {
-        for (auto i = 0; i < children.size(); i++)
-        {
-            delete children[i];
-        }
-    }
-};
-
-struct NodeTree
-{
-    NodeTree()
-    {
-        root = new Node();
-    }
-
-    ~NodeTree()
-    {
-        delete root;
-    }
-
-
-    Node* root = nullptr;
-    Node* boneRoot = nullptr;
-
-    Node* findNodeByBoneIndex(int index) const;
-    std::string toString();
-
-private:
-    void printNodes(std::stringstream& str, Node* node, int depth = 0);
-};
-
 /*skinned model*/
-struct SkinnedModel : Model
+struct SkinnedModel : Model, SkinnedRig
 {
-    /*bone information*/
-    UINT boneCount = 0;
-    std::vector<int> boneHierarchy;
-    NodeTree nodeTree;
-    DirectX::XMFLOAT4X4 rootTransform = {};
-
-    void calculateFinalTransforms(AnimationClip* currentClip, std::vector<DirectX::XMFLOAT4X4>& finalTransforms, float timePos);
 };
 
-
-
 struct Light
 {
     DirectX::XMFLOAT3 Strength = { 0.0f, 0.0f, 0.0f };
@@ -324,7 +214,9 @@ struct RenderItem
     DirectX::XMFLOAT4X4 World = MathHelper::identity4x4();
     DirectX::XMFLOAT4X4 TexTransform = MathHelper::identity4x4();
 
-    int NumFramesDirty = gNumFrameResources;
+    // One bit per frame resource whose object/skinned dirty queue contains this item.
+    UINT QueuedFrameResources = 0;
+    UINT QueuedSkinnedFrameResources = 0;
 
     // index into constant buffer for object data and skinned data
     std::vector<UINT>ObjCBIndex;
@@ -333,11 +225,10 @@ struct RenderItem
     Model* staticModel = nullptr;
     SkinnedModel* skinnedModel = nullptr;
 
-    AnimationClip* currentClip = nullptr;
-    std::vector<DirectX::XMFLOAT4X4> finalTransforms;
-    Material* MaterialOverwrite = nullptr;
+    /*clip, time and pose of the skinned model*/
+    AnimationInstance animation;
 
-    float animationTimer = 0.0f;
+    Material* MaterialOverwrite = nullptr;
 
     bool isSkinned() const
     {
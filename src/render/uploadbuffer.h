@@ -59,6 +59,29 @@ public:
             memcpy(&mMappedData[0], &data, mElementCount * sizeof(T));
     }
 
+    /*copies _count elements at once, data has to be laid out with getElementByteSize() per element*/
+    void copyRange(int _elementIndex, const void* data, UINT _count)
+    {
+            memcpy(&mMappedData[_elementIndex * mElementByteSize], data, (size_t)_count * mElementByteSize);
+    }
+
+    /*copies only the first _byteSize bytes of an element*/
+    void copyPartial(int _elementIndex, const void* data, size_t _byteSize)
+    {
+            memcpy(&mMappedData[_elementIndex * mElementByteSize], data, (std::min)(_byteSize, (size_t)mElementByteSize));
+    }
+
+    /*element in the mapped memory, only write to it, upload heaps are write combined*/
+    BYTE* getMappedData(int _elementIndex)
+    {
+        return &mMappedData[_elementIndex * mElementByteSize];
+    }
+
+    UINT getElementByteSize() const
+    {
+        return mElementByteSize;
+    }
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
     BYTE* mMappedData = nullptr;
@@ -0,0 +1,190 @@
+#include "../render/animation.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace DirectX;
+
+/*
+crossfades of a skinned instance, needs no data files.
+a bone that only the previous clip animates has to fade to its bind pose and
+a fade that is interrupted by another one has to continue from the pose it showed.
+
+animationblendtest
+*/
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const std::string& message)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << message << "\n";
+            failures++;
+        }
+    }
+
+    constexpr unsigned int boneCount = 2;
+
+    /*bone 1 is a child of bone 0, both are moved away from the origin in their bind pose*/
+    void makeRig(SkinnedRig& rig)
+    {
+        Node* parent = rig.nodeTree.root;
+
+        for (unsigned int b = 0; b < boneCount; b++)
+        {
+            Node* node = new Node();
+            node->name = "bone" + std::to_string(b);
+            node->parent = parent;
+            node->isBone = true;
+            node->boneIndex = (int)b;
+            XMStoreFloat4x4(&node->transform, XMMatrixTranslation(0.0f, 1.0f, 0.0f));
+            XMStoreFloat4x4(&node->boneOffset, XMMatrixIdentity());
+
+            parent->children.push_back(node);
+            parent = node;
+
+            if (b == 0)
+            {
+                rig.nodeTree.boneRoot = node;
+            }
+        }
+
+        rig.boneCount = boneCount;
+        XMStoreFloat4x4(&rig.rootTransform, XMMatrixIdentity());
+        rig.bakeSkeleton();
+    }
+
+    /*
+    @param clip to fill
+    @param angle of bone 0 around z
+    @param true if bone 1 is animated as well
+    */
+    void makeClip(AnimationClip& clip, float angle, bool animateChild)
+    {
+        clip.boneAnimations.resize(boneCount);
+
+        for (unsigned int b = 0; b < boneCount; b++)
+        {
+            if (b == 1 && !animateChild)
+            {
+                clip.boneAnimations[b].isEmpty = true;
+                continue;
+            }
+
+            clip.boneAnimations[b].keyFrames.resize(2);
+
+            for (unsigned int k = 0; k < 2; k++)
+            {
+                KeyFrame& key = clip.boneAnimations[b].keyFrames[k];
+
+                key.timeStamp = (float)k;
+                key.translation = XMFLOAT3(0.0f, 1.0f, 0.0f);
+                XMStoreFloat4(&key.rotationQuat, XMQuaternionRotationRollPitchYaw(0.0f, 0.0f, b == 0 ? angle : 1.2f));
+            }
+        }
+
+        clip.getStartTime();
+        clip.getEndTime();
+        clip.sampler.build(clip.boneAnimations);
+        clip.releaseKeyFrames();
+    }
+
+    /*@returns final bone matrices of the instance*/
+    std::vector<XMFLOAT4X4> evaluate(AnimationInstance& instance)
+    {
+        std::vector<XMFLOAT4X4> result(boneCount);
+
+        instance.rig->calculateFinalTransforms(instance.skinningScratch, instance.currentClip, instance.animationTimer, &instance.keyCursors, UINT_MAX,
+                                               &instance.animationBlend, { result.data(), boneCount });
+
+        return result;
+    }
+
+    /*@returns largest difference of two sets of bone matrices*/
+    float difference(const std::vector<XMFLOAT4X4>& a, const std::vector<XMFLOAT4X4>& b)
+    {
+        float result = 0.0f;
+
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    result = (std::max)(result, std::fabs(a[i].m[r][c] - b[i].m[r][c]));
+                }
+            }
+        }
+
+        return result;
+    }
+
+    /*switches the clip of an instance like GameObject::setAnimation*/
+    void setClip(AnimationInstance& instance, AnimationClip* clip, float fadeDuration)
+    {
+        instance.startFade(fadeDuration);
+        instance.currentClip = clip;
+        instance.animationTimer = 0.0f;
+        instance.keyCursors.assign(boneCount, 0);
+    }
+}
+
+int main()
+{
+    SkinnedRig rig;
+    makeRig(rig);
+
+    AnimationClip a, b, c;
+    makeClip(a, 0.5f, true);
+    makeClip(b, -0.5f, false);
+    makeClip(c, 1.5f, false);
+
+    AnimationInstance instance;
+    instance.rig = &rig;
+    instance.currentClip = &a;
+    instance.keyCursors.assign(boneCount, 0);
+    instance.skinningScratch.resize(boneCount);
+
+    const std::vector<XMFLOAT4X4> poseA = evaluate(instance);
+
+    /*the fade starts at the pose of a, bone 1 is only animated by a and must not snap to its bind pose*/
+    setClip(instance, &b, 1.0f);
+
+    check(difference(evaluate(instance), poseA) < 1e-4f, "start of the fade from a to b differs from a");
+
+    /*halfway, bone 1 is between its pose in a and its bind pose*/
+    instance.animationBlend.fadeElapsed = 0.5f;
+    const std::vector<XMFLOAT4X4> halfway = evaluate(instance);
+
+    check(difference(halfway, poseA) > 0.01f, "fade from a to b does not move");
+
+    /*interrupting the fade continues from the pose on screen instead of jumping to b*/
+    setClip(instance, &c, 1.0f);
+
+    check(instance.animationBlend.hasFrozenPose, "interrupted fade was not frozen");
+    check(difference(evaluate(instance), halfway) < 1e-4f, "interrupted fade pops");
+
+    /*at the end of the fade only c is left*/
+    instance.animationBlend.fadeElapsed = 1.0f;
+    const std::vector<XMFLOAT4X4> end = evaluate(instance);
+
+    AnimationInstance reference;
+    reference.rig = &rig;
+    reference.currentClip = &c;
+    reference.keyCursors.assign(boneCount, 0);
+    reference.skinningScratch.resize(boneCount);
+
+    check(difference(end, evaluate(reference)) < 1e-4f, "end of the fade differs from c");
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed.\n";
+        return 1;
+    }
+
+    std::cout << "All checks passed.\n";
+    return 0;
+}
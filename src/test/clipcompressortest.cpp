@@ -0,0 +1,263 @@
+#include "../render/animation.h"
+#include "../util/clipcompressor.h"
+#include "../util/clipformat.h"
+#include "../util/cliploader.h"
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+using namespace DirectX;
+
+/*
+round trip of the clip compression, needs no data files.
+a synthetic clip is compressed, loaded and sampled at every original key, every value has to stay within the tolerance.
+the smallest three rotations and the 16 bit quantisation are tested on their own as well.
+
+clipcompressortest
+*/
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const std::string& message)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << message << "\n";
+            failures++;
+        }
+    }
+
+    /*@returns angle between two rotations*/
+    float angle(FXMVECTOR a, FXMVECTOR b)
+    {
+        const XMVECTOR difference = XMQuaternionMultiply(XMQuaternionConjugate(a), b);
+        return 2.0f * std::atan2(XMVectorGetX(XMVector3Length(difference)), std::fabs(XMVectorGetW(difference)));
+    }
+
+    /*@returns lane of a bone in one channel of a pose*/
+    float channel(const LocalPose& pose, unsigned int bone, unsigned int c)
+    {
+        return XMVectorGetByIndex(XMLoadFloat4A(&pose.group(bone / 4)[c]), bone % 4);
+    }
+
+    void testPackRotation()
+    {
+        /*largest component in every position, negative components and the identity*/
+        const XMFLOAT4 axes[] =
+        {
+            XMFLOAT4(1.0f, 0.2f, -0.3f, 0.1f), XMFLOAT4(-0.1f, 1.0f, 0.4f, -0.2f),
+            XMFLOAT4(0.3f, -0.2f, -1.0f, 0.5f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f),
+            XMFLOAT4(-0.5f, -0.5f, -0.5f, -0.5f), XMFLOAT4(0.7f, 0.0f, 0.0f, -0.7f)
+        };
+
+        for (const auto& axis : axes)
+        {
+            XMFLOAT4 rotation;
+            XMStoreFloat4(&rotation, XMQuaternionNormalize(XMLoadFloat4(&axis)));
+
+            std::uint16_t packed[3];
+            ClipFormat::packRotation(rotation, packed);
+            const XMFLOAT4 unpacked = ClipFormat::unpackRotation(packed);
+
+            const float error = angle(XMLoadFloat4(&rotation), XMLoadFloat4(&unpacked));
+
+            std::stringstream message;
+            message << "smallest three of (" << rotation.x << ", " << rotation.y << ", " << rotation.z << ", " << rotation.w << ") is off by " << error << " rad";
+
+            /*15 bits over +-0.707 per component*/
+            check(error < 0.0002f, message.str());
+            check(std::fabs(XMVectorGetX(XMQuaternionLength(XMLoadFloat4(&unpacked))) - 1.0f) < 0.0001f, "unpacked rotation is not normalised");
+        }
+    }
+
+    void testQuantise()
+    {
+        const float minimum = -3.0f;
+        const float extent = 7.5f;
+
+        for (int i = 0; i <= 100; i++)
+        {
+            const float value = minimum + extent * i / 100.0f;
+            const float decoded = ClipFormat::dequantise(ClipFormat::quantise(value, minimum, extent), minimum, extent);
+
+            check(std::fabs(decoded - value) <= extent / 65535.0f * 0.5f + 1e-6f, "quantised value is off by more than half a step");
+        }
+
+        check(ClipFormat::dequantise(ClipFormat::quantise(2.0f, 2.0f, 0.0f), 2.0f, 0.0f) == 2.0f, "empty range does not decode to its minimum");
+        check(ClipFormat::quantise(10.0f, minimum, extent) == 65535, "value above the range is not clamped");
+    }
+
+    constexpr unsigned int boneCount = 6;
+    constexpr unsigned int keyCount = 61;
+    constexpr float duration = 2.0f;
+
+    /*bones with wide and small motion, a still bone, an empty bone and linear motion*/
+    void makeClip(AnimationClip& clip)
+    {
+        clip.name = "roundtrip";
+        clip.boneAnimations.resize(boneCount);
+        clip.boneAnimations[3].isEmpty = true;
+
+        for (unsigned int b = 0; b < boneCount; b++)
+        {
+            if (clip.boneAnimations[b].isEmpty) continue;
+
+            clip.boneAnimations[b].keyFrames.resize(keyCount);
+
+            for (unsigned int k = 0; k < keyCount; k++)
+            {
+                const float time = duration * k / (keyCount - 1);
+                KeyFrame& key = clip.boneAnimations[b].keyFrames[k];
+
+                key.timeStamp = time;
+
+                XMVECTOR rotation = XMQuaternionIdentity();
+
+                switch (b)
+                {
+                    case 0:
+                        /*wide circle, 16 bits of its range are too coarse for the tolerance*/
+                        key.translation = XMFLOAT3(40.0f * std::cos(time * 3.0f), 5.0f, 40.0f * std::sin(time * 3.0f));
+                        rotation = XMQuaternionRotationRollPitchYaw(0.0f, time * XM_PI, 0.0f);
+                        break;
+
+                    case 1:
+                        key.translation = XMFLOAT3(0.5f * std::sin(time * 5.0f), 1.0f, 0.0f);
+                        key.scale = XMFLOAT3(1.0f + 0.1f * std::sin(time * 4.0f), 1.0f, 1.0f);
+                        rotation = XMQuaternionRotationAxis(XMVectorSet(0.3f, 1.0f, 0.2f, 0.0f), std::sin(time * 2.0f) * 2.0f);
+                        break;
+
+                    case 2:
+                        key.translation = XMFLOAT3(0.0f, 2.0f, 0.0f);
+                        rotation = XMQuaternionRotationRollPitchYaw(0.4f, 0.0f, 0.0f);
+                        break;
+
+                    case 4:
+                        /*linear, only the first and last key are needed*/
+                        key.translation = XMFLOAT3(time, 0.0f, -time);
+                        rotation = XMVectorNegate(XMQuaternionRotationRollPitchYaw(0.0f, 0.0f, 1.0f));
+                        break;
+
+                    default:
+                        rotation = XMQuaternionRotationRollPitchYaw(0.3f * std::sin(time * 7.0f), 0.1f * std::sin(time * 11.0f), 0.0f);
+                        break;
+                }
+
+                XMStoreFloat4(&key.rotationQuat, rotation);
+            }
+        }
+    }
+
+    void testRoundTrip()
+    {
+        AnimationClip original;
+        makeClip(original);
+
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / "clipcompressortest.clp";
+
+        const ClipCompressor::Tolerance tolerance;
+        std::stringstream log;
+
+        if (!ClipCompressor(tolerance).compress(original, file, log))
+        {
+            check(false, "clip was not compressed: " + log.str());
+            return;
+        }
+
+        const auto compressedSize = std::filesystem::file_size(file);
+        const auto clip = ClipLoader().loadCLP(std::filesystem::directory_entry(file));
+
+        std::error_code ec;
+        std::filesystem::remove(file, ec);
+
+        if (!clip)
+        {
+            check(false, "compressed clip was not loaded");
+            return;
+        }
+
+        check(clip->name == original.name, "name changed");
+        check(clip->boneAnimations.size() == boneCount, "bone count changed");
+        check(clip->boneAnimations[3].isEmpty, "empty bone is not empty anymore");
+        check(clip->sampler.isValid(), "sampler of the compressed clip is not valid");
+        check(clip->getEndTime() == duration, "end time changed");
+
+        /*the sampler holds the only copy of the keys*/
+        for (const auto& bone : clip->boneAnimations)
+        {
+            check(bone.keyFrames.empty(), "keys of a bone were not released");
+        }
+
+        /*version 1 stores time, translation, scale and rotation of every key of every bone*/
+        check(compressedSize < (size_t)(boneCount - 1) * keyCount * sizeof(float) * 11, "compressed clip is not smaller than version 1");
+
+        LocalPose pose;
+        LocalPose seekPose;
+        std::vector<unsigned int> cursors(boneCount, 0);
+
+        for (unsigned int k = 0; k < keyCount; k++)
+        {
+            const float time = original.boneAnimations[0].keyFrames[k].timeStamp;
+
+            clip->sampler.sample(time, pose, cursors.data());
+
+            /*the binary search without cursors finds the same keys*/
+            clip->sampler.sample(time, seekPose, nullptr);
+
+            for (unsigned int b = 0; b < boneCount; b++)
+            {
+                if (original.boneAnimations[b].isEmpty) continue;
+
+                const KeyFrame& key = original.boneAnimations[b].keyFrames[k];
+
+                const XMVECTOR translation = XMVectorSet(channel(pose, b, 0), channel(pose, b, 1), channel(pose, b, 2), 0.0f);
+                const XMVECTOR scale = XMVectorSet(channel(pose, b, 3), channel(pose, b, 4), channel(pose, b, 5), 0.0f);
+                const XMVECTOR rotation = XMVectorSet(channel(pose, b, 6), channel(pose, b, 7), channel(pose, b, 8), channel(pose, b, 9));
+
+                /*float rounding of the sampling on top of the tolerance*/
+                const float translationError = XMVectorGetX(XMVector3Length(XMVectorSubtract(translation, XMLoadFloat3(&key.translation))));
+                const float scaleError = XMVectorGetX(XMVector3Length(XMVectorSubtract(scale, XMLoadFloat3(&key.scale))));
+                const float rotationError = angle(rotation, XMLoadFloat4(&key.rotationQuat));
+
+                std::stringstream where;
+                where << " of bone " << b << " at key " << k << " is off by ";
+
+                check(translationError <= tolerance.translation + 1e-5f, "translation" + where.str() + std::to_string(translationError));
+                check(scaleError <= tolerance.scale + 1e-6f, "scale" + where.str() + std::to_string(scaleError));
+                check(rotationError <= tolerance.rotation + 2e-5f, "rotation" + where.str() + std::to_string(rotationError));
+
+                /*on a key the cursor may end the previous interval while the search starts the next one*/
+                for (unsigned int c = 0; c < 6; c++)
+                {
+                    const float difference = std::fabs(channel(pose, b, c) - channel(seekPose, b, c));
+                    check(difference <= 1e-5f, "sampling with and without cursors" + where.str() + std::to_string(difference));
+                }
+
+                /*the end of an interval may be the negated key*/
+                const XMVECTOR seekRotation = XMVectorSet(channel(seekPose, b, 6), channel(seekPose, b, 7), channel(seekPose, b, 8), channel(seekPose, b, 9));
+                const float seekError = angle(rotation, seekRotation);
+
+                check(seekError <= 1e-4f, "rotation sampled with and without cursors" + where.str() + std::to_string(seekError));
+            }
+        }
+    }
+}
+
+int main()
+{
+    testPackRotation();
+    testQuantise();
+    testRoundTrip();
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed.\n";
+        return 1;
+    }
+
+    std::cout << "All checks passed.\n";
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "../render/drawpacket.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+
+/*
+sort keys and radix sort of the draw packets.
+keys are encoded, sorted and compared with the order of their fields and with a stable comparison sort.
+
+drawpackettest
+*/
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const std::string& message)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << message << "\n";
+            failures++;
+        }
+    }
+
+    /*fields are read back with the key layouts in drawpacket.h*/
+    void testOpaqueKeys()
+    {
+        const std::uint64_t key = DrawPacketBuilder::makeOpaqueKey(200, 0x123456, 0xBEEF, 12.5f);
+
+        check(DrawPacketBuilder::getPSO(key) == 200, "pso of an opaque key");
+        check(((key >> 32) & 0xFFFFFF) == 0x123456, "mesh of an opaque key");
+        check(((key >> 16) & 0xFFFF) == 0xBEEF, "material of an opaque key");
+
+        /*ids beyond their bits must not change other fields*/
+        const std::uint64_t wide = DrawPacketBuilder::makeOpaqueKey(200, 0xFF123456, 0xFFFFBEEF, 12.5f);
+        check(wide == key, "mesh or material overflow into other fields");
+
+        check(DrawPacketBuilder::makeOpaqueKey(1, 2, 3, -5.0f) == DrawPacketBuilder::makeOpaqueKey(1, 2, 3, 0.0f), "negative depth is not clamped to 0");
+
+        /*front to back inside a group, the truncated depth may only make close depths equal*/
+        float previousDepth = 0.0f;
+
+        for (float depth = 0.001f; depth < 100000.0f; depth *= 1.37f)
+        {
+            const std::uint64_t closer = DrawPacketBuilder::makeOpaqueKey(3, 7, 9, previousDepth);
+            const std::uint64_t farther = DrawPacketBuilder::makeOpaqueKey(3, 7, 9, depth);
+
+            check(closer <= farther, "depth " + std::to_string(depth) + " sorts before " + std::to_string(previousDepth));
+            previousDepth = depth;
+        }
+
+        check(DrawPacketBuilder::makeOpaqueKey(3, 7, 9, 1.0f) < DrawPacketBuilder::makeOpaqueKey(3, 7, 9, 2.0f), "depths far apart are not ordered");
+
+        /*pso before mesh before material before depth*/
+        check(DrawPacketBuilder::makeOpaqueKey(1, 0xFFFFFF, 0xFFFF, 1e30f) < DrawPacketBuilder::makeOpaqueKey(2, 0, 0, 0.0f), "pso is not the first field");
+        check(DrawPacketBuilder::makeOpaqueKey(1, 5, 0xFFFF, 1e30f) < DrawPacketBuilder::makeOpaqueKey(1, 6, 0, 0.0f), "mesh is not the second field");
+        check(DrawPacketBuilder::makeOpaqueKey(1, 5, 8, 1e30f) < DrawPacketBuilder::makeOpaqueKey(1, 5, 9, 0.0f), "material is not the third field");
+    }
+
+    void testOrderedKeys()
+    {
+        const std::uint64_t key = DrawPacketBuilder::makeOrderedKey(17, 0xCAFEBABE, 0xABCDEF);
+
+        check(DrawPacketBuilder::getPSO(key) == 17, "pso of an ordered key");
+        check(((key >> 24) & 0xFFFFFFFF) == 0xCAFEBABE, "order of an ordered key");
+        check((key & 0xFFFFFF) == 0xABCDEF, "sub index of an ordered key");
+
+        check(DrawPacketBuilder::makeOrderedKey(17, 5, 0xFFFFFFFF) == DrawPacketBuilder::makeOrderedKey(17, 5, 0xFFFFFF), "sub index overflows into the order");
+        check(DrawPacketBuilder::makeOrderedKey(17, 4, 0xFFFFFF) < DrawPacketBuilder::makeOrderedKey(17, 5, 0), "order is not before the sub index");
+    }
+
+    /*
+    @param packets to sort
+    @param what the packets are
+    */
+    void checkSort(std::vector<DrawPacket> packets, const std::string& name)
+    {
+        DrawPacketBuilder builder;
+
+        for (const auto& p : packets)
+        {
+            builder.add(p.sortKey, p.object, p.mesh);
+        }
+
+        builder.sort();
+
+        std::stable_sort(packets.begin(), packets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; });
+
+        const auto& sorted = builder.getPackets();
+        bool same = sorted.size() == packets.size();
+
+        for (size_t i = 0; same && i < packets.size(); i++)
+        {
+            same = sorted[i].sortKey == packets[i].sortKey && sorted[i].object == packets[i].object && sorted[i].mesh == packets[i].mesh;
+        }
+
+        check(same, name + " are not sorted like a stable sort by key");
+    }
+
+    void testSort()
+    {
+        std::mt19937 random(4953);
+
+        checkSort({}, "no packets");
+        checkSort({ { 5, 0, 0 } }, "one packet");
+
+        /*keys of a level, few psos and meshes, many depths*/
+        std::vector<DrawPacket> packets;
+        std::uniform_int_distribution<std::uint32_t> small(0, 7);
+        std::uniform_real_distribution<float> depths(0.0f, 500.0f);
+
+        for (std::uint32_t i = 0; i < 5000; i++)
+        {
+            packets.push_back({ DrawPacketBuilder::makeOpaqueKey(small(random), small(random) * 1000, small(random), depths(random)), i, i % 3 });
+        }
+
+        checkSort(packets, "opaque packets");
+
+        /*equal keys keep the order they were added in*/
+        packets.clear();
+
+        for (std::uint32_t i = 0; i < 1000; i++)
+        {
+            packets.push_back({ DrawPacketBuilder::makeOrderedKey(2, i % 4, 0), i, 0 });
+        }
+
+        checkSort(packets, "packets with equal keys");
+
+        /*keys that differ in a single byte skip all other passes*/
+        packets.clear();
+
+        for (std::uint32_t i = 0; i < 1000; i++)
+        {
+            packets.push_back({ (std::uint64_t)(255 - i % 256) << 56, i, 0 });
+        }
+
+        checkSort(packets, "packets that differ in the pso only");
+
+        /*every bit of the key*/
+        packets.clear();
+        std::uniform_int_distribution<std::uint64_t> any;
+
+        for (std::uint32_t i = 0; i < 5000; i++)
+        {
+            packets.push_back({ any(random), i, i });
+        }
+
+        checkSort(packets, "random keys");
+    }
+}
+
+int main()
+{
+    testOpaqueKeys();
+    testOrderedKeys();
+    testSort();
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed.\n";
+        return 1;
+    }
+
+    std::cout << "All checks passed.\n";
+    return 0;
+}
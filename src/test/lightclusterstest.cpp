@@ -0,0 +1,402 @@
+#include "../render/lightclusters.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace DirectX;
+
+/*
+light binning of the light clusters, needs no data files.
+the cluster lists of point lights are compared with a scalar sphere test against every cluster,
+points inside of point and spot lights have to find their light in the list of their cluster
+and the nearest light selection is compared with a stable sort of the visible lights by distance.
+
+lightclusterstest
+*/
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const std::string& message)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << message << "\n";
+            failures++;
+        }
+    }
+
+    /*camera at the eye looking along +z*/
+    const XMVECTOR eye = XMVectorSet(0.0f, 2.0f, -50.0f, 1.0f);
+
+    constexpr float fovY = 0.25f * XM_PI;
+    constexpr float aspect = 16.0f / 9.0f;
+    constexpr float nearZ = 1.0f;
+    constexpr float farZ = 200.0f;
+
+    XMMATRIX makeView()
+    {
+        return XMMatrixLookAtLH(eye, XMVectorSet(0.0f, 2.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    }
+
+    LightClusters makeClusters(const std::vector<ClusterLight>& lights)
+    {
+        LightClusters clusters;
+        clusters.build(fovY, aspect, nearZ, farZ);
+        clusters.assign(lights.data(), (unsigned int)lights.size(), makeView());
+
+        return clusters;
+    }
+
+    /*
+    @param clusters after the assign
+    @param cluster coordinates
+    @returns light indices of the cluster
+    */
+    std::vector<unsigned int> getList(const LightClusters& clusters, unsigned int x, unsigned int y, unsigned int z)
+    {
+        const std::uint16_t* indices = nullptr;
+        const unsigned int count = clusters.getClusterLights(x, y, z, indices);
+
+        return std::vector<unsigned int>(indices, indices + count);
+    }
+
+    /*
+    @param clusters after the assign
+    @param light index
+    @param world space position
+    @returns whether the position is not in a cluster or the cluster of the position lists the light
+    */
+    bool isListed(const LightClusters& clusters, unsigned int light, FXMVECTOR position)
+    {
+        XMFLOAT3 viewPos;
+        XMStoreFloat3(&viewPos, XMVector3TransformCoord(position, makeView()));
+
+        const int index = clusters.getClusterIndex(viewPos);
+
+        if (index < 0) return true;
+
+        const unsigned int z = (unsigned int)index / LightClusters::TILES_PER_SLICE;
+        const unsigned int y = ((unsigned int)index % LightClusters::TILES_PER_SLICE) / LightClusters::TILES_X;
+        const unsigned int x = (unsigned int)index % LightClusters::TILES_X;
+
+        const auto list = getList(clusters, x, y, z);
+        return std::find(list.begin(), list.end(), light) != list.end();
+    }
+
+    /*
+    @param random number generator
+    @returns random unit vector
+    */
+    XMVECTOR randomDirection(std::mt19937& random)
+    {
+        std::normal_distribution<float> normal;
+        return XMVector3Normalize(XMVectorSet(normal(random), normal(random), normal(random), 0.0f));
+    }
+
+    void testPointLists()
+    {
+        std::mt19937 random(4953);
+        std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+        std::uniform_real_distribution<float> depth(-60.0f, 170.0f);
+        std::uniform_real_distribution<float> range(0.5f, 30.0f);
+
+        std::vector<ClusterLight> lights(400);
+
+        for (auto& l : lights)
+        {
+            l.position = XMFLOAT3(position(random), position(random) * 0.3f, depth(random));
+            l.range = range(random);
+        }
+
+        const LightClusters clusters = makeClusters(lights);
+        const XMMATRIX view = makeView();
+
+        std::vector<XMFLOAT3> centers(lights.size());
+
+        for (size_t i = 0; i < lights.size(); i++)
+        {
+            XMStoreFloat3(&centers[i], XMVector3TransformCoord(XMLoadFloat3(&lights[i].position), view));
+        }
+
+        /*same slicing as the clusters, slice 0 reaches from the camera to the near depth*/
+        float sliceBounds[LightClusters::SLICES + 1] = { 0.0f };
+
+        for (unsigned int k = 1; k <= LightClusters::SLICES; k++)
+        {
+            sliceBounds[k] = nearZ * std::pow(farZ / nearZ, (float)(k - 1) / (float)(LightClusters::SLICES - 1));
+        }
+
+        const float tanHalfY = std::tan(0.5f * fovY);
+        const float tanHalfX = aspect * tanHalfY;
+
+        std::vector<bool> visible(lights.size(), false);
+        unsigned int totalIndices = 0;
+        bool same = true;
+
+        for (unsigned int z = 0; z < LightClusters::SLICES; z++)
+        {
+            for (unsigned int y = 0; y < LightClusters::TILES_Y; y++)
+            {
+                for (unsigned int x = 0; x < LightClusters::TILES_X; x++)
+                {
+                    const float x0 = (-1.0f + 2.0f * (float)x / LightClusters::TILES_X) * tanHalfX;
+                    const float x1 = (-1.0f + 2.0f * (float)(x + 1) / LightClusters::TILES_X) * tanHalfX;
+                    const float y0 = (1.0f - 2.0f * (float)(y + 1) / LightClusters::TILES_Y) * tanHalfY;
+                    const float y1 = (1.0f - 2.0f * (float)y / LightClusters::TILES_Y) * tanHalfY;
+                    const float z0 = sliceBounds[z];
+                    const float z1 = sliceBounds[z + 1];
+
+                    const float minX = (std::min)({ x0 * z0, x0 * z1, x1 * z0, x1 * z1 });
+                    const float maxX = (std::max)({ x0 * z0, x0 * z1, x1 * z0, x1 * z1 });
+                    const float minY = (std::min)({ y0 * z0, y0 * z1, y1 * z0, y1 * z1 });
+                    const float maxY = (std::max)({ y0 * z0, y0 * z1, y1 * z0, y1 * z1 });
+
+                    std::vector<unsigned int> expected;
+
+                    for (unsigned int i = 0; i < (unsigned int)lights.size(); i++)
+                    {
+                        const XMFLOAT3& c = centers[i];
+                        const float dx = (std::max)({ minX - c.x, c.x - maxX, 0.0f });
+                        const float dy = (std::max)({ minY - c.y, c.y - maxY, 0.0f });
+                        const float dz = (std::max)({ z0 - c.z, c.z - z1, 0.0f });
+
+                        if (dx * dx + dy * dy + dz * dz <= lights[i].range * lights[i].range)
+                        {
+                            expected.push_back(i);
+                            visible[i] = true;
+                        }
+                    }
+
+                    totalIndices += (unsigned int)expected.size();
+                    same = same && getList(clusters, x, y, z) == expected;
+                }
+            }
+        }
+
+        check(same, "the cluster lists of point lights differ from the sphere test against every cluster");
+        check(clusters.getTotalLightIndices() == totalIndices, "the clusters store " + std::to_string(clusters.getTotalLightIndices()) +
+              " light indices instead of " + std::to_string(totalIndices));
+
+        std::vector<unsigned int> expectedVisible;
+
+        for (unsigned int i = 0; i < (unsigned int)lights.size(); i++)
+        {
+            if (visible[i]) expectedVisible.push_back(i);
+        }
+
+        check(clusters.getVisibleLights() == expectedVisible, "the visible lights are not the lights in at least one cluster");
+        check(!expectedVisible.empty() && expectedVisible.size() < lights.size(), "the random lights are all visible or all invisible");
+    }
+
+    void testInsidePoints()
+    {
+        std::mt19937 random(4953);
+        std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+        std::uniform_real_distribution<float> range(2.0f, 25.0f);
+        std::uniform_real_distribution<float> power(1.0f, 64.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        /*every second light is a spot light*/
+        std::vector<ClusterLight> lights(200);
+
+        for (size_t i = 0; i < lights.size(); i++)
+        {
+            auto& l = lights[i];
+            l.position = XMFLOAT3(position(random), position(random) * 0.3f, position(random) + 20.0f);
+            l.range = range(random);
+
+            if (i % 2 == 1)
+            {
+                XMStoreFloat3(&l.direction, randomDirection(random));
+                l.cosCone = ClusterLight::spotCone(power(random));
+            }
+        }
+
+        const LightClusters clusters = makeClusters(lights);
+        unsigned int missing = 0;
+        unsigned int tested = 0;
+
+        for (unsigned int i = 0; i < (unsigned int)lights.size(); i++)
+        {
+            const ClusterLight& l = lights[i];
+            const XMVECTOR center = XMLoadFloat3(&l.position);
+            const XMVECTOR axis = XMLoadFloat3(&l.direction);
+
+            for (int s = 0; s < 200; s++)
+            {
+                const XMVECTOR offset = XMVectorScale(randomDirection(random), l.range * std::cbrt(unit(random)));
+
+                /*only points inside of the cone are lit by a spot light*/
+                if (l.cosCone > -1.0f && XMVectorGetX(XMVector3Dot(XMVector3Normalize(offset), axis)) < l.cosCone) continue;
+
+                tested++;
+
+                if (!isListed(clusters, i, XMVectorAdd(center, offset)))
+                {
+                    missing++;
+                }
+            }
+        }
+
+        check(tested > 1000, "too few points inside of the lights were tested");
+        check(missing == 0, std::to_string(missing) + " points inside of lights are in clusters without the light");
+    }
+
+    void testSpotCulling()
+    {
+        /*the same light as a point light and as a narrow spot light looking to the right*/
+        ClusterLight point;
+        point.position = XMFLOAT3(0.0f, 2.0f, 0.0f);
+        point.range = 30.0f;
+
+        ClusterLight spot = point;
+        spot.direction = XMFLOAT3(1.0f, 0.0f, 0.0f);
+        spot.cosCone = ClusterLight::spotCone(32.0f);
+
+        const LightClusters pointClusters = makeClusters({ point });
+        const LightClusters spotClusters = makeClusters({ spot });
+
+        check(spotClusters.getTotalLightIndices() > 0, "the spot light is in no cluster");
+        check(spotClusters.getTotalLightIndices() * 4 < pointClusters.getTotalLightIndices(), "the narrow spot light is in " +
+              std::to_string(spotClusters.getTotalLightIndices()) + " clusters, the point light in " + std::to_string(pointClusters.getTotalLightIndices()));
+
+        /*the spot light has to be listed at the end of its axis but not behind its apex or left of it*/
+        check(isListed(spotClusters, 0, XMVectorSet(25.0f, 2.0f, 0.0f, 1.0f)), "the spot light is missing on its axis");
+        check(!isListed(spotClusters, 0, XMVectorSet(-20.0f, 2.0f, 0.0f, 1.0f)), "the spot light is listed behind its apex");
+        check(!isListed(spotClusters, 0, XMVectorSet(0.0f, 2.0f, 20.0f, 1.0f)), "the spot light is listed far outside of its cone");
+
+        /*a cone wider than 180 degrees can not cull behind its apex*/
+        ClusterLight wide = spot;
+        wide.cosCone = -0.5f;
+
+        check(isListed(makeClusters({ wide }), 0, XMVectorSet(-10.0f, 2.0f, 0.0f, 1.0f)), "the wide spot light is missing behind its apex");
+    }
+
+    /*
+    @param lights
+    @param first candidate
+    @param end of the candidates
+    @param amount of slots
+    @param what the lights are
+    */
+    void checkNearest(const std::vector<ClusterLight>& lights, unsigned int first, unsigned int last, unsigned int slots, const std::string& name)
+    {
+        LightClusters clusters = makeClusters(lights);
+
+        std::vector<unsigned int> selected;
+        clusters.selectNearest(lights.data(), eye, first, last, slots, selected);
+
+        std::vector<unsigned int> expected;
+
+        for (const auto i : clusters.getVisibleLights())
+        {
+            if (i >= first && i < last) expected.push_back(i);
+        }
+
+        const auto distance = [&](unsigned int i)
+        {
+            return XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&lights[i].position), eye)));
+        };
+
+        std::stable_sort(expected.begin(), expected.end(), [&](unsigned int a, unsigned int b) { return distance(a) < distance(b); });
+        expected.resize((std::min)(expected.size(), (size_t)slots));
+
+        check(selected == expected, name + " with " + std::to_string(slots) + " slots are not the nearest visible lights");
+    }
+
+    void testNearest()
+    {
+        std::mt19937 random(4953);
+        std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+        std::uniform_real_distribution<float> range(1.0f, 30.0f);
+
+        std::vector<ClusterLight> lights(500);
+
+        for (auto& l : lights)
+        {
+            l.position = XMFLOAT3(position(random), position(random) * 0.1f, position(random));
+            l.range = range(random);
+        }
+
+        for (unsigned int slots = 1; slots <= 8; slots++)
+        {
+            checkNearest(lights, 0, (unsigned int)lights.size(), slots, "random lights");
+        }
+
+        checkNearest(lights, 0, (unsigned int)lights.size(), 1000, "random lights");
+        checkNearest(lights, 100, 300, 4, "a range of random lights");
+        checkNearest({}, 0, 0, 4, "no lights");
+    }
+
+    void testEdgeCases()
+    {
+        /*the first light is visible only by its range, the second is behind the camera, the third is farther than the far depth*/
+        std::vector<ClusterLight> lights(4);
+        lights[0].position = XMFLOAT3(0.0f, 2.0f, -52.0f);
+        lights[0].range = 3.0f;
+        lights[1].position = XMFLOAT3(0.0f, 2.0f, -60.0f);
+        lights[1].range = 5.0f;
+        lights[2].position = XMFLOAT3(0.0f, 2.0f, 160.0f);
+        lights[2].range = 5.0f;
+        lights[3].position = XMFLOAT3(3.0f, 2.0f, 0.0f);
+        lights[3].range = 1.0f;
+
+        LightClusters clusters = makeClusters(lights);
+
+        const std::vector<unsigned int> visible = { 0, 3 };
+        check(clusters.getVisibleLights() == visible, "the visible lights are not the light around the camera and the light in front");
+
+        /*equal distances keep the order of the lights, the slots are full after the first two*/
+        std::vector<ClusterLight> ring(4);
+        ring[0].position = XMFLOAT3(-5.0f, 2.0f, -40.0f);
+        ring[1].position = XMFLOAT3(5.0f, 2.0f, -40.0f);
+        ring[2].position = XMFLOAT3(0.0f, 7.0f, -40.0f);
+        ring[3].position = XMFLOAT3(0.0f, 2.0f, -20.0f);
+
+        for (auto& l : ring)
+        {
+            l.range = 1.0f;
+        }
+
+        clusters = makeClusters(ring);
+
+        std::vector<unsigned int> selected;
+        clusters.selectNearest(ring.data(), eye, 0, 4, 2, selected);
+
+        const std::vector<unsigned int> first = { 0, 1 };
+        check(selected == first, "lights at equal distances are not selected in their order");
+        check(clusters.getVisibleLights().size() == 4, "lights that do not fit into the slots are not visible");
+
+        /*a previous selection is replaced*/
+        clusters.selectNearest(ring.data(), eye, 0, 4, 0, selected);
+
+        check(selected.empty(), "lights are selected without slots");
+
+        /*lights are only assigned after a build*/
+        LightClusters empty;
+        empty.assign(ring.data(), (unsigned int)ring.size(), makeView());
+
+        check(empty.getVisibleLights().empty() && empty.getTotalLightIndices() == 0, "lights are assigned without clusters");
+    }
+}
+
+int main()
+{
+    testPointLists();
+    testInsidePoints();
+    testSpotCulling();
+    testNearest();
+    testEdgeCases();
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed.\n";
+        return 1;
+    }
+
+    std::cout << "All checks passed.\n";
+    return 0;
+}
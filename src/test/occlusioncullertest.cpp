@@ -0,0 +1,334 @@
+#include "../util/occlusionculler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace DirectX;
+
+/*
+software occlusion culling against a reference image, needs no data files.
+every pixel of the depth buffer is compared with a ray cast from the pixel center against the occluder quads,
+boxes reported as hidden have to be behind the reference depth at every pixel they cover.
+
+occlusioncullertest
+*/
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const std::string& message)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << message << "\n";
+            failures++;
+        }
+    }
+
+    /*four corners in order around a planar convex quad*/
+    struct Quad
+    {
+        XMFLOAT3 corners[4];
+    };
+
+    /*@returns quad of four corners in order around it*/
+    Quad makeQuad(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c, XMFLOAT3 d)
+    {
+        return { { a, b, c, d } };
+    }
+
+    /*camera at the eye looking along +z with the aspect ratio of the depth buffer*/
+    const XMVECTOR eye = XMVectorSet(0.0f, 2.0f, -10.0f, 1.0f);
+
+    XMMATRIX makeViewProj()
+    {
+        const XMMATRIX view = XMMatrixLookAtLH(eye, XMVectorSet(0.0f, 2.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        const XMMATRIX proj = XMMatrixPerspectiveFovLH(0.3f * XM_PI, 2.0f, 0.5f, 100.0f);
+
+        return XMMatrixMultiply(view, proj);
+    }
+
+    /*
+    depth of the nearest quad a ray through a point of the screen hits
+    @param quads of the scene
+    @param view projection matrix
+    @param inverse of the view projection matrix
+    @param x in normalized device coordinates
+    @param y in normalized device coordinates
+    @param receives the index of the hit quad, -1 if none
+    @returns depth of the hit, 1 if none
+    */
+    float castRay(const std::vector<Quad>& quads, FXMMATRIX viewProj, CXMMATRIX inverse, float x, float y, int& hit)
+    {
+        const XMVECTOR origin = XMVector3TransformCoord(XMVectorSet(x, y, 0.0f, 1.0f), inverse);
+        const XMVECTOR direction = XMVectorSubtract(XMVector3TransformCoord(XMVectorSet(x, y, 1.0f, 1.0f), inverse), origin);
+
+        float result = 1.0f;
+        hit = -1;
+
+        for (size_t q = 0; q < quads.size(); q++)
+        {
+            XMVECTOR c[4];
+
+            for (int i = 0; i < 4; i++)
+            {
+                c[i] = XMLoadFloat3(&quads[q].corners[i]);
+            }
+
+            const XMVECTOR normal = XMVector3Cross(XMVectorSubtract(c[1], c[0]), XMVectorSubtract(c[3], c[0]));
+            const float denominator = XMVectorGetX(XMVector3Dot(normal, direction));
+
+            if (std::fabs(denominator) < 1e-12f) continue;
+
+            /*the origin lies on the near plane, hits before it are clipped*/
+            const float t = XMVectorGetX(XMVector3Dot(normal, XMVectorSubtract(c[0], origin))) / denominator;
+
+            if (t < 0.0f) continue;
+
+            const XMVECTOR point = XMVectorMultiplyAdd(direction, XMVectorReplicate(t), origin);
+
+            /*inside if the point is on the same side of every edge*/
+            bool positive = true;
+            bool negative = true;
+
+            for (int i = 0; i < 4; i++)
+            {
+                const float side = XMVectorGetX(XMVector3Dot(normal, XMVector3Cross(XMVectorSubtract(c[(i + 1) % 4], c[i]), XMVectorSubtract(point, c[i]))));
+
+                positive = positive && side >= 0.0f;
+                negative = negative && side <= 0.0f;
+            }
+
+            if (!positive && !negative) continue;
+
+            const float depth = XMVectorGetZ(XMVector3TransformCoord(point, viewProj));
+
+            if (depth < result)
+            {
+                result = depth;
+                hit = (int)q;
+            }
+        }
+
+        return result;
+    }
+
+    /*@returns x of the center of a pixel in normalized device coordinates*/
+    float toNdcX(float x, unsigned int width)
+    {
+        return (x + 0.5f) / width * 2.0f - 1.0f;
+    }
+
+    /*@returns y of the center of a pixel in normalized device coordinates, y goes down in pixels*/
+    float toNdcY(float y, unsigned int height)
+    {
+        return 1.0f - (y + 0.5f) / height * 2.0f;
+    }
+
+    /*
+    rasterizes quads and compares every pixel whose area is covered by one quad or none with the reference
+    @param quads of the scene
+    @param what the scene is
+    @param job system
+    */
+    void checkDepth(const std::vector<Quad>& quads, const std::string& name, JobSystem* jobs)
+    {
+        const XMMATRIX viewProj = makeViewProj();
+        const XMMATRIX inverse = XMMatrixInverse(nullptr, viewProj);
+
+        OcclusionCuller culler;
+        culler.begin(viewProj);
+
+        for (const auto& q : quads)
+        {
+            culler.addOccluder(q.corners);
+        }
+
+        culler.rasterize(jobs);
+
+        const unsigned int width = culler.getWidth();
+        const unsigned int height = culler.getHeight();
+        const auto& depth = culler.getDepth();
+
+        /*the same pixels without the job system*/
+        OcclusionCuller single;
+        single.begin(viewProj);
+
+        for (const auto& q : quads)
+        {
+            single.addOccluder(q.corners);
+        }
+
+        single.rasterize(nullptr);
+
+        check(single.getDepth() == depth, name + " differs between the job system and the calling thread");
+
+        unsigned int compared = 0;
+        unsigned int covered = 0;
+        unsigned int wrong = 0;
+        float largestError = 0.0f;
+
+        for (unsigned int y = 0; y < height; y++)
+        {
+            for (unsigned int x = 0; x < width; x++)
+            {
+                int hit = -1;
+                const float expected = castRay(quads, viewProj, inverse, toNdcX((float)x, width), toNdcY((float)y, height), hit);
+
+                /*pixels at an edge of a quad may be covered or not*/
+                bool decided = true;
+                const float offsets[4][2] = { { -0.45f, -0.45f }, { 0.45f, -0.45f }, { -0.45f, 0.45f }, { 0.45f, 0.45f } };
+
+                for (const auto& o : offsets)
+                {
+                    int cornerHit = -1;
+                    castRay(quads, viewProj, inverse, toNdcX(x + o[0], width), toNdcY(y + o[1], height), cornerHit);
+
+                    decided = decided && cornerHit == hit;
+                }
+
+                if (!decided) continue;
+
+                compared++;
+                covered += hit >= 0;
+
+                const float error = std::fabs(depth[(size_t)y * width + x] - expected);
+                largestError = (std::max)(largestError, error);
+
+                if (error > 1e-5f)
+                {
+                    wrong++;
+                }
+            }
+        }
+
+        check(compared > width * height / 2, name + " has too few pixels away from the edges");
+        check(quads.empty() == (covered == 0), name + " covers " + std::to_string(covered) + " pixels");
+        check(wrong == 0, name + " has " + std::to_string(wrong) + " of " + std::to_string(compared) +
+              " pixels different from the reference, the largest difference is " + std::to_string(largestError));
+    }
+
+    void testDepth(JobSystem* jobs)
+    {
+        /*a wall facing the camera*/
+        const Quad wall = makeQuad({ -3.0f, 0.0f, 10.0f }, { 3.0f, 0.0f, 10.0f }, { 3.0f, 4.0f, 10.0f }, { -3.0f, 4.0f, 10.0f });
+
+        /*the ground reaches behind the camera and is clipped at the near plane*/
+        const Quad ground = makeQuad({ -20.0f, 0.0f, -30.0f }, { 20.0f, 0.0f, -30.0f }, { 20.0f, 0.0f, 60.0f }, { -20.0f, 0.0f, 60.0f });
+
+        /*a wall at an angle that cuts through the first one*/
+        const Quad diagonal = makeQuad({ -4.0f, 0.5f, 6.0f }, { 4.0f, 0.5f, 14.0f }, { 4.0f, 3.0f, 14.0f }, { -4.0f, 3.0f, 6.0f });
+
+        checkDepth({}, "empty scene", jobs);
+        checkDepth({ wall }, "wall", jobs);
+        checkDepth({ ground }, "ground", jobs);
+        checkDepth({ wall, ground, diagonal }, "crossing walls", jobs);
+    }
+
+    void testVisibility(JobSystem* jobs)
+    {
+        const XMMATRIX viewProj = makeViewProj();
+        const XMMATRIX inverse = XMMatrixInverse(nullptr, viewProj);
+
+        /*a maze wall and the ground*/
+        const BoundingBox wall({ 0.0f, 2.0f, 10.0f }, { 3.0f, 2.0f, 0.2f });
+        const Quad ground = makeQuad({ -20.0f, 0.0f, -30.0f }, { 20.0f, 0.0f, -30.0f }, { 20.0f, 0.0f, 60.0f }, { -20.0f, 0.0f, 60.0f });
+
+        OcclusionCuller culler;
+        culler.begin(viewProj);
+        culler.addWallOccluder(wall);
+        culler.addOccluder(ground.corners);
+        culler.rasterize(jobs);
+
+        check(!culler.isVisible(BoundingBox({ 0.0f, 2.0f, 20.0f }, { 1.0f, 1.0f, 1.0f })), "box behind the wall is visible");
+        check(!culler.isVisible(BoundingBox({ 10.0f, -3.0f, 30.0f }, { 1.0f, 1.0f, 1.0f })), "box below the ground is visible");
+        check(culler.isVisible(BoundingBox({ 0.0f, 2.0f, 5.0f }, { 1.0f, 1.0f, 1.0f })), "box in front of the wall is hidden");
+        check(culler.isVisible(BoundingBox({ 5.0f, 2.0f, 20.0f }, { 1.0f, 1.0f, 1.0f })), "box partly beside the wall is hidden");
+        check(culler.isVisible(BoundingBox({ 0.0f, 2.0f, -10.0f }, { 1.0f, 1.0f, 1.0f })), "box crossing the near plane is hidden");
+        check(culler.isVisible(BoundingBox({ 0.0f, 2.0f, -30.0f }, { 1.0f, 1.0f, 1.0f })), "box behind the camera is hidden");
+
+        /*the reference of the quad the wall occluder is built from*/
+        const float inset = 0.9f;
+        const Quad wallQuad = makeQuad({ -3.0f * inset, 2.0f - 2.0f * inset, 10.0f }, { 3.0f * inset, 2.0f - 2.0f * inset, 10.0f },
+                                       { 3.0f * inset, 2.0f + 2.0f * inset, 10.0f }, { -3.0f * inset, 2.0f + 2.0f * inset, 10.0f });
+        const std::vector<Quad> quads = { wallQuad, ground };
+
+        /*every point of a hidden box on the screen has to be behind the reference depth of its pixel*/
+        std::mt19937 random(4953);
+        std::uniform_real_distribution<float> positionX(-8.0f, 8.0f);
+        std::uniform_real_distribution<float> positionY(-4.0f, 5.0f);
+        std::uniform_real_distribution<float> positionZ(0.0f, 40.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 1.5f);
+
+        const unsigned int width = culler.getWidth();
+        const unsigned int height = culler.getHeight();
+
+        unsigned int hidden = 0;
+        unsigned int wrong = 0;
+
+        for (int b = 0; b < 2000; b++)
+        {
+            const BoundingBox box({ positionX(random), positionY(random), positionZ(random) }, { extent(random), extent(random), extent(random) });
+
+            if (culler.isVisible(box)) continue;
+
+            hidden++;
+
+            bool behind = true;
+            constexpr int steps = 4;
+
+            for (int i = 0; i <= steps && behind; i++)
+            {
+                for (int j = 0; j <= steps && behind; j++)
+                {
+                    for (int k = 0; k <= steps && behind; k++)
+                    {
+                        const XMVECTOR point = XMVectorSet(box.Center.x + box.Extents.x * (2.0f * i / steps - 1.0f),
+                                                           box.Center.y + box.Extents.y * (2.0f * j / steps - 1.0f),
+                                                           box.Center.z + box.Extents.z * (2.0f * k / steps - 1.0f), 1.0f);
+
+                        const XMVECTOR projected = XMVector3TransformCoord(point, viewProj);
+                        const float px = std::floor((XMVectorGetX(projected) * 0.5f + 0.5f) * width);
+                        const float py = std::floor((0.5f - XMVectorGetY(projected) * 0.5f) * height);
+
+                        /*points beside the screen can not be seen*/
+                        if (px < 0.0f || py < 0.0f || px >= width || py >= height) continue;
+
+                        int hit = -1;
+                        const float occluder = castRay(quads, viewProj, inverse, toNdcX(px, width), toNdcY(py, height), hit);
+
+                        behind = hit >= 0 && occluder < XMVectorGetZ(projected);
+                    }
+                }
+            }
+
+            if (!behind)
+            {
+                wrong++;
+            }
+        }
+
+        check(hidden > 0, "no random box is hidden");
+        check(wrong == 0, std::to_string(wrong) + " of " + std::to_string(hidden) + " hidden random boxes are in front of the reference");
+    }
+}
+
+int main()
+{
+    JobSystem jobs(3);
+
+    testDepth(&jobs);
+    testVisibility(&jobs);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed.\n";
+        return 1;
+    }
+
+    std::cout << "All checks passed.\n";
+    return 0;
+}
@@ -0,0 +1,398 @@
+#include "clipcompressor.h"
+#include "clipformat.h"
+#include "cliploader.h"
+#include "../render/posesampler.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+using namespace DirectX;
+
+bool ClipCompressor::compress(const AnimationClip& clip, const std::filesystem::path& file, std::ostream& log) const
+{
+    /*the first animated bone defines the shared key times*/
+    const auto reference = std::find_if(clip.boneAnimations.begin(), clip.boneAnimations.end(),
+                                        [](const BoneAnimation& b) { return !b.isEmpty && !b.keyFrames.empty(); });
+
+    std::vector<float> times;
+
+    if (reference != clip.boneAnimations.end())
+    {
+        for (const auto& key : reference->keyFrames)
+        {
+            times.push_back(key.timeStamp);
+        }
+    }
+
+    if (times.size() > 0xFFFF)
+    {
+        log << "Clip " << clip.name << " has too many keys to be compressed!\n";
+        return false;
+    }
+
+    for (const auto& bone : clip.boneAnimations)
+    {
+        if (bone.isEmpty || bone.keyFrames.empty()) continue;
+
+        bool shared = bone.keyFrames.size() == times.size();
+
+        for (size_t k = 0; shared && k < times.size(); k++)
+        {
+            shared = bone.keyFrames[k].timeStamp == times[k];
+        }
+
+        if (!shared)
+        {
+            log << "Clip " << clip.name << " has bones with different key times, it can not be compressed!\n";
+            return false;
+        }
+    }
+
+    std::ofstream out(file, std::ios::binary);
+
+    if (!out)
+    {
+        log << "Unable to write clip file " << file.u8string() << "!\n";
+        return false;
+    }
+
+    auto write = [&out](const auto& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    out.write(ClipFormat::MAGIC, sizeof(ClipFormat::MAGIC));
+    write(ClipFormat::VERSION);
+
+    write((int)clip.name.size());
+    out.write(clip.name.data(), clip.name.size());
+
+    write((int)clip.boneAnimations.size());
+
+    write((int)times.size());
+
+    for (const float time : times)
+    {
+        write(time);
+    }
+
+    std::vector<XMFLOAT4> translations, scales, rotations;
+
+    for (const auto& bone : clip.boneAnimations)
+    {
+        const std::uint8_t flags = bone.isEmpty || bone.keyFrames.empty() ? ClipFormat::BONE_EMPTY : 0;
+        write(flags);
+
+        if (flags & ClipFormat::BONE_EMPTY) continue;
+
+        translations.clear();
+        scales.clear();
+        rotations.clear();
+
+        for (const auto& key : bone.keyFrames)
+        {
+            translations.push_back(XMFLOAT4(key.translation.x, key.translation.y, key.translation.z, 0.0f));
+            scales.push_back(XMFLOAT4(key.scale.x, key.scale.y, key.scale.z, 0.0f));
+
+            XMFLOAT4 rotation;
+            XMStoreFloat4(&rotation, XMQuaternionNormalize(XMLoadFloat4(&key.rotationQuat)));
+            rotations.push_back(rotation);
+        }
+
+        writeTrack(out, translations, times, Channel::Translation);
+        writeTrack(out, scales, times, Channel::Scale);
+        writeTrack(out, rotations, times, Channel::Rotation);
+    }
+
+    return out.good();
+}
+
+unsigned int ClipCompressor::compressDirectory(const std::filesystem::path& directory, std::ostream& log) const
+{
+    /*the compressor reads the keys of every bone*/
+    ClipLoader loader(true);
+    unsigned int compressed = 0;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (entry.is_directory()) continue;
+
+        /*only version 1 clips, compressed ones are skipped*/
+        {
+            std::ifstream file(entry.path(), std::ios::binary);
+            char magic[4] = {};
+            file.read(magic, sizeof(magic));
+
+            if (std::memcmp(magic, ClipFormat::MAGIC_V1, sizeof(magic)) != 0) continue;
+        }
+
+        const auto clip = loader.loadCLP(entry);
+
+        if (!clip)
+        {
+            log << "Failed to load animation clip " << entry.path().u8string() << "!\n";
+            continue;
+        }
+
+        std::filesystem::path temporary = entry.path();
+        temporary += ".tmp";
+
+        std::error_code ec;
+
+        if (!compress(*clip, temporary, log))
+        {
+            std::filesystem::remove(temporary, ec);
+            continue;
+        }
+
+        const auto sizeBefore = std::filesystem::file_size(entry.path(), ec);
+        const auto sizeAfter = std::filesystem::file_size(temporary, ec);
+
+        std::filesystem::rename(temporary, entry.path(), ec);
+
+        if (ec)
+        {
+            log << "Unable to replace clip file " << entry.path().u8string() << "!\n";
+            std::filesystem::remove(temporary, ec);
+            continue;
+        }
+
+        log << "Compressed clip " << clip->name << " from " << sizeBefore << " to " << sizeAfter << " bytes.\n";
+        compressed++;
+    }
+
+    return compressed;
+}
+
+void ClipCompressor::writeTrack(std::ostream& out, const std::vector<XMFLOAT4>& values, const std::vector<float>& times, Channel channel) const
+{
+    auto write = [&out](const auto& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    const int components = channel == Channel::Rotation ? 4 : 3;
+
+    auto writeValue = [&](const XMFLOAT4& value)
+    {
+        const float v[4] = { value.x, value.y, value.z, value.w };
+
+        for (int c = 0; c < components; c++)
+        {
+            write(v[c]);
+        }
+    };
+
+    if (isConstant(values, channel))
+    {
+        write(ClipFormat::TrackType::Constant);
+        writeValue(values.front());
+        return;
+    }
+
+    /*the dropped keys are interpolated from what the loader decodes, not from the original values*/
+    float minimum[3], extent[3];
+    std::vector<XMFLOAT4> decoded;
+
+    const bool quantised = encode(values, channel, minimum, extent, decoded);
+
+    if (!quantised)
+    {
+        decoded = values;
+    }
+
+    const std::vector<unsigned int> keys = reduceKeys(values, decoded, times, channel);
+
+    write(quantised ? ClipFormat::TrackType::Animated : ClipFormat::TrackType::Raw);
+    write((std::uint16_t)keys.size());
+
+    for (const unsigned int k : keys)
+    {
+        write((std::uint16_t)k);
+    }
+
+    if (!quantised)
+    {
+        for (const unsigned int k : keys)
+        {
+            writeValue(values[k]);
+        }
+
+        return;
+    }
+
+    if (channel == Channel::Rotation)
+    {
+        for (const unsigned int k : keys)
+        {
+            std::uint16_t packed[3];
+            ClipFormat::packRotation(values[k], packed);
+            out.write(reinterpret_cast<const char*>(packed), sizeof(packed));
+        }
+
+        return;
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        write(minimum[c]);
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        write(extent[c]);
+    }
+
+    for (const unsigned int k : keys)
+    {
+        const float v[3] = { values[k].x, values[k].y, values[k].z };
+
+        for (int c = 0; c < 3; c++)
+        {
+            write(ClipFormat::quantise(v[c], minimum[c], extent[c]));
+        }
+    }
+}
+
+bool ClipCompressor::isConstant(const std::vector<XMFLOAT4>& values, Channel channel) const
+{
+    const XMVECTOR firstValue = XMLoadFloat4(&values.front());
+
+    return std::all_of(values.begin(), values.end(), [&](const XMFLOAT4& value)
+    {
+        return error(XMLoadFloat4(&value), firstValue, channel) <= limit(channel);
+    });
+}
+
+bool ClipCompressor::encode(const std::vector<XMFLOAT4>& values, Channel channel, float minimum[3], float extent[3], std::vector<XMFLOAT4>& decoded) const
+{
+    decoded.resize(values.size());
+
+    if (channel == Channel::Rotation)
+    {
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            std::uint16_t packed[3];
+            ClipFormat::packRotation(values[i], packed);
+            decoded[i] = ClipFormat::unpackRotation(packed);
+        }
+    }
+    else
+    {
+        /*range of all keys, the kept keys are only known after the error is measured on the decoded values*/
+        float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (int c = 0; c < 3; c++)
+        {
+            minimum[c] = FLT_MAX;
+        }
+
+        for (const auto& value : values)
+        {
+            const float v[3] = { value.x, value.y, value.z };
+
+            for (int c = 0; c < 3; c++)
+            {
+                minimum[c] = (std::min)(minimum[c], v[c]);
+                maximum[c] = (std::max)(maximum[c], v[c]);
+            }
+        }
+
+        for (int c = 0; c < 3; c++)
+        {
+            extent[c] = maximum[c] - minimum[c];
+        }
+
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            const float v[3] = { values[i].x, values[i].y, values[i].z };
+            float d[3];
+
+            for (int c = 0; c < 3; c++)
+            {
+                d[c] = ClipFormat::dequantise(ClipFormat::quantise(v[c], minimum[c], extent[c]), minimum[c], extent[c]);
+            }
+
+            decoded[i] = XMFLOAT4(d[0], d[1], d[2], 0.0f);
+        }
+    }
+
+    /*a wide range makes the 16 bit steps too coarse for the tolerance*/
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (error(XMLoadFloat4(&decoded[i]), XMLoadFloat4(&values[i]), channel) > limit(channel))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<unsigned int> ClipCompressor::reduceKeys(const std::vector<XMFLOAT4>& values, const std::vector<XMFLOAT4>& decoded,
+                                                     const std::vector<float>& times, Channel channel) const
+{
+    const unsigned int count = (unsigned int)values.size();
+    const float maxError = limit(channel);
+
+    /*grow every interval until one of the keys inside can not be interpolated anymore*/
+    std::vector<unsigned int> keys = { 0 };
+    unsigned int first = 0;
+
+    for (unsigned int last = 2; last < count; last++)
+    {
+        const XMVECTOR v0 = XMLoadFloat4(&decoded[first]);
+        const XMVECTOR v1 = XMLoadFloat4(&decoded[last]);
+
+        for (unsigned int i = first + 1; i < last; i++)
+        {
+            const float t = (times[i] - times[first]) / (times[last] - times[first]);
+
+            /*same interpolation as the sampler*/
+            const XMVECTOR interpolated = channel == Channel::Rotation ? PoseSampler::blendRotation(v0, v1, t) : XMVectorLerp(v0, v1, t);
+
+            if (error(interpolated, XMLoadFloat4(&values[i]), channel) > maxError)
+            {
+                first = last - 1;
+                keys.push_back(first);
+                break;
+            }
+        }
+    }
+
+    if (count > 1)
+    {
+        keys.push_back(count - 1);
+    }
+
+    return keys;
+}
+
+float ClipCompressor::error(FXMVECTOR value, FXMVECTOR reference, Channel channel) const
+{
+    switch (channel)
+    {
+        case Channel::Translation:
+            return XMVectorGetX(XMVector3Length(XMVectorSubtract(value, reference)));
+
+        case Channel::Scale:
+            return XMVectorGetX(XMVector3Length(XMVectorSubtract(value, reference)));
+
+        default:
+        {
+            /*angle between the rotations, acos of the dot product is too coarse for angles near the tolerance*/
+            const XMVECTOR difference = XMQuaternionMultiply(XMQuaternionConjugate(reference), value);
+            return 2.0f * std::atan2(XMVectorGetX(XMVector3Length(difference)), std::fabs(XMVectorGetW(difference)));
+        }
+    }
+}
+
+float ClipCompressor::limit(Channel channel) const
+{
+    switch (channel)
+    {
+        case Channel::Translation: return tolerance.translation;
+        case Channel::Scale: return tolerance.scale;
+        default: return tolerance.rotation;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../render/animation.h"
+#include <filesystem>
+#include <ostream>
+#include <vector>
+
+/*
+offline compressor that writes animation clips in version 2 of the .clp format, see clipformat.h.
+keys that can be interpolated from their neighbours within the tolerance of the channel are dropped,
+channels that stay within the tolerance of their first key are stored once,
+rotations are stored as smallest three in 48 bits and translations and scales as 16 bits normalised to their range.
+the error is measured on the values as the loader decodes them, tracks whose 16 bits are too coarse keep full floats.
+*/
+class ClipCompressor
+{
+public:
+
+    /*largest error of a loaded key compared to the original one*/
+    struct Tolerance
+    {
+        float translation = 0.0001f;    /*distance*/
+        float scale = 0.0001f;          /*length of the difference*/
+        float rotation = 0.001f;        /*angle in radians*/
+    };
+
+    /*default tolerance*/
+    explicit ClipCompressor() = default;
+
+    explicit ClipCompressor(const Tolerance& tolerance)
+        : tolerance(tolerance)
+    {
+    }
+
+    ~ClipCompressor() = default;
+
+    /*
+    @param clip with all bones sharing their key times, like every version 1 clip
+    @param file to write
+    @param receives the reason if the clip is not compressed
+    @returns false if the clip can not be compressed or the file not be written
+    */
+    bool compress(const AnimationClip& clip, const std::filesystem::path& file, std::ostream& log) const;
+
+    /*
+    replaces every version 1 clip in a directory by its compressed version
+    @param directory
+    @param receives one line per clip
+    @returns amount of compressed clips
+    */
+    unsigned int compressDirectory(const std::filesystem::path& directory, std::ostream& log) const;
+
+private:
+
+    enum class Channel
+    {
+        Translation,
+        Scale,
+        Rotation
+    };
+
+    /*@returns true if every value stays within the tolerance of the first one*/
+    bool isConstant(const std::vector<DirectX::XMFLOAT4>& values, Channel channel) const;
+
+    /*
+    quantises every value and decodes it again like the loader
+    @param values of one channel at every key
+    @param channel the values belong to
+    @param minimum of the range of translation and scale
+    @param extent of the range of translation and scale
+    @param receives the decoded values
+    @returns false if a decoded value is outside of the tolerance
+    */
+    bool encode(const std::vector<DirectX::XMFLOAT4>& values, Channel channel, float minimum[3], float extent[3], std::vector<DirectX::XMFLOAT4>& decoded) const;
+
+    /*
+    @param values of one channel at every key
+    @param the same values as the loader decodes them
+    @param shared key times
+    @param channel the values belong to
+    @returns indices of the keys to keep, every dropped key is interpolated from the decoded kept keys within the tolerance
+    */
+    std::vector<unsigned int> reduceKeys(const std::vector<DirectX::XMFLOAT4>& values, const std::vector<DirectX::XMFLOAT4>& decoded,
+                                         const std::vector<float>& times, Channel channel) const;
+
+    /*writes the values of one channel as constant, animated or raw track*/
+    void writeTrack(std::ostream& out, const std::vector<DirectX::XMFLOAT4>& values, const std::vector<float>& times, Channel channel) const;
+
+    /*@returns error of value compared to reference for the channel*/
+    float error(DirectX::FXMVECTOR value, DirectX::FXMVECTOR reference, Channel channel) const;
+
+    /*@returns tolerance of the channel*/
+    float limit(Channel channel) const;
+
+    Tolerance tolerance;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+/*
+version 2 of the .clp format, written by ClipCompressor and read by ClipLoader.
+version 1 files start with "clpf" and store every key of every bone as full floats.
+
+"clpv", int version
+int name length, name
+int bone count
+int key count, float key times[key count]       shared timeline, tracks only store indices into it
+per bone:
+    uint8 flags
+    translation, scale and rotation track, each:
+        uint8 track type
+        constant: float x y z (w)
+        animated: uint16 key count, uint16 key indices[key count]
+            translation and scale: float minimum[3], float extent[3], uint16 values[key count][3]
+            rotation: uint16 values[key count][3], smallest three in 48 bits
+        raw: uint16 key count, uint16 key indices[key count], float values[key count][3 or 4]
+*/
+namespace ClipFormat
+{
+    inline constexpr char MAGIC[4] = { 'c','l','p','v' };
+    inline constexpr char MAGIC_V1[4] = { 'c','l','p','f' };
+    inline constexpr int VERSION = 2;
+
+    /*bone flags*/
+    inline constexpr std::uint8_t BONE_EMPTY = 1;
+
+    enum class TrackType : std::uint8_t
+    {
+        Constant = 0,
+        Animated = 1,
+        Raw = 2         /*animated, but 16 bits are too coarse for the tolerance*/
+    };
+
+    /*largest value of the three smaller quaternion components*/
+    inline constexpr float SMALLEST_THREE_RANGE = 0.70710678f;
+
+    /*
+    @param value
+    @param minimum of the range
+    @param extent of the range
+    @returns value normalised to 16 bits
+    */
+    inline std::uint16_t quantise(float value, float minimum, float extent)
+    {
+        if (extent <= 0.0f)
+        {
+            return 0;
+        }
+
+        const float normalised = std::clamp((value - minimum) / extent, 0.0f, 1.0f);
+        return static_cast<std::uint16_t>(std::lround(normalised * 65535.0f));
+    }
+
+    inline float dequantise(std::uint16_t value, float minimum, float extent)
+    {
+        return minimum + extent * (value / 65535.0f);
+    }
+
+    /*
+    stores the index of the largest component in 2 bits and the other three components in 15 bits each,
+    the largest one is recomputed from the unit length
+    @param normalised quaternion
+    @param 48 bits of output
+    */
+    inline void packRotation(const DirectX::XMFLOAT4& rotation, std::uint16_t packed[3])
+    {
+        float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+
+        int largest = 0;
+
+        for (int i = 1; i < 4; i++)
+        {
+            if (std::fabs(q[i]) > std::fabs(q[largest]))
+            {
+                largest = i;
+            }
+        }
+
+        /*q and -q are the same rotation, keep the largest component positive*/
+        const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+        std::uint64_t bits = static_cast<std::uint64_t>(largest);
+
+        for (int i = 0; i < 4; i++)
+        {
+            if (i == largest) continue;
+
+            const float normalised = std::clamp((q[i] * sign / SMALLEST_THREE_RANGE) * 0.5f + 0.5f, 0.0f, 1.0f);
+            bits = (bits << 15) | static_cast<std::uint64_t>(std::lround(normalised * 32767.0f));
+        }
+
+        packed[0] = static_cast<std::uint16_t>(bits >> 32);
+        packed[1] = static_cast<std::uint16_t>(bits >> 16);
+        packed[2] = static_cast<std::uint16_t>(bits);
+    }
+
+    inline DirectX::XMFLOAT4 unpackRotation(const std::uint16_t packed[3])
+    {
+        std::uint64_t bits = (static_cast<std::uint64_t>(packed[0]) << 32) |
+                             (static_cast<std::uint64_t>(packed[1]) << 16) |
+                              static_cast<std::uint64_t>(packed[2]);
+
+        const int largest = static_cast<int>((bits >> 45) & 3);
+
+        float q[4] = {};
+        float sumSq = 0.0f;
+
+        for (int i = 3; i >= 0; i--)
+        {
+            if (i == largest) continue;
+
+            q[i] = ((bits & 32767) / 32767.0f * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+            sumSq += q[i] * q[i];
+            bits >>= 15;
+        }
+
+        q[largest] = std::sqrt((std::max)(0.0f, 1.0f - sumSq));
+
+        return DirectX::XMFLOAT4(q[0], q[1], q[2], q[3]);
+    }
+}
@@ -1,5 +1,9 @@
 #include "cliploader.h"
-#include <fstream>
+#include "clipformat.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace DirectX;
 
 std::unique_ptr<AnimationClip> ClipLoader::loadCLP(const std::filesystem::directory_entry& fileName)
 {
@@ -13,22 +17,15 @@ std::unique_ptr<AnimationClip> ClipLoader::loadCLP(const std::filesystem::direct
     file.seekg(0, std::ios::beg);
 
     /*check header*/
-    bool header = true;
-    char headerBuffer[4] = { 'c','l','p','f' };
+    char header[4] = {};
+    file.read(header, sizeof(header));
 
-    for (int i = 0; i < 4; i++)
+    if (std::memcmp(header, ClipFormat::MAGIC, sizeof(header)) == 0)
     {
-        char temp;
-        file.read(&temp, sizeof(temp));
-
-        if (temp != headerBuffer[i])
-        {
-            header = false;
-            break;
-        }
+        return loadCompressed(file);
     }
 
-    if (header == false)
+    if (std::memcmp(header, ClipFormat::MAGIC_V1, sizeof(header)) != 0)
     {
         /*header incorrect*/
         return nullptr;
@@ -39,7 +36,7 @@ std::unique_ptr<AnimationClip> ClipLoader::loadCLP(const std::filesystem::direct
     int slen = 0;
     file.read((char*)(&slen), sizeof(int));
 
-    char* animName = new char[(INT_PTR)slen + 1];
+    char* animName = new char[(size_t)slen + 1];
     file.read(animName, slen);
     animName[slen] = '\0';
 
@@ -52,15 +49,15 @@ std::unique_ptr<AnimationClip> ClipLoader::loadCLP(const std::filesystem::direct
         int i = 1;
     }
 
-    UINT numBones = 0;
+    unsigned int numBones = 0;
     file.read((char*)(&numBones), sizeof(int));
 
     anim->boneAnimations.resize(numBones);
 
-    UINT keyfrCount = 0;
-    for (UINT i = 0; i < numBones; i++)
+    unsigned int keyfrCount = 0;
+    for (unsigned int i = 0; i < numBones; i++)
     {
-        UINT kTemp = 0;
+        unsigned int kTemp = 0;
         file.read((char*)(&kTemp), sizeof(int));
 
         if(i == 0)
@@ -76,7 +73,7 @@ std::unique_ptr<AnimationClip> ClipLoader::loadCLP(const std::filesystem::direct
 
         anim->boneAnimations[i].keyFrames.resize(keyfrCount);
 
-        for (UINT j = 0; j < keyfrCount; j++)
+        for (unsigned int j = 0; j < keyfrCount; j++)
         {
 
             float temp, temp2, temp3, temp4;
@@ -114,8 +111,252 @@ std::unique_ptr<AnimationClip> ClipLoader::loadCLP(const std::filesystem::direct
 
     }
 
-    anim->getStartTime();
-    anim->getEndTime();
+    buildSampler(*anim);
 
     return anim;
 }
+
+std::unique_ptr<AnimationClip> ClipLoader::loadCompressed(std::ifstream& file)
+{
+    auto read = [&file](auto& value)
+    {
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    };
+
+    int version = 0;
+    read(version);
+
+    if (version != ClipFormat::VERSION)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<AnimationClip> anim = std::make_unique<AnimationClip>();
+
+    int slen = 0;
+    read(slen);
+
+    if (slen < 0)
+    {
+        return nullptr;
+    }
+
+    anim->name.resize(slen);
+    file.read(anim->name.data(), slen);
+
+    int numBones = 0;
+    int keyCount = 0;
+    read(numBones);
+    read(keyCount);
+
+    if (!file || numBones < 0 || keyCount < 0)
+    {
+        return nullptr;
+    }
+
+    std::vector<float> times(keyCount);
+    file.read(reinterpret_cast<char*>(times.data()), times.size() * sizeof(float));
+
+    anim->boneAnimations.resize(numBones);
+
+    Track tracks[3];
+    std::vector<unsigned int> boneKeys;
+
+    for (int i = 0; i < numBones; i++)
+    {
+        BoneAnimation& bone = anim->boneAnimations[i];
+
+        std::uint8_t flags = 0;
+        read(flags);
+
+        if ((flags & ClipFormat::BONE_EMPTY) || keyCount == 0)
+        {
+            bone.isEmpty = true;
+            continue;
+        }
+
+        /*translation, scale, rotation*/
+        for (int c = 0; c < 3; c++)
+        {
+            if (!readTrack(file, tracks[c], c == 2, keyCount))
+            {
+                return nullptr;
+            }
+        }
+
+        /*the bone gets a key wherever one of its tracks has one, constant bones keep the length of the clip*/
+        boneKeys.clear();
+
+        for (const auto& track : tracks)
+        {
+            boneKeys.insert(boneKeys.end(), track.keys.begin(), track.keys.end());
+        }
+
+        if (boneKeys.empty())
+        {
+            boneKeys.push_back(0);
+            boneKeys.push_back(keyCount - 1);
+        }
+
+        std::sort(boneKeys.begin(), boneKeys.end());
+        boneKeys.erase(std::unique(boneKeys.begin(), boneKeys.end()), boneKeys.end());
+
+        bone.keyFrames.resize(boneKeys.size());
+
+        for (size_t k = 0; k < boneKeys.size(); k++)
+        {
+            KeyFrame& key = bone.keyFrames[k];
+
+            key.timeStamp = times[boneKeys[k]];
+            XMStoreFloat3(&key.translation, tracks[0].evaluate(boneKeys[k], times, false));
+            XMStoreFloat3(&key.scale, tracks[1].evaluate(boneKeys[k], times, false));
+            XMStoreFloat4(&key.rotationQuat, tracks[2].evaluate(boneKeys[k], times, true));
+        }
+    }
+
+    if (!file)
+    {
+        return nullptr;
+    }
+
+    buildSampler(*anim);
+
+    return anim;
+}
+
+bool ClipLoader::readTrack(std::ifstream& file, Track& track, bool rotation, int keyCount)
+{
+    auto read = [&file](auto& value)
+    {
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    };
+
+    track.keys.clear();
+    track.values.clear();
+
+    ClipFormat::TrackType type = ClipFormat::TrackType::Constant;
+    read(type);
+
+    if (type == ClipFormat::TrackType::Constant)
+    {
+        XMFLOAT4 value(0.0f, 0.0f, 0.0f, 0.0f);
+        read(value.x);
+        read(value.y);
+        read(value.z);
+
+        if (rotation)
+        {
+            read(value.w);
+        }
+
+        track.values.push_back(value);
+
+        return file.good();
+    }
+
+    if (type != ClipFormat::TrackType::Animated && type != ClipFormat::TrackType::Raw)
+    {
+        return false;
+    }
+
+    std::uint16_t count = 0;
+    read(count);
+
+    track.keys.resize(count);
+    file.read(reinterpret_cast<char*>(track.keys.data()), track.keys.size() * sizeof(std::uint16_t));
+
+    if (count == 0 || !std::is_sorted(track.keys.begin(), track.keys.end()) || track.keys.back() >= keyCount)
+    {
+        return false;
+    }
+
+    track.values.resize(count);
+
+    if (type == ClipFormat::TrackType::Raw)
+    {
+        for (auto& value : track.values)
+        {
+            value = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+            read(value.x);
+            read(value.y);
+            read(value.z);
+
+            if (rotation)
+            {
+                read(value.w);
+            }
+        }
+    }
+    else if (rotation)
+    {
+        for (auto& value : track.values)
+        {
+            std::uint16_t packed[3];
+            file.read(reinterpret_cast<char*>(packed), sizeof(packed));
+
+            value = ClipFormat::unpackRotation(packed);
+        }
+    }
+    else
+    {
+        float minimum[3], extent[3];
+        file.read(reinterpret_cast<char*>(minimum), sizeof(minimum));
+        file.read(reinterpret_cast<char*>(extent), sizeof(extent));
+
+        for (auto& value : track.values)
+        {
+            std::uint16_t quantised[3];
+            file.read(reinterpret_cast<char*>(quantised), sizeof(quantised));
+
+            value = XMFLOAT4(ClipFormat::dequantise(quantised[0], minimum[0], extent[0]),
+                             ClipFormat::dequantise(quantised[1], minimum[1], extent[1]),
+                             ClipFormat::dequantise(quantised[2], minimum[2], extent[2]),
+                             0.0f);
+        }
+    }
+
+    return file.good();
+}
+
+XMVECTOR ClipLoader::Track::evaluate(unsigned int key, const std::vector<float>& times, bool rotation) const
+{
+    if (keys.empty())
+    {
+        return XMLoadFloat4(&values.front());
+    }
+
+    const auto next = std::lower_bound(keys.begin(), keys.end(), key);
+
+    if (next == keys.end())
+    {
+        return XMLoadFloat4(&values.back());
+    }
+
+    const size_t i = next - keys.begin();
+
+    if (*next == key || i == 0)
+    {
+        return XMLoadFloat4(&values[i]);
+    }
+
+    /*dropped key, interpolate it from the kept neighbours*/
+    const unsigned int previous = keys[i - 1];
+    const float t = (times[key] - times[previous]) / (times[*next] - times[previous]);
+
+    const XMVECTOR v0 = XMLoadFloat4(&values[i - 1]);
+    const XMVECTOR v1 = XMLoadFloat4(&values[i]);
+
+    return rotation ? PoseSampler::blendRotation(v0, v1, t) : XMVectorLerp(v0, v1, t);
+}
+
+void ClipLoader::buildSampler(AnimationClip& clip) const
+{
+    clip.getStartTime();
+    clip.getEndTime();
+
+    /*the sampler holds its own copy, clips without one are still interpolated from their keys*/
+    if (clip.sampler.build(clip.boneAnimations) && !keepKeyFrames)
+    {
+        clip.releaseKeyFrames();
+    }
+}
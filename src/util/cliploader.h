@@ -1,16 +1,52 @@
 #pragma once
 
-#include "../render/renderstructs.h"
+#include "../render/animation.h"
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <cstdint>
 
 class ClipLoader
 {
 public:
-    explicit ClipLoader() = default;
+    /*@param keep the keys of the bone animations after the sampler is built, only tools that read them need this*/
+    explicit ClipLoader(bool keepKeyFrames = false)
+        : keepKeyFrames(keepKeyFrames)
+    {
+    }
+
     ~ClipLoader() = default;
 
+    /*loads version 1 and compressed version 2 clips, nullptr if the file is invalid or has an unsupported version*/
     std::unique_ptr<AnimationClip> loadCLP(const std::filesystem::directory_entry& fileName);
 
 private:
 
+    /*decoded track of a compressed clip*/
+    struct Track
+    {
+        /*indices into the key times of the clip, empty if the track is constant*/
+        std::vector<std::uint16_t> keys;
+        std::vector<DirectX::XMFLOAT4> values;
+
+        /*@returns value at a key of the clip, dropped keys are interpolated like the sampler interpolates them*/
+        DirectX::XMVECTOR evaluate(unsigned int key, const std::vector<float>& times, bool rotation) const;
+    };
+
+    /*reads the rest of a version 2 clip after its magic*/
+    std::unique_ptr<AnimationClip> loadCompressed(std::ifstream& file);
+
+    /*
+    @param file positioned at the track
+    @param track that receives the keys
+    @param true for rotation tracks
+    @param amount of keys of the clip
+    @returns false if the track is invalid
+    */
+    bool readTrack(std::ifstream& file, Track& track, bool rotation, int keyCount);
+
+    /*builds the sampler of a loaded clip and frees its keys if they are not kept*/
+    void buildSampler(AnimationClip& clip) const;
+
+    bool keepKeyFrames = false;
 };
\ No newline at end of file
@@ -52,11 +52,11 @@ bool CollisionDatabase::save()
     for(const auto& e : database)
     {
         json t;
-        t["Name"] = e.first;
-        t["Type"] = database[e.first].shapeType;
-        t["Extents"][0] = database[e.first].extents.x;
-        t["Extents"][1] = database[e.first].extents.y;
-        t["Extents"][2] = database[e.first].extents.z;
+        t["Name"] = e.second.name;
+        t["Type"] = e.second.shapeType;
+        t["Extents"][0] = e.second.extents.x;
+        t["Extents"][1] = e.second.extents.y;
+        t["Extents"][2] = e.second.extents.z;
         saveFile["collisions"].push_back(t);
     }
 
@@ -76,16 +76,38 @@ bool CollisionDatabase::save()
 
 bool CollisionDatabase::add(const std::string& modelName, int shapeType, DirectX::XMFLOAT3& extents)
 {
-    database[modelName] = CollisionInfo{ shapeType, extents };
+    database[StringTable::intern(modelName)] = CollisionInfo{ shapeType, extents, modelName };
     return true;
 }
 
 int CollisionDatabase::getShapeType(const std::string& modelName)
 {
-    return database[modelName].shapeType;
+    return getEntry(modelName).shapeType;
 }
 
 DirectX::XMFLOAT3& CollisionDatabase::getExtents(const std::string& modelName)
 {
-    return database[modelName].extents;
+    return getEntry(modelName).extents;
+}
+
+int CollisionDatabase::getShapeType(StringId modelId)
+{
+    return database[modelId].shapeType;
+}
+
+DirectX::XMFLOAT3& CollisionDatabase::getExtents(StringId modelId)
+{
+    return database[modelId].extents;
+}
+
+CollisionInfo& CollisionDatabase::getEntry(const std::string& modelName)
+{
+    auto& entry = database[StringId(modelName)];
+
+    if (entry.name.empty())
+    {
+        entry.name = modelName;
+    }
+
+    return entry;
 }
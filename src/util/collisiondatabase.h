@@ -2,11 +2,13 @@
 
 #include <unordered_map>
 #include "../util/mathhelper.h"
+#include "../util/stringid.h"
 
 struct CollisionInfo
 {
     int shapeType = 0;
     DirectX::XMFLOAT3 extents{};
+    std::string name;
 };
 
 class CollisionDatabase
@@ -22,7 +24,14 @@ public:
     int getShapeType(const std::string& modelName);
     DirectX::XMFLOAT3& getExtents(const std::string& modelName);
 
+    /*same as above without hashing the name again*/
+    int getShapeType(StringId modelId);
+    DirectX::XMFLOAT3& getExtents(StringId modelId);
+
 private:
     const std::string path = "data/cdb/data.json";
-    std::unordered_map<std::string, CollisionInfo> database;
+    std::unordered_map<StringId, CollisionInfo> database;
+
+    /*entry of a model, unknown models are added with their name so they are saved*/
+    CollisionInfo& getEntry(const std::string& modelName);
 };
\ No newline at end of file
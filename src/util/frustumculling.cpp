@@ -0,0 +1,147 @@
+#include "frustumculling.h"
+
+#if defined(_XM_AVX_INTRINSICS_) || defined(__AVX__)
+#include <immintrin.h>
+#define CULL_AVX
+#endif
+
+using namespace DirectX;
+
+/*one bit per lane of a comparison result*/
+static inline std::uint32_t moveMask(FXMVECTOR v)
+{
+#if defined(_XM_SSE_INTRINSICS_)
+    return (std::uint32_t)_mm_movemask_ps(v);
+#else
+    XMUINT4 m;
+    XMStoreUInt4(&m, v);
+    return (m.x >> 31) | ((m.y >> 31) << 1) | ((m.z >> 31) << 2) | ((m.w >> 31) << 3);
+#endif
+}
+
+void BoxCuller::clear()
+{
+    count = 0;
+
+    mask.clear();
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+}
+
+unsigned int BoxCuller::add(const DirectX::BoundingBox& box)
+{
+    if (count % BLOCK_SIZE == 0)
+    {
+        const size_t padded = (size_t)count + BLOCK_SIZE;
+
+        mask.push_back(0);
+
+        centerX.resize(padded, 0.0f);
+        centerY.resize(padded, 0.0f);
+        centerZ.resize(padded, 0.0f);
+        extentX.resize(padded, 0.0f);
+        extentY.resize(padded, 0.0f);
+        extentZ.resize(padded, 0.0f);
+    }
+
+    centerX[count] = box.Center.x;
+    centerY[count] = box.Center.y;
+    centerZ[count] = box.Center.z;
+    extentX[count] = box.Extents.x;
+    extentY[count] = box.Extents.y;
+    extentZ[count] = box.Extents.z;
+
+    return count++;
+}
+
+std::uint32_t BoxCuller::validBits(unsigned int block) const
+{
+    const unsigned int valid = count - block * BLOCK_SIZE;
+
+    return valid >= BLOCK_SIZE ? 0xFFFFFFFF : (1u << valid) - 1;
+}
+
+void BoxCuller::cull(const FrustumPlanes& frustum, unsigned int firstBlock, unsigned int lastBlock)
+{
+    lastBlock = (std::min)(lastBlock, getBlockCount());
+
+    /*plane coefficients, splatted per block*/
+    XMFLOAT4 p[6];
+    for (int i = 0; i < 6; i++)
+    {
+        XMStoreFloat4(&p[i], frustum.planes[i]);
+    }
+
+    for (unsigned int block = firstBlock; block < lastBlock; block++)
+    {
+        std::uint32_t word = 0;
+
+#if defined(CULL_AVX)
+        for (unsigned int j = 0; j < BLOCK_SIZE; j += 8)
+        {
+            const size_t i = (size_t)block * BLOCK_SIZE + j;
+
+            const __m256 cx = _mm256_loadu_ps(&centerX[i]);
+            const __m256 cy = _mm256_loadu_ps(&centerY[i]);
+            const __m256 cz = _mm256_loadu_ps(&centerZ[i]);
+            const __m256 ex = _mm256_loadu_ps(&extentX[i]);
+            const __m256 ey = _mm256_loadu_ps(&extentY[i]);
+            const __m256 ez = _mm256_loadu_ps(&extentZ[i]);
+
+            __m256 outside = _mm256_setzero_ps();
+
+            for (int k = 0; k < 6; k++)
+            {
+                const __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(p[k].x)),
+                                                                _mm256_mul_ps(cy, _mm256_set1_ps(p[k].y))),
+                                                  _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(p[k].z)),
+                                                                _mm256_set1_ps(p[k].w)));
+
+                const __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::abs(p[k].x))),
+                                                                  _mm256_mul_ps(ey, _mm256_set1_ps(std::abs(p[k].y)))),
+                                                    _mm256_mul_ps(ez, _mm256_set1_ps(std::abs(p[k].z))));
+
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, radius, _CMP_GT_OQ));
+            }
+
+            word |= (~(std::uint32_t)_mm256_movemask_ps(outside) & 0xFF) << j;
+        }
+#else
+        for (unsigned int j = 0; j < BLOCK_SIZE; j += 4)
+        {
+            const size_t i = (size_t)block * BLOCK_SIZE + j;
+
+            const XMVECTOR cx = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centerX[i]));
+            const XMVECTOR cy = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centerY[i]));
+            const XMVECTOR cz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centerZ[i]));
+            const XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&extentX[i]));
+            const XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&extentY[i]));
+            const XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&extentZ[i]));
+
+            XMVECTOR outside = XMVectorFalseInt();
+
+            for (int k = 0; k < 6; k++)
+            {
+                const XMVECTOR dist = XMVectorMultiplyAdd(cx, XMVectorReplicate(p[k].x),
+                                      XMVectorMultiplyAdd(cy, XMVectorReplicate(p[k].y),
+                                      XMVectorMultiplyAdd(cz, XMVectorReplicate(p[k].z), XMVectorReplicate(p[k].w))));
+
+                const XMVECTOR radius = XMVectorMultiplyAdd(ex, XMVectorReplicate(std::abs(p[k].x)),
+                                        XMVectorMultiplyAdd(ey, XMVectorReplicate(std::abs(p[k].y)),
+                                        XMVectorMultiply(ez, XMVectorReplicate(std::abs(p[k].z)))));
+
+                outside = XMVectorOrInt(outside, XMVectorGreater(dist, radius));
+            }
+
+            word |= (~moveMask(outside) & 0xF) << j;
+        }
+#endif
+
+        mask[block] = word & validBits(block);
+    }
+}
+
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "../util/mathhelper.h"
+#include <DirectXCollision.h>
+#include <vector>
+#include <cstdint>
+
+/*
+six planes of a frustum, the normals point outwards so points inside have a negative distance
+*/
+struct FrustumPlanes
+{
+    DirectX::XMVECTOR planes[6];
+
+    explicit FrustumPlanes(const DirectX::BoundingFrustum& frustum)
+    {
+        frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+    }
+
+    /*
+    extracts the planes of a view projection matrix with depth in [0, 1], orthographic projections work as well
+    @param view projection matrix
+    */
+    explicit FrustumPlanes(DirectX::FXMMATRIX viewProj)
+    {
+        using namespace DirectX;
+
+        /*the columns of the matrix are the rows of the transpose, inside is -w <= x,y <= w and 0 <= z <= w*/
+        const XMMATRIX t = XMMatrixTranspose(viewProj);
+
+        planes[0] = XMVectorNegate(XMVectorAdd(t.r[3], t.r[0]));
+        planes[1] = XMVectorNegate(XMVectorSubtract(t.r[3], t.r[0]));
+        planes[2] = XMVectorNegate(XMVectorAdd(t.r[3], t.r[1]));
+        planes[3] = XMVectorNegate(XMVectorSubtract(t.r[3], t.r[1]));
+        planes[4] = XMVectorNegate(t.r[2]);
+        planes[5] = XMVectorNegate(XMVectorSubtract(t.r[3], t.r[2]));
+
+        for (auto& p : planes)
+        {
+            p = XMPlaneNormalize(p);
+        }
+    }
+
+    /*
+    moves every plane outwards
+    @param distance in world units
+    */
+    void expand(float distance)
+    {
+        using namespace DirectX;
+
+        for (auto& p : planes)
+        {
+            p = XMVectorSetW(p, XMVectorGetW(p) - distance);
+        }
+    }
+
+    /*
+    classifies an axis aligned box without branching per plane
+    @param box center
+    @param box extents
+    @returns DISJOINT, INTERSECTS or CONTAINS
+    */
+    DirectX::ContainmentType classify(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) const
+    {
+        using namespace DirectX;
+
+        const XMVECTOR c = XMVectorSetW(XMLoadFloat3(&center), 1.0f);
+        const XMVECTOR e = XMLoadFloat3(&extents);
+
+        XMVECTOR outside = XMVectorFalseInt();
+        XMVECTOR inside = XMVectorTrueInt();
+
+        for (int i = 0; i < 6; i++)
+        {
+            const XMVECTOR dist = XMVector4Dot(c, planes[i]);
+            const XMVECTOR radius = XMVector3Dot(e, XMVectorAbs(planes[i]));
+
+            outside = XMVectorOrInt(outside, XMVectorGreater(dist, radius));
+            inside = XMVectorAndInt(inside, XMVectorLessOrEqual(dist, XMVectorNegate(radius)));
+        }
+
+        if (XMVector4EqualInt(outside, XMVectorTrueInt())) return DISJOINT;
+
+        return XMVector4EqualInt(inside, XMVectorTrueInt()) ? CONTAINS : INTERSECTS;
+    }
+
+    DirectX::ContainmentType classify(const DirectX::BoundingBox& box) const
+    {
+        return classify(box.Center, box.Extents);
+    }
+};
+
+/*
+tests many axis aligned boxes at once, the boxes are stored as structure of arrays and
+processed 8 (avx) or 4 (sse or the scalar directxmath path) at a time.
+the result is a bitmask with one bit per box in the order they were added.
+*/
+class BoxCuller
+{
+public:
+
+    /*default constructor*/
+    explicit BoxCuller() = default;
+
+    /*default destructor*/
+    ~BoxCuller() = default;
+
+    /*removes all boxes, keeps the memory*/
+    void clear();
+
+    /*
+    @param world space box
+    @returns index of the box in the mask
+    */
+    unsigned int add(const DirectX::BoundingBox& box);
+
+    static constexpr unsigned int BLOCK_SIZE = 32;
+
+    /*
+    tests all boxes against the planes, a set bit means the box is not completely outside.
+    boxes near the frustum corners can be reported as visible, so the result is conservative.
+    */
+    void cull(const FrustumPlanes& frustum)
+    {
+        cull(frustum, 0, getBlockCount());
+    }
+
+    /*
+    same as above for the boxes of the blocks [firstBlock, lastBlock) only,
+    every block owns one mask entry so different blocks can be culled on different threads
+    */
+    void cull(const FrustumPlanes& frustum, unsigned int firstBlock, unsigned int lastBlock);
+
+    /*
+    @returns amount of blocks of BLOCK_SIZE boxes
+    */
+    unsigned int getBlockCount() const
+    {
+        return (unsigned int)mask.size();
+    }
+
+    /*
+    @param index returned by add
+    @returns whether the box passed the last cull
+    */
+    bool isVisible(unsigned int index) const
+    {
+        return (mask[index >> 5] >> (index & 31)) & 1;
+    }
+
+    /*
+    @returns visibility bits of the last cull, 32 boxes per entry
+    */
+    const std::vector<std::uint32_t>& getMask() const
+    {
+        return mask;
+    }
+
+    unsigned int size() const
+    {
+        return count;
+    }
+
+private:
+
+    /*bits of a block that belong to added boxes and not to the padding*/
+    std::uint32_t validBits(unsigned int block) const;
+
+    unsigned int count = 0;
+
+    /*the arrays are always padded to whole blocks so the kernels never need a remainder loop*/
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+
+    std::vector<std::uint32_t> mask;
+};
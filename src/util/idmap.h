@@ -0,0 +1,168 @@
+#pragma once
+
+#include "../util/stringid.h"
+#include <memory>
+#include <stdexcept>
+
+/*
+owning registry keyed by the string id of the name.
+lookups with a StringId are plain integer hashing, lookups with a string only hash it and never copy it.
+iteration yields (name, pointer) pairs like an unordered_map keyed by the name.
+*/
+template<typename T>
+class IdMap
+{
+public:
+
+    using Entry = std::pair<const std::string, std::unique_ptr<T>>;
+    using Storage = std::unordered_map<StringId, Entry>;
+
+    template<typename Base, typename Value>
+    class Iterator
+    {
+    public:
+
+        Iterator() = default;
+
+        explicit Iterator(Base it)
+            : it(it)
+        {
+        }
+
+        Value& operator*() const
+        {
+            return it->second;
+        }
+
+        Value* operator->() const
+        {
+            return &it->second;
+        }
+
+        Iterator& operator++()
+        {
+            ++it;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return it == other.it;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return it != other.it;
+        }
+
+    private:
+
+        Base it;
+    };
+
+    using iterator = Iterator<typename Storage::iterator, Entry>;
+    using const_iterator = Iterator<typename Storage::const_iterator, const Entry>;
+
+    /*
+    @param id of the name
+    @returns the entry, an empty one is added if the id is unknown
+    */
+    std::unique_ptr<T>& operator[](StringId id)
+    {
+        auto entry = entries.find(id);
+
+        if (entry == entries.end())
+        {
+            entry = entries.try_emplace(id, StringTable::lookup(id), nullptr).first;
+        }
+
+        return entry->second.second;
+    }
+
+    /*
+    @param name
+    @returns the entry, an empty one is added and the name interned if it is unknown.
+    if the name collides with the id of another name the collision is logged and a runtime_error is thrown,
+    the entry of the other name is neither returned nor overwritten
+    */
+    std::unique_ptr<T>& operator[](const std::string& name)
+    {
+        const StringId id(name);
+        auto entry = entries.find(id);
+
+        if (entry == entries.end())
+        {
+            entry = entries.try_emplace(StringTable::intern(name), name, nullptr).first;
+        }
+        else if (entry->second.first != name)
+        {
+            StringTable::reportCollision(entry->second.first, name);
+            throw std::runtime_error("String id collision between " + entry->second.first + " and " + name + "!");
+        }
+
+        return entry->second.second;
+    }
+
+    iterator find(StringId id)
+    {
+        return iterator(entries.find(id));
+    }
+
+    iterator find(const std::string& name)
+    {
+        auto entry = entries.find(StringId(name));
+
+        return iterator(entry != entries.end() && entry->second.first == name ? entry : entries.end());
+    }
+
+    const_iterator find(StringId id) const
+    {
+        return const_iterator(entries.find(id));
+    }
+
+    const_iterator find(const std::string& name) const
+    {
+        auto entry = entries.find(StringId(name));
+
+        return const_iterator(entry != entries.end() && entry->second.first == name ? entry : entries.end());
+    }
+
+    iterator begin()
+    {
+        return iterator(entries.begin());
+    }
+
+    iterator end()
+    {
+        return iterator(entries.end());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(entries.begin());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(entries.end());
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    bool empty() const
+    {
+        return entries.empty();
+    }
+
+    void clear()
+    {
+        entries.clear();
+    }
+
+private:
+
+    Storage entries;
+};
@@ -0,0 +1,156 @@
+#include "jobsystem.h"
+#include <algorithm>
+
+/*queue of the current thread, threads that are no workers share the last queue*/
+static thread_local int currentQueue = -1;
+
+JobSystem::JobSystem(unsigned int workerCount)
+{
+    for (unsigned int i = 0; i <= workerCount; i++)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+        running = false;
+    }
+
+    wakeCondition.notify_all();
+
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+void JobSystem::run(unsigned int count, unsigned int chunkSize, const void* job, JobFunction invoke)
+{
+    if (count == 0) return;
+
+    if (chunkSize == 0) chunkSize = 1;
+
+    /*not worth waking anybody up*/
+    if (workers.empty() || count <= chunkSize)
+    {
+        invoke(job, 0, count);
+        return;
+    }
+
+    const unsigned int chunks = (count + chunkSize - 1) / chunkSize;
+    std::atomic<unsigned int> remaining{ chunks };
+
+    /*counted before any chunk becomes visible, a worker that pops one right away must not take the count below zero*/
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+        queuedTasks += chunks;
+    }
+
+    /*distribute the chunks round robin so every worker starts with local work*/
+    for (unsigned int c = 0; c < chunks; c++)
+    {
+        auto& q = *queues[c % queues.size()];
+
+        std::lock_guard<std::mutex> lock(q.lock);
+        q.tasks.push_back({ job, invoke, c * chunkSize, (std::min)(count, (c + 1) * chunkSize), &remaining });
+    }
+
+    wakeCondition.notify_all();
+
+    /*help until all chunks of this job are finished*/
+    const unsigned int ownQueue = currentQueue < 0 ? (unsigned int)workers.size() : (unsigned int)currentQueue;
+
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        Task task;
+
+        if (popTask(ownQueue, task))
+        {
+            runTask(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::popTask(unsigned int queueIndex, Task& task)
+{
+    {
+        auto& q = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock(q.lock);
+
+        if (q.first < q.tasks.size())
+        {
+            task = q.tasks.back();
+            q.tasks.pop_back();
+            queuedTasks--;
+
+            if (q.first == q.tasks.size())
+            {
+                q.tasks.clear();
+                q.first = 0;
+            }
+
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        auto& q = *queues[(queueIndex + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.lock);
+
+        if (q.first < q.tasks.size())
+        {
+            task = q.tasks[q.first++];
+            queuedTasks--;
+
+            if (q.first == q.tasks.size())
+            {
+                q.tasks.clear();
+                q.first = 0;
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::runTask(const Task& task)
+{
+    task.invoke(task.job, task.begin, task.end);
+    task.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    currentQueue = (int)index;
+
+    while (true)
+    {
+        Task task;
+
+        if (popTask(index, task))
+        {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeLock);
+        wakeCondition.wait(lock, [&] { return !running || queuedTasks > 0; });
+
+        if (!running) return;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+small work stealing thread pool for per frame jobs.
+every worker has its own queue and steals from the others when it runs empty,
+the thread that starts a job works on it as well until all chunks are done.
+*/
+class JobSystem
+{
+public:
+
+    /*
+    starts the worker threads
+    @param amount of worker threads, 0 runs every job on the calling thread
+    */
+    explicit JobSystem(unsigned int workerCount);
+
+    /*stops and joins all workers*/
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /*
+    splits [0, count) into chunks of a fixed size and runs them in parallel, returns when all chunks are done.
+    the chunk borders do not depend on the amount of threads, so jobs that only write to their own range are deterministic.
+    @param amount of elements
+    @param elements per chunk
+    @param function called with the begin and end of a chunk, only referenced until the call returns so lambdas are not copied or allocated
+    */
+    template<typename Job>
+    void parallelFor(unsigned int count, unsigned int chunkSize, const Job& job)
+    {
+        run(count, chunkSize, &job, [](const void* context, unsigned int begin, unsigned int end)
+        {
+            (*static_cast<const Job*>(context))(begin, end);
+        });
+    }
+
+    /*
+    @returns amount of threads working on a job including the calling thread
+    */
+    unsigned int getThreadCount() const
+    {
+        return (unsigned int)workers.size() + 1;
+    }
+
+private:
+
+    /*calls the job behind the context pointer*/
+    using JobFunction = void (*)(const void*, unsigned int, unsigned int);
+
+    /*type erased parallelFor*/
+    void run(unsigned int count, unsigned int chunkSize, const void* job, JobFunction invoke);
+
+    struct Task
+    {
+        const void* job = nullptr;
+        JobFunction invoke = nullptr;
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        std::atomic<unsigned int>* remaining = nullptr;
+    };
+
+    /*tasks[first] to tasks.back() are queued, the vector is cleared when it runs empty so its capacity is kept for the next frames*/
+    struct Queue
+    {
+        std::mutex lock;
+        std::vector<Task> tasks;
+        size_t first = 0;
+    };
+
+    /*takes a task from the back of the own queue or steals one from the front of another queue*/
+    bool popTask(unsigned int queueIndex, Task& task);
+    void runTask(const Task& task);
+    void workerLoop(unsigned int index);
+
+    /*one queue per worker and one for threads that are not workers*/
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex wakeLock;
+    std::condition_variable wakeCondition;
+    std::atomic<unsigned int> queuedTasks{ 0 };
+    std::atomic<bool> running{ true };
+};
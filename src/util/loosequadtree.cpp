@@ -0,0 +1,263 @@
+#include "loosequadtree.h"
+#include "../util/frustumculling.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+unsigned int LooseQuadTree::mortonCode(unsigned int x, unsigned int z)
+{
+    auto spread = [](unsigned int v)
+    {
+        v &= 0x0000FFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+
+    return spread(x) | (spread(z) << 1);
+}
+
+void LooseQuadTree::build(DirectX::XMFLOAT3 center, float x, float z, int depth)
+{
+    if (depth < 1) depth = 1;
+    if (depth > (int)MAX_LEVELS - 1) depth = MAX_LEVELS - 1;
+
+    leafLevel = (unsigned int)depth;
+    rootCenter = center;
+    rootSize = { x, z };
+    minY = center.y - 64.0f;
+    maxY = center.y + 64.0f;
+
+    const unsigned int nodeCount = levelOffset(leafLevel + 1);
+
+    nodeCenters.resize(nodeCount);
+    nodeObjects.assign(nodeCount, {});
+    subtreeCount.assign(nodeCount, 0);
+
+    for (unsigned int l = 0; l <= leafLevel; l++)
+    {
+        const unsigned int res = 1u << l;
+
+        for (unsigned int cz = 0; cz < res; cz++)
+        {
+            for (unsigned int cx = 0; cx < res; cx++)
+            {
+                nodeCenters[levelOffset(l) + mortonCode(cx, cz)] = { center.x - x / 2.0f + (cx + 0.5f) * x / res,
+                                                                     center.z - z / 2.0f + (cz + 0.5f) * z / res };
+            }
+        }
+    }
+
+    entries.clear();
+    freeHandles.clear();
+    objectCount = 0;
+}
+
+void LooseQuadTree::findNode(const DirectX::BoundingBox& bounds, unsigned int& level, unsigned int& code) const
+{
+    const float size = (std::max)(bounds.Extents.x, bounds.Extents.z);
+
+    /*an object fits into a node if it is not larger than half the cell, the loose bounds are twice the cell*/
+    level = 0;
+    while (level < leafLevel && size <= (std::min)(rootSize.x, rootSize.y) / (float)(2u << (level + 1)))
+    {
+        level++;
+    }
+
+    const unsigned int res = 1u << level;
+    const int cx = (int)std::floor((bounds.Center.x - rootCenter.x + rootSize.x / 2.0f) / rootSize.x * res);
+    const int cz = (int)std::floor((bounds.Center.z - rootCenter.z + rootSize.y / 2.0f) / rootSize.y * res);
+
+    /*outside of the area, the root is always searched*/
+    if (cx < 0 || cz < 0 || cx >= (int)res || cz >= (int)res)
+    {
+        level = 0;
+        code = 0;
+        return;
+    }
+
+    code = mortonCode((unsigned int)cx, (unsigned int)cz);
+}
+
+bool LooseQuadTree::insideLooseBounds(const DirectX::BoundingBox& bounds, unsigned int level, unsigned int code) const
+{
+    /*the root also holds everything outside of the area*/
+    if (level == 0) return true;
+
+    const XMFLOAT2& c = nodeCenters[(size_t)levelOffset(level) + code];
+    const float res = (float)(1u << level);
+
+    return std::abs(bounds.Center.x - c.x) + bounds.Extents.x <= rootSize.x / res &&
+           std::abs(bounds.Center.z - c.y) + bounds.Extents.z <= rootSize.y / res;
+}
+
+void LooseQuadTree::extendHeight(const DirectX::BoundingBox& bounds)
+{
+    minY = (std::min)(minY, bounds.Center.y - bounds.Extents.y);
+    maxY = (std::max)(maxY, bounds.Center.y + bounds.Extents.y);
+}
+
+void LooseQuadTree::addToNode(unsigned int handle, unsigned int level, unsigned int code)
+{
+    auto& e = entries[handle];
+    auto& list = nodeObjects[(size_t)levelOffset(level) + code];
+
+    e.level = level;
+    e.code = code;
+    e.slot = (unsigned int)list.size();
+    list.push_back(handle);
+
+    for (unsigned int l = level, c = code; ; l--, c >>= 2)
+    {
+        subtreeCount[(size_t)levelOffset(l) + c]++;
+        if (l == 0) break;
+    }
+}
+
+void LooseQuadTree::removeFromNode(unsigned int handle)
+{
+    const auto& e = entries[handle];
+    auto& list = nodeObjects[(size_t)levelOffset(e.level) + e.code];
+
+    /*swap with the last handle of the node*/
+    const unsigned int last = list.back();
+    list[e.slot] = last;
+    entries[last].slot = e.slot;
+    list.pop_back();
+
+    for (unsigned int l = e.level, c = e.code; ; l--, c >>= 2)
+    {
+        subtreeCount[(size_t)levelOffset(l) + c]--;
+        if (l == 0) break;
+    }
+}
+
+unsigned int LooseQuadTree::insert(GameObject* gO, const DirectX::BoundingBox& bounds)
+{
+    if (nodeObjects.empty()) return INVALID_HANDLE;
+
+    unsigned int handle = 0;
+
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else
+    {
+        handle = (unsigned int)entries.size();
+        entries.emplace_back();
+    }
+
+    entries[handle].object = gO;
+    entries[handle].used = true;
+
+    unsigned int level = 0, code = 0;
+    findNode(bounds, level, code);
+    extendHeight(bounds);
+    addToNode(handle, level, code);
+
+    objectCount++;
+
+    return handle;
+}
+
+void LooseQuadTree::update(unsigned int handle, const DirectX::BoundingBox& bounds)
+{
+    if (handle >= entries.size() || !entries[handle].used) return;
+
+    unsigned int level = 0, code = 0;
+    findNode(bounds, level, code);
+    extendHeight(bounds);
+
+    const auto& e = entries[handle];
+
+    /*the size still selects the same level and the object did not leave the loose bounds of its node*/
+    if (level == e.level && (code == e.code || insideLooseBounds(bounds, e.level, e.code))) return;
+
+    removeFromNode(handle);
+    addToNode(handle, level, code);
+}
+
+void LooseQuadTree::remove(unsigned int handle)
+{
+    if (handle >= entries.size() || !entries[handle].used) return;
+
+    removeFromNode(handle);
+
+    entries[handle].object = nullptr;
+    entries[handle].used = false;
+    freeHandles.push_back(handle);
+
+    objectCount--;
+}
+
+DirectX::BoundingBox LooseQuadTree::getNodeBounds(unsigned int level, unsigned int code) const
+{
+    const XMFLOAT2& c = nodeCenters[(size_t)levelOffset(level) + code];
+    const float res = (float)(1u << level);
+
+    /*extents of the loose bounds are the full cell size*/
+    return BoundingBox({ c.x, (minY + maxY) / 2.0f, c.y }, { rootSize.x / res, (maxY - minY) / 2.0f, rootSize.y / res });
+}
+
+template<typename Test>
+void LooseQuadTree::search(const Test& test, std::vector<GameObject*>& objects) const
+{
+    if (subtreeCount.empty() || subtreeCount[0] == 0) return;
+
+    /*explicit stack of (level, morton code, completely inside)*/
+    unsigned int stackLevel[3 * MAX_LEVELS + 1];
+    unsigned int stackCode[3 * MAX_LEVELS + 1];
+    bool stackInside[3 * MAX_LEVELS + 1];
+    unsigned int top = 0;
+
+    stackLevel[top] = 0;
+    stackCode[top] = 0;
+    stackInside[top++] = false;
+
+    while (top > 0)
+    {
+        top--;
+        const unsigned int level = stackLevel[top];
+        const unsigned int code = stackCode[top];
+        const unsigned int node = levelOffset(level) + code;
+        bool inside = stackInside[top];
+
+        if (subtreeCount[node] == 0) continue;
+
+        /*the root also holds everything outside of the area and is never skipped*/
+        if (!inside && level > 0)
+        {
+            const ContainmentType result = test(getNodeBounds(level, code));
+
+            if (result == DISJOINT) continue;
+
+            inside = result == CONTAINS;
+        }
+
+        for (const auto h : nodeObjects[node])
+        {
+            objects.push_back(entries[h].object);
+        }
+
+        if (level == leafLevel) continue;
+
+        for (unsigned int c = 4; c > 0; c--)
+        {
+            stackLevel[top] = level + 1;
+            stackCode[top] = (code << 2) | (c - 1);
+            stackInside[top++] = inside;
+        }
+    }
+}
+
+void LooseQuadTree::searchCollision(const DirectX::BoundingFrustum& frustum, std::vector<GameObject*>& objects) const
+{
+    const FrustumPlanes planes(frustum);
+
+    search([&](const BoundingBox& box) { return planes.classify(box); }, objects);
+}
+
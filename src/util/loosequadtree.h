@@ -0,0 +1,132 @@
+#pragma once
+
+class GameObject;
+
+#include "../util/mathhelper.h"
+#include <DirectXCollision.h>
+#include <vector>
+#include <climits>
+
+/*
+loose quad tree for objects that move, every object is stored in exactly one node.
+the node is chosen from the object size and center in O(1) and the bounds of a node are twice its cell size,
+so moving objects only change their node when they leave these loose bounds or their size selects another level.
+nodes are stored level by level in morton order like in the linear quad tree.
+*/
+class LooseQuadTree
+{
+
+public:
+
+    static constexpr unsigned int INVALID_HANDLE = UINT_MAX;
+
+    /*default constructor*/
+    explicit LooseQuadTree() = default;
+
+    /*default destructor*/
+    ~LooseQuadTree() = default;
+
+    /*builds the empty tree, removes all objects
+    @param center of the area
+    @param width
+    @param length
+    @param how deep the tree will subdivide the area
+    */
+    void build(DirectX::XMFLOAT3 center, float x, float z, int depth);
+
+    /*
+    inserts a game object, objects outside of the area are stored in the root
+    @param game object
+    @param world space bounds of the object
+    @returns handle used for update and remove
+    */
+    unsigned int insert(GameObject* gO, const DirectX::BoundingBox& bounds);
+
+    /*
+    moves an object to the node that fits its new bounds, it stays in its node as long as it is inside the loose bounds
+    @param handle returned by insert
+    @param new world space bounds
+    */
+    void update(unsigned int handle, const DirectX::BoundingBox& bounds);
+
+    /*
+    removes an object, the handle can be reused by the next insert
+    @param handle returned by insert
+    */
+    void remove(unsigned int handle);
+
+    /*
+    @returns amount of stored objects
+    */
+    unsigned int size() const
+    {
+        return objectCount;
+    }
+
+    /*
+    collects all objects in nodes that intersect the frustum, every object is added only once
+    @param frustum that is used for collision check
+    @param objects in intersecting nodes will be stored here
+    */
+    void searchCollision(const DirectX::BoundingFrustum& frustum, std::vector<GameObject*>& objects) const;
+
+private:
+
+    static constexpr unsigned int MAX_LEVELS = 10;
+
+    struct Entry
+    {
+        GameObject* object = nullptr;
+        unsigned int level = 0;
+        unsigned int code = 0;
+        unsigned int slot = 0;
+        bool used = false;
+    };
+
+    /*index of the first node of a level*/
+    static unsigned int levelOffset(unsigned int level)
+    {
+        return ((1u << (2 * level)) - 1) / 3;
+    }
+
+    static unsigned int mortonCode(unsigned int x, unsigned int z);
+
+    /*finds the deepest node whose loose bounds contain the bounds*/
+    void findNode(const DirectX::BoundingBox& bounds, unsigned int& level, unsigned int& code) const;
+
+    /*@returns true if the x/z extents of the bounds are inside the loose bounds of the node*/
+    bool insideLooseBounds(const DirectX::BoundingBox& bounds, unsigned int level, unsigned int code) const;
+
+    void addToNode(unsigned int handle, unsigned int level, unsigned int code);
+    void removeFromNode(unsigned int handle);
+
+    /*grows the height that is covered by all nodes*/
+    void extendHeight(const DirectX::BoundingBox& bounds);
+
+    /*loose bounds of a node, the height covers all objects ever inserted*/
+    DirectX::BoundingBox getNodeBounds(unsigned int level, unsigned int code) const;
+
+    /*stack traversal shared by both searches, test returns the containment of a node box*/
+    template<typename Test>
+    void search(const Test& test, std::vector<GameObject*>& objects) const;
+
+    unsigned int leafLevel = 0;
+    unsigned int objectCount = 0;
+
+    DirectX::XMFLOAT3 rootCenter = { 0.0f,0.0f,0.0f };
+    DirectX::XMFLOAT2 rootSize = { 0.0f,0.0f };
+    float minY = 0.0f;
+    float maxY = 0.0f;
+
+    /*center of the cell of each node in x/z*/
+    std::vector<DirectX::XMFLOAT2> nodeCenters;
+
+    /*handles of the objects stored in each node*/
+    std::vector<std::vector<unsigned int>> nodeObjects;
+
+    /*amount of objects in each node and all nodes below it, used to skip empty subtrees*/
+    std::vector<unsigned int> subtreeCount;
+
+    std::vector<Entry> entries;
+    std::vector<unsigned int> freeHandles;
+};
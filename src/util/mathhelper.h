@@ -1,6 +1,8 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #define _XM_AVX_INTRINSICS_
 
 #include <DirectXMath.h>
@@ -102,9 +104,9 @@ public:
     {
         DirectX::XMFLOAT3 res{};
 
-        res.x = std::sinf(V.y) * std::cosf(V.x);
-        res.y = std::sinf(-V.x);
-        res.z = std::cosf(V.x) * std::cosf(V.y);
+        res.x = std::sin(V.y) * std::cos(V.x);
+        res.y = std::sin(-V.x);
+        res.z = std::cos(V.x) * std::cos(V.y);
 
         return res;
     }
@@ -137,7 +139,7 @@ public:
 
     static float biasFunction(float x, float bias)
     {
-        float k = std::powf(1 - bias, 3);
+        float k = std::pow(1 - bias, 3.0f);
         return (x * k) / (x * k - x + 1);
     }
 
@@ -0,0 +1,385 @@
+#include "occlusionculler.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height)
+{
+    this->width = (((std::max)(width, 8u) + 7) / 8) * 8;
+    this->height = (((std::max)(height, 8u) + 7) / 8) * 8;
+
+    tilesX = (this->width + TILE_WIDTH - 1) / TILE_WIDTH;
+    tilesY = (this->height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+    depth.assign((size_t)this->width * this->height, 1.0f);
+    tileTriangles.resize((size_t)tilesX * tilesY);
+
+    /*depth hierarchy down to a single tile*/
+    unsigned int hw = this->width / HIZ_SIZE;
+    unsigned int hh = this->height / HIZ_SIZE;
+
+    while (true)
+    {
+        hiZSize.push_back({ hw, hh });
+        hiZ.emplace_back((size_t)hw * hh, 1.0f);
+
+        if (hw == 1 && hh == 1) break;
+
+        hw = (hw + 1) / 2;
+        hh = (hh + 1) / 2;
+    }
+
+    XMStoreFloat4x4(&viewProj, XMMatrixIdentity());
+}
+
+void OcclusionCuller::begin(FXMMATRIX viewProj)
+{
+    XMStoreFloat4x4(&this->viewProj, viewProj);
+
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    triangles.clear();
+
+    for (auto& t : tileTriangles)
+    {
+        t.clear();
+    }
+}
+
+void OcclusionCuller::addOccluder(const XMFLOAT3 corners[4])
+{
+    const XMMATRIX vp = XMLoadFloat4x4(&viewProj);
+
+    XMFLOAT4 clip[4];
+
+    for (int i = 0; i < 4; i++)
+    {
+        XMStoreFloat4(&clip[i], XMVector4Transform(XMVectorSetW(XMLoadFloat3(&corners[i]), 1.0f), vp));
+    }
+
+    /*clip the quad against the near plane z >= 0, a quad can gain one vertex*/
+    XMFLOAT4 poly[5];
+    int count = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        const XMFLOAT4& a = clip[i];
+        const XMFLOAT4& b = clip[(i + 1) % 4];
+
+        if (a.z >= 0.0f)
+        {
+            poly[count++] = a;
+        }
+
+        if ((a.z >= 0.0f) != (b.z >= 0.0f))
+        {
+            const float t = a.z / (a.z - b.z);
+
+            poly[count++] = { a.x + (b.x - a.x) * t,
+                              a.y + (b.y - a.y) * t,
+                              0.0f,
+                              a.w + (b.w - a.w) * t };
+        }
+    }
+
+    if (count < 3) return;
+
+    /*to pixels, y goes down*/
+    XMFLOAT3 screen[5];
+
+    for (int i = 0; i < count; i++)
+    {
+        const float invW = 1.0f / (std::max)(poly[i].w, 1e-6f);
+
+        screen[i] = { (poly[i].x * invW * 0.5f + 0.5f) * width,
+                      (0.5f - poly[i].y * invW * 0.5f) * height,
+                      poly[i].z * invW };
+    }
+
+    for (int i = 1; i < count - 1; i++)
+    {
+        addTriangle(screen[0], screen[i], screen[i + 1]);
+    }
+}
+
+void OcclusionCuller::addWallOccluder(const BoundingBox& box)
+{
+    /*the quad lies in the middle of the thinner horizontal axis*/
+    const float inset = 0.9f;
+    const float ey = box.Extents.y * inset;
+
+    XMFLOAT3 corners[4];
+
+    if (box.Extents.x >= box.Extents.z)
+    {
+        const float ex = box.Extents.x * inset;
+
+        corners[0] = { box.Center.x - ex, box.Center.y - ey, box.Center.z };
+        corners[1] = { box.Center.x + ex, box.Center.y - ey, box.Center.z };
+        corners[2] = { box.Center.x + ex, box.Center.y + ey, box.Center.z };
+        corners[3] = { box.Center.x - ex, box.Center.y + ey, box.Center.z };
+    }
+    else
+    {
+        const float ez = box.Extents.z * inset;
+
+        corners[0] = { box.Center.x, box.Center.y - ey, box.Center.z - ez };
+        corners[1] = { box.Center.x, box.Center.y - ey, box.Center.z + ez };
+        corners[2] = { box.Center.x, box.Center.y + ey, box.Center.z + ez };
+        corners[3] = { box.Center.x, box.Center.y + ey, box.Center.z - ez };
+    }
+
+    addOccluder(corners);
+}
+
+void OcclusionCuller::addTriangle(XMFLOAT3 v0, XMFLOAT3 v1, XMFLOAT3 v2)
+{
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+    if (std::abs(area) < 1e-6f) return;
+
+    /*occluders are double sided, flip to get positive edge functions inside*/
+    if (area < 0.0f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    Triangle tri;
+
+    tri.minX = (std::max)(0, (int)std::floor((std::min)({ v0.x, v1.x, v2.x })));
+    tri.minY = (std::max)(0, (int)std::floor((std::min)({ v0.y, v1.y, v2.y })));
+    tri.maxX = (std::min)((int)width - 1, (int)std::ceil((std::max)({ v0.x, v1.x, v2.x })));
+    tri.maxY = (std::min)((int)height - 1, (int)std::ceil((std::max)({ v0.y, v1.y, v2.y })));
+
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) return;
+
+    const XMFLOAT3* v[3] = { &v0, &v1, &v2 };
+
+    /*edge i is opposite of vertex i*/
+    for (int i = 0; i < 3; i++)
+    {
+        const XMFLOAT3& a = *v[(i + 1) % 3];
+        const XMFLOAT3& b = *v[(i + 2) % 3];
+
+        tri.edgeA[i] = a.y - b.y;
+        tri.edgeB[i] = b.x - a.x;
+        tri.edgeC[i] = (b.y - a.y) * a.x - (b.x - a.x) * a.y;
+    }
+
+    /*the edge functions are the barycentric weights times the area*/
+    const float invArea = 1.0f / area;
+
+    tri.depthA = (tri.edgeA[0] * v0.z + tri.edgeA[1] * v1.z + tri.edgeA[2] * v2.z) * invArea;
+    tri.depthB = (tri.edgeB[0] * v0.z + tri.edgeB[1] * v1.z + tri.edgeB[2] * v2.z) * invArea;
+    tri.depthC = (tri.edgeC[0] * v0.z + tri.edgeC[1] * v1.z + tri.edgeC[2] * v2.z) * invArea;
+
+    const unsigned int index = (unsigned int)triangles.size();
+    triangles.push_back(tri);
+
+    for (unsigned int ty = tri.minY / TILE_HEIGHT; ty <= (unsigned int)tri.maxY / TILE_HEIGHT; ty++)
+    {
+        for (unsigned int tx = tri.minX / TILE_WIDTH; tx <= (unsigned int)tri.maxX / TILE_WIDTH; tx++)
+        {
+            tileTriangles[(size_t)ty * tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void OcclusionCuller::rasterize(JobSystem* jobs)
+{
+    const unsigned int tileCount = tilesX * tilesY;
+
+    if (jobs)
+    {
+        jobs->parallelFor(tileCount, 1, [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int t = first; t < last; t++)
+            {
+                rasterizeTile(t);
+            }
+        });
+    }
+    else
+    {
+        for (unsigned int t = 0; t < tileCount; t++)
+        {
+            rasterizeTile(t);
+        }
+    }
+
+    buildHiZ();
+}
+
+void OcclusionCuller::rasterizeTile(unsigned int tile)
+{
+    const int tileX = (int)((tile % tilesX) * TILE_WIDTH);
+    const int tileY = (int)((tile / tilesX) * TILE_HEIGHT);
+    const int tileMaxX = (std::min)(tileX + (int)TILE_WIDTH, (int)width) - 1;
+    const int tileMaxY = (std::min)(tileY + (int)TILE_HEIGHT, (int)height) - 1;
+
+    const XMVECTOR laneOffset = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+    const XMVECTOR zero = XMVectorZero();
+
+    for (const auto index : tileTriangles[tile])
+    {
+        const Triangle& tri = triangles[index];
+
+        /*4 pixel aligned start, the width is a multiple of 8 so a group never leaves the row*/
+        const int x0 = (std::max)(tri.minX, tileX) & ~3;
+        const int x1 = (std::min)(tri.maxX, tileMaxX);
+        const int y0 = (std::max)(tri.minY, tileY);
+        const int y1 = (std::min)(tri.maxY, tileMaxY);
+
+        const XMVECTOR a0 = XMVectorReplicate(tri.edgeA[0]);
+        const XMVECTOR a1 = XMVectorReplicate(tri.edgeA[1]);
+        const XMVECTOR a2 = XMVectorReplicate(tri.edgeA[2]);
+        const XMVECTOR za = XMVectorReplicate(tri.depthA);
+
+        const XMVECTOR step0 = XMVectorReplicate(tri.edgeA[0] * 4.0f);
+        const XMVECTOR step1 = XMVectorReplicate(tri.edgeA[1] * 4.0f);
+        const XMVECTOR step2 = XMVectorReplicate(tri.edgeA[2] * 4.0f);
+        const XMVECTOR stepZ = XMVectorReplicate(tri.depthA * 4.0f);
+
+        const XMVECTOR px = XMVectorAdd(XMVectorReplicate((float)x0), laneOffset);
+
+        for (int y = y0; y <= y1; y++)
+        {
+            const float py = y + 0.5f;
+
+            /*edge functions and depth of the first 4 pixels of the row*/
+            XMVECTOR e0 = XMVectorMultiplyAdd(a0, px, XMVectorReplicate(tri.edgeB[0] * py + tri.edgeC[0]));
+            XMVECTOR e1 = XMVectorMultiplyAdd(a1, px, XMVectorReplicate(tri.edgeB[1] * py + tri.edgeC[1]));
+            XMVECTOR e2 = XMVectorMultiplyAdd(a2, px, XMVectorReplicate(tri.edgeB[2] * py + tri.edgeC[2]));
+            XMVECTOR z = XMVectorMultiplyAdd(za, px, XMVectorReplicate(tri.depthB * py + tri.depthC));
+
+            float* row = &depth[(size_t)y * width];
+
+            for (int x = x0; x <= x1; x += 4)
+            {
+                const XMVECTOR inside = XMVectorAndInt(XMVectorAndInt(XMVectorGreaterOrEqual(e0, zero),
+                                                                      XMVectorGreaterOrEqual(e1, zero)),
+                                                       XMVectorGreaterOrEqual(e2, zero));
+
+                XMFLOAT4* target = reinterpret_cast<XMFLOAT4*>(row + x);
+                const XMVECTOR old = XMLoadFloat4(target);
+
+                XMStoreFloat4(target, XMVectorSelect(old, XMVectorMin(old, z), inside));
+
+                e0 = XMVectorAdd(e0, step0);
+                e1 = XMVectorAdd(e1, step1);
+                e2 = XMVectorAdd(e2, step2);
+                z = XMVectorAdd(z, stepZ);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::buildHiZ()
+{
+    /*level 0 from the depth buffer*/
+    auto& base = hiZ[0];
+    const XMUINT2 baseSize = hiZSize[0];
+
+    for (unsigned int ty = 0; ty < baseSize.y; ty++)
+    {
+        for (unsigned int tx = 0; tx < baseSize.x; tx++)
+        {
+            float maxDepth = 0.0f;
+
+            for (unsigned int y = ty * HIZ_SIZE; y < (ty + 1) * HIZ_SIZE; y++)
+            {
+                const float* row = &depth[(size_t)y * width + tx * HIZ_SIZE];
+
+                for (unsigned int x = 0; x < HIZ_SIZE; x++)
+                {
+                    maxDepth = (std::max)(maxDepth, row[x]);
+                }
+            }
+
+            base[(size_t)ty * baseSize.x + tx] = maxDepth;
+        }
+    }
+
+    /*every further level is the max of 2x2 tiles of the level below*/
+    for (size_t l = 1; l < hiZ.size(); l++)
+    {
+        const auto& src = hiZ[l - 1];
+        const XMUINT2 srcSize = hiZSize[l - 1];
+        const XMUINT2 dstSize = hiZSize[l];
+
+        for (unsigned int y = 0; y < dstSize.y; y++)
+        {
+            for (unsigned int x = 0; x < dstSize.x; x++)
+            {
+                const unsigned int sx0 = 2 * x, sx1 = (std::min)(2 * x + 1, srcSize.x - 1);
+                const unsigned int sy0 = 2 * y, sy1 = (std::min)(2 * y + 1, srcSize.y - 1);
+
+                hiZ[l][(size_t)y * dstSize.x + x] = (std::max)((std::max)(src[(size_t)sy0 * srcSize.x + sx0], src[(size_t)sy0 * srcSize.x + sx1]),
+                                                               (std::max)(src[(size_t)sy1 * srcSize.x + sx0], src[(size_t)sy1 * srcSize.x + sx1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const BoundingBox& box) const
+{
+    const XMMATRIX vp = XMLoadFloat4x4(&viewProj);
+
+    XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+    box.GetCorners(corners);
+
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+    for (size_t i = 0; i < BoundingBox::CORNER_COUNT; i++)
+    {
+        XMFLOAT4 c;
+        XMStoreFloat4(&c, XMVector4Transform(XMVectorSetW(XMLoadFloat3(&corners[i]), 1.0f), vp));
+
+        /*crosses the near plane*/
+        if (c.z < 0.0f || c.w <= 1e-6f) return true;
+
+        const float invW = 1.0f / c.w;
+
+        minX = (std::min)(minX, c.x * invW);
+        maxX = (std::max)(maxX, c.x * invW);
+        minY = (std::min)(minY, c.y * invW);
+        maxY = (std::max)(maxY, c.y * invW);
+        minZ = (std::min)(minZ, c.z * invW);
+    }
+
+    /*covered pixel rectangle, y goes down*/
+    const int px0 = (std::max)(0, (int)std::floor((minX * 0.5f + 0.5f) * width));
+    const int px1 = (std::min)((int)width - 1, (int)std::floor((maxX * 0.5f + 0.5f) * width));
+    const int py0 = (std::max)(0, (int)std::floor((0.5f - maxY * 0.5f) * height));
+    const int py1 = (std::min)((int)height - 1, (int)std::floor((0.5f - minY * 0.5f) * height));
+
+    /*not on screen, left to the frustum culling*/
+    if (px0 > px1 || py0 > py1) return true;
+
+    /*pick the level where the rectangle covers at most 4x4 tiles*/
+    unsigned int level = 0;
+    unsigned int tx0 = px0 / HIZ_SIZE, tx1 = px1 / HIZ_SIZE;
+    unsigned int ty0 = py0 / HIZ_SIZE, ty1 = py1 / HIZ_SIZE;
+
+    while ((tx1 - tx0 > 3 || ty1 - ty0 > 3) && level + 1 < hiZ.size())
+    {
+        level++;
+        tx0 >>= 1; tx1 >>= 1;
+        ty0 >>= 1; ty1 >>= 1;
+    }
+
+    const auto& tiles = hiZ[level];
+    const unsigned int rowSize = hiZSize[level].x;
+
+    for (unsigned int ty = ty0; ty <= ty1; ty++)
+    {
+        for (unsigned int tx = tx0; tx <= tx1; tx++)
+        {
+            if (tiles[(size_t)ty * rowSize + tx] >= minZ) return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../util/mathhelper.h"
+#include "../util/jobsystem.h"
+#include <DirectXCollision.h>
+#include <vector>
+
+/*
+software occlusion culling on the cpu.
+occluder quads are rasterized into a small depth buffer, 4 pixels at a time and one screen tile per job.
+the depth buffer is reduced to a hierarchy of max depth tiles and object boxes are tested against it,
+a box is hidden if it is behind the farthest occluder of every tile it covers.
+*/
+class OcclusionCuller
+{
+public:
+
+    /*
+    @param width of the depth buffer, rounded up to a multiple of 8
+    @param height of the depth buffer, rounded up to a multiple of 8
+    */
+    explicit OcclusionCuller(unsigned int width = 256, unsigned int height = 128);
+
+    /*default destructor*/
+    ~OcclusionCuller() = default;
+
+    /*
+    removes all occluders and clears the depth buffer
+    @param view projection matrix of the camera, depth has to be in [0, 1]
+    */
+    void begin(DirectX::FXMMATRIX viewProj);
+
+    /*
+    adds a world space quad, it is clipped at the near plane and binned to the screen tiles
+    @param four corners in order around the quad
+    */
+    void addOccluder(const DirectX::XMFLOAT3 corners[4]);
+
+    /*
+    adds a quad through the middle of a thin box like a wall, shrunk a bit so it never covers more than the wall
+    @param world space bounds of the wall
+    */
+    void addWallOccluder(const DirectX::BoundingBox& box);
+
+    /*
+    rasterizes all occluders and builds the depth hierarchy
+    @param job system the tiles are distributed on, nullptr rasterizes on the calling thread
+    */
+    void rasterize(JobSystem* jobs);
+
+    /*
+    conservative test, boxes crossing the near plane or leaving the screen are always visible
+    @param world space box
+    @returns false if the box is completely hidden by the occluders
+    */
+    bool isVisible(const DirectX::BoundingBox& box) const;
+
+    /*
+    @returns depth buffer of the last rasterize row by row, pixels without an occluder are 1
+    */
+    const std::vector<float>& getDepth() const
+    {
+        return depth;
+    }
+
+    unsigned int getWidth() const
+    {
+        return width;
+    }
+
+    unsigned int getHeight() const
+    {
+        return height;
+    }
+
+    unsigned int getTriangleCount() const
+    {
+        return (unsigned int)triangles.size();
+    }
+
+private:
+
+    static constexpr unsigned int TILE_WIDTH = 64;
+    static constexpr unsigned int TILE_HEIGHT = 32;
+    static constexpr unsigned int HIZ_SIZE = 8;
+
+    /*screen space triangle as three edge functions and a depth plane, all positive inside*/
+    struct Triangle
+    {
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        float depthA;
+        float depthB;
+        float depthC;
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    /*adds a screen space triangle, vertices are x, y in pixels and z as depth*/
+    void addTriangle(DirectX::XMFLOAT3 v0, DirectX::XMFLOAT3 v1, DirectX::XMFLOAT3 v2);
+
+    void rasterizeTile(unsigned int tile);
+    void buildHiZ();
+
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int tilesX = 0;
+    unsigned int tilesY = 0;
+
+    DirectX::XMFLOAT4X4 viewProj;
+
+    std::vector<float> depth;
+    std::vector<Triangle> triangles;
+
+    /*indices of the triangles touching each screen tile*/
+    std::vector<std::vector<unsigned int>> tileTriangles;
+
+    /*max depth per HIZ_SIZE pixel tile on level 0, every further level halves the resolution*/
+    std::vector<std::vector<float>> hiZ;
+    std::vector<DirectX::XMUINT2> hiZSize;
+};
@@ -0,0 +1,416 @@
+#include "pickbvh.h"
+#include "../core/gameobject.h"
+#include "../util/mathhelper.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace DirectX;
+
+static inline float axisValue(const XMFLOAT3& v, UINT axis)
+{
+    return (&v.x)[axis];
+}
+
+/*axis aligned bounds of an oriented box*/
+static void orientedBounds(const BoundingOrientedBox& box, XMFLOAT3& bMin, XMFLOAT3& bMax)
+{
+    XMFLOAT3 corners[BoundingOrientedBox::CORNER_COUNT];
+    box.GetCorners(corners);
+
+    XMVECTOR vMin = XMLoadFloat3(&corners[0]);
+    XMVECTOR vMax = vMin;
+
+    for (size_t i = 1; i < BoundingOrientedBox::CORNER_COUNT; i++)
+    {
+        const XMVECTOR c = XMLoadFloat3(&corners[i]);
+        vMin = XMVectorMin(vMin, c);
+        vMax = XMVectorMax(vMax, c);
+    }
+
+    XMStoreFloat3(&bMin, vMin);
+    XMStoreFloat3(&bMax, vMax);
+}
+
+float PickBVH::surfaceArea(const XMFLOAT3& bMin, const XMFLOAT3& bMax)
+{
+    const float x = bMax.x - bMin.x;
+    const float y = bMax.y - bMin.y;
+    const float z = bMax.z - bMin.z;
+
+    return x * y + y * z + z * x;
+}
+
+void PickBVH::clear()
+{
+    nodes.clear();
+    primOrder.clear();
+    objects.clear();
+    pickBoxes.clear();
+    primMin.clear();
+    primMax.clear();
+    primLeaf.clear();
+    movedSinceBuild.clear();
+    dirtyPrims.clear();
+    movedCount = 0;
+    needsBuild = true;
+}
+
+UINT PickBVH::insert(GameObject* gO, const BoundingOrientedBox& pickBox)
+{
+    const UINT handle = (UINT)objects.size();
+
+    objects.push_back(gO);
+    pickBoxes.push_back(pickBox);
+    primMin.emplace_back();
+    primMax.emplace_back();
+    primLeaf.push_back(0);
+    movedSinceBuild.push_back(false);
+
+    orientedBounds(pickBox, primMin[handle], primMax[handle]);
+
+    needsBuild = true;
+
+    return handle;
+}
+
+void PickBVH::update(UINT handle, const BoundingOrientedBox& pickBox)
+{
+    if (handle >= objects.size()) return;
+
+    pickBoxes[handle] = pickBox;
+    orientedBounds(pickBox, primMin[handle], primMax[handle]);
+
+    if (needsBuild) return;
+
+    if (!movedSinceBuild[handle])
+    {
+        movedSinceBuild[handle] = true;
+        movedCount++;
+    }
+
+    dirtyPrims.push_back(handle);
+}
+
+void PickBVH::fitLeaf(Node& node)
+{
+    XMVECTOR vMin = XMLoadFloat3(&primMin[primOrder[node.first]]);
+    XMVECTOR vMax = XMLoadFloat3(&primMax[primOrder[node.first]]);
+
+    for (UINT i = node.first + 1; i < node.first + node.count; i++)
+    {
+        vMin = XMVectorMin(vMin, XMLoadFloat3(&primMin[primOrder[i]]));
+        vMax = XMVectorMax(vMax, XMLoadFloat3(&primMax[primOrder[i]]));
+    }
+
+    XMStoreFloat3(&node.boundsMin, vMin);
+    XMStoreFloat3(&node.boundsMax, vMax);
+}
+
+void PickBVH::build()
+{
+    const UINT count = (UINT)objects.size();
+
+    nodes.clear();
+    primOrder.resize(count);
+    std::iota(primOrder.begin(), primOrder.end(), 0);
+
+    dirtyPrims.clear();
+    std::fill(movedSinceBuild.begin(), movedSinceBuild.end(), false);
+    movedCount = 0;
+    needsBuild = false;
+
+    if (count == 0) return;
+
+    /*a binary tree with n leaves has 2n-1 nodes*/
+    nodes.reserve(2 * (size_t)count);
+
+    Node root;
+    root.first = 0;
+    root.count = count;
+    fitLeaf(root);
+    nodes.push_back(root);
+
+    subdivide(0);
+
+    for (UINT n = 0; n < nodes.size(); n++)
+    {
+        if (nodes[n].count == 0) continue;
+
+        for (UINT i = nodes[n].first; i < nodes[n].first + nodes[n].count; i++)
+        {
+            primLeaf[primOrder[i]] = n;
+        }
+    }
+}
+
+void PickBVH::subdivide(UINT node)
+{
+    const UINT first = nodes[node].first;
+    const UINT count = nodes[node].count;
+
+    if (count <= MAX_LEAF_SIZE) return;
+
+    auto centroid = [&](UINT h, UINT axis)
+    {
+        return (axisValue(primMin[h], axis) + axisValue(primMax[h], axis)) * 0.5f;
+    };
+
+    /*split along the axis with the largest centroid extent*/
+    XMFLOAT3 cMin = { MathHelper::Infinity, MathHelper::Infinity, MathHelper::Infinity };
+    XMFLOAT3 cMax = { -MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity };
+
+    for (UINT i = first; i < first + count; i++)
+    {
+        const UINT h = primOrder[i];
+
+        cMin.x = (std::min)(cMin.x, centroid(h, 0)); cMax.x = (std::max)(cMax.x, centroid(h, 0));
+        cMin.y = (std::min)(cMin.y, centroid(h, 1)); cMax.y = (std::max)(cMax.y, centroid(h, 1));
+        cMin.z = (std::min)(cMin.z, centroid(h, 2)); cMax.z = (std::max)(cMax.z, centroid(h, 2));
+    }
+
+    UINT axis = 0;
+    if (cMax.y - cMin.y > axisValue(cMax, axis) - axisValue(cMin, axis)) axis = 1;
+    if (cMax.z - cMin.z > axisValue(cMax, axis) - axisValue(cMin, axis)) axis = 2;
+
+    const float axisMin = axisValue(cMin, axis);
+    const float extent = axisValue(cMax, axis) - axisMin;
+
+    UINT leftCount = 0;
+
+    if (extent > 0.0f)
+    {
+        struct Bin
+        {
+            XMVECTOR bMin = XMVectorReplicate(MathHelper::Infinity);
+            XMVECTOR bMax = XMVectorReplicate(-MathHelper::Infinity);
+            UINT count = 0;
+        };
+
+        Bin bins[SAH_BINS];
+        const float scale = SAH_BINS / extent;
+
+        auto binIndex = [&](UINT h)
+        {
+            return (std::min)(SAH_BINS - 1, (UINT)((centroid(h, axis) - axisMin) * scale));
+        };
+
+        for (UINT i = first; i < first + count; i++)
+        {
+            const UINT h = primOrder[i];
+            Bin& b = bins[binIndex(h)];
+
+            b.bMin = XMVectorMin(b.bMin, XMLoadFloat3(&primMin[h]));
+            b.bMax = XMVectorMax(b.bMax, XMLoadFloat3(&primMax[h]));
+            b.count++;
+        }
+
+        /*sweep from the right to get the cost of every right side, then from the left*/
+        float rightCost[SAH_BINS] = {};
+        XMVECTOR sMin = XMVectorReplicate(MathHelper::Infinity);
+        XMVECTOR sMax = XMVectorReplicate(-MathHelper::Infinity);
+        UINT sCount = 0;
+
+        for (UINT b = SAH_BINS - 1; b > 0; b--)
+        {
+            sMin = XMVectorMin(sMin, bins[b].bMin);
+            sMax = XMVectorMax(sMax, bins[b].bMax);
+            sCount += bins[b].count;
+
+            XMFLOAT3 fMin, fMax;
+            XMStoreFloat3(&fMin, sMin);
+            XMStoreFloat3(&fMax, sMax);
+            rightCost[b] = sCount ? sCount * surfaceArea(fMin, fMax) : 0.0f;
+        }
+
+        float bestCost = MathHelper::Infinity;
+        UINT bestSplit = 0;
+
+        sMin = XMVectorReplicate(MathHelper::Infinity);
+        sMax = XMVectorReplicate(-MathHelper::Infinity);
+        sCount = 0;
+
+        for (UINT b = 0; b < SAH_BINS - 1; b++)
+        {
+            sMin = XMVectorMin(sMin, bins[b].bMin);
+            sMax = XMVectorMax(sMax, bins[b].bMax);
+            sCount += bins[b].count;
+
+            if (sCount == 0 || sCount == count) continue;
+
+            XMFLOAT3 fMin, fMax;
+            XMStoreFloat3(&fMin, sMin);
+            XMStoreFloat3(&fMax, sMax);
+
+            const float cost = sCount * surfaceArea(fMin, fMax) + rightCost[b + 1];
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = b;
+            }
+        }
+
+        if (bestCost < MathHelper::Infinity)
+        {
+            auto middle = std::partition(primOrder.begin() + first, primOrder.begin() + first + count,
+                                         [&](UINT h) { return binIndex(h) <= bestSplit; });
+
+            leftCount = (UINT)(middle - (primOrder.begin() + first));
+        }
+    }
+
+    /*all centroids in one bin, split in the middle*/
+    if (leftCount == 0 || leftCount == count)
+    {
+        leftCount = count / 2;
+
+        std::nth_element(primOrder.begin() + first, primOrder.begin() + first + leftCount, primOrder.begin() + first + count,
+                         [&](UINT a, UINT b) { return centroid(a, axis) < centroid(b, axis); });
+    }
+
+    const UINT left = (UINT)nodes.size();
+
+    Node leftNode;
+    leftNode.first = first;
+    leftNode.count = leftCount;
+    leftNode.parent = node;
+    fitLeaf(leftNode);
+
+    Node rightNode;
+    rightNode.first = first + leftCount;
+    rightNode.count = count - leftCount;
+    rightNode.parent = node;
+    fitLeaf(rightNode);
+
+    nodes.push_back(leftNode);
+    nodes.push_back(rightNode);
+
+    nodes[node].first = left;
+    nodes[node].count = 0;
+
+    subdivide(left);
+    subdivide(left + 1);
+}
+
+void PickBVH::refit()
+{
+    for (const auto h : dirtyPrims)
+    {
+        UINT n = primLeaf[h];
+        fitLeaf(nodes[n]);
+
+        /*walk up until the bounds of a parent do not change anymore*/
+        for (n = nodes[n].parent; n != INVALID_HANDLE; n = nodes[n].parent)
+        {
+            Node& parent = nodes[n];
+            const Node& l = nodes[parent.first];
+            const Node& r = nodes[parent.first + 1];
+
+            const XMFLOAT3 bMin = { (std::min)(l.boundsMin.x, r.boundsMin.x),
+                                    (std::min)(l.boundsMin.y, r.boundsMin.y),
+                                    (std::min)(l.boundsMin.z, r.boundsMin.z) };
+            const XMFLOAT3 bMax = { (std::max)(l.boundsMax.x, r.boundsMax.x),
+                                    (std::max)(l.boundsMax.y, r.boundsMax.y),
+                                    (std::max)(l.boundsMax.z, r.boundsMax.z) };
+
+            if (bMin.x == parent.boundsMin.x && bMin.y == parent.boundsMin.y && bMin.z == parent.boundsMin.z &&
+                bMax.x == parent.boundsMax.x && bMax.y == parent.boundsMax.y && bMax.z == parent.boundsMax.z)
+            {
+                break;
+            }
+
+            parent.boundsMin = bMin;
+            parent.boundsMax = bMax;
+        }
+    }
+
+    dirtyPrims.clear();
+}
+
+GameObject* PickBVH::intersect(FXMVECTOR origin, FXMVECTOR direction, float& dist)
+{
+    /*a refitted tree stays correct but gets slower the more objects moved since the build*/
+    if (needsBuild || movedCount * 4 > objects.size())
+    {
+        build();
+    }
+    else if (!dirtyPrims.empty())
+    {
+        refit();
+    }
+
+    if (nodes.empty()) return nullptr;
+
+    XMFLOAT3 o, d;
+    XMStoreFloat3(&o, origin);
+    XMStoreFloat3(&d, direction);
+
+    const XMFLOAT3 invD = { 1.0f / d.x, 1.0f / d.y, 1.0f / d.z };
+
+    float best = MathHelper::Infinity;
+    GameObject* result = nullptr;
+
+    /*slab test, returns the entry distance or infinity if the node is missed or farther than the best hit*/
+    auto enter = [&](const Node& n)
+    {
+        const float tx1 = (n.boundsMin.x - o.x) * invD.x, tx2 = (n.boundsMax.x - o.x) * invD.x;
+        const float ty1 = (n.boundsMin.y - o.y) * invD.y, ty2 = (n.boundsMax.y - o.y) * invD.y;
+        const float tz1 = (n.boundsMin.z - o.z) * invD.z, tz2 = (n.boundsMax.z - o.z) * invD.z;
+
+        const float tNear = (std::max)((std::max)((std::min)(tx1, tx2), (std::min)(ty1, ty2)), (std::max)((std::min)(tz1, tz2), 0.0f));
+        const float tFar = (std::min)((std::min)((std::max)(tx1, tx2), (std::max)(ty1, ty2)), (std::max)(tz1, tz2));
+
+        return (tNear <= tFar && tNear < best) ? tNear : MathHelper::Infinity;
+    };
+
+    std::vector<UINT> stack;
+    stack.reserve(64);
+    stack.push_back(0);
+
+    while (!stack.empty())
+    {
+        const Node& n = nodes[stack.back()];
+        stack.pop_back();
+
+        /*the best hit may have become closer since the node was pushed*/
+        if (enter(n) == MathHelper::Infinity) continue;
+
+        if (n.count > 0)
+        {
+            for (UINT i = n.first; i < n.first + n.count; i++)
+            {
+                const UINT h = primOrder[i];
+                float hitDist = 0.0f;
+
+                if (!objects[h]->isSelectable) continue;
+
+                if (pickBoxes[h].Intersects(origin, direction, hitDist) && hitDist < best)
+                {
+                    best = hitDist;
+                    result = objects[h];
+                }
+            }
+
+            continue;
+        }
+
+        UINT nearChild = n.first;
+        UINT farChild = n.first + 1;
+        float tNear = enter(nodes[nearChild]);
+        float tFar = enter(nodes[farChild]);
+
+        if (tFar < tNear)
+        {
+            std::swap(nearChild, farChild);
+            std::swap(tNear, tFar);
+        }
+
+        /*the near child is visited first, the far one is skipped later if the hit is closer*/
+        if (tFar < MathHelper::Infinity) stack.push_back(farChild);
+        if (tNear < MathHelper::Infinity) stack.push_back(nearChild);
+    }
+
+    if (result) dist = best;
+
+    return result;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+class GameObject;
+
+#include "../util/d3dUtil.h"
+
+/*
+bounding volume hierarchy over the pick boxes of the game objects, used for ray picking in the editor.
+the tree is built with the surface area heuristic, moved objects only refit the bounds of their leaf and its parents.
+handles are given out in insertion order and never change, so they can be used as a stable selection index.
+*/
+class PickBVH
+{
+
+public:
+
+    static constexpr UINT INVALID_HANDLE = UINT_MAX;
+
+    /*default constructor*/
+    explicit PickBVH() = default;
+
+    /*default destructor*/
+    ~PickBVH() = default;
+
+    /*removes all objects*/
+    void clear();
+
+    /*
+    adds a game object, the tree is rebuilt before the next query
+    @param game object
+    @param world space pick box of the object
+    @returns handle used for update, equal to the index in getObjects()
+    */
+    UINT insert(GameObject* gO, const DirectX::BoundingOrientedBox& pickBox);
+
+    /*
+    stores the new pick box of an object, the tree is refitted before the next query
+    @param handle returned by insert
+    @param new world space pick box
+    */
+    void update(UINT handle, const DirectX::BoundingOrientedBox& pickBox);
+
+    /*
+    finds the closest selectable object hit by a ray
+    @param ray origin
+    @param normalized ray direction
+    @param distance to the hit is stored here
+    @returns closest object or nullptr
+    */
+    GameObject* intersect(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float& dist);
+
+    /*
+    @returns all objects ordered by their handle
+    */
+    const std::vector<GameObject*>& getObjects() const
+    {
+        return objects;
+    }
+
+    UINT size() const
+    {
+        return (UINT)objects.size();
+    }
+
+private:
+
+    static constexpr UINT MAX_LEAF_SIZE = 4;
+    static constexpr UINT SAH_BINS = 12;
+
+    struct Node
+    {
+        DirectX::XMFLOAT3 boundsMin;
+        DirectX::XMFLOAT3 boundsMax;
+
+        /*first primitive for leaves, index of the left child otherwise, the right child follows it*/
+        UINT first = 0;
+        UINT count = 0;
+        UINT parent = INVALID_HANDLE;
+    };
+
+    void build();
+    void refit();
+
+    /*splits a node with the binned surface area heuristic until the leaves are small enough*/
+    void subdivide(UINT node);
+
+    /*recalculates the bounds of a leaf from its primitives*/
+    void fitLeaf(Node& node);
+
+    static float surfaceArea(const DirectX::XMFLOAT3& bMin, const DirectX::XMFLOAT3& bMax);
+
+    std::vector<Node> nodes;
+
+    /*primitive handles in leaf order, every leaf owns a range*/
+    std::vector<UINT> primOrder;
+
+    /*per handle data*/
+    std::vector<GameObject*> objects;
+    std::vector<DirectX::BoundingOrientedBox> pickBoxes;
+    std::vector<DirectX::XMFLOAT3> primMin;
+    std::vector<DirectX::XMFLOAT3> primMax;
+    std::vector<UINT> primLeaf;
+    std::vector<bool> movedSinceBuild;
+
+    /*handles moved since the last query*/
+    std::vector<UINT> dirtyPrims;
+
+    /*refitting lets the tree degrade, it is rebuilt if too many objects moved*/
+    UINT movedCount = 0;
+    bool needsBuild = true;
+};
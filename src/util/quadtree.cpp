@@ -1,180 +1,248 @@
 #include "quadtree.h"
-#include "../core/gameobject.h"
-#include "../util/serviceprovider.h"
+#include "../util/frustumculling.h"
+#include <algorithm>
+#include <sstream>
 
 using namespace DirectX;
 
+unsigned int QuadTree::mortonCode(unsigned int x, unsigned int z)
+{
+    auto spread = [](unsigned int v)
+    {
+        v &= 0x0000FFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+
+    return spread(x) | (spread(z) << 1);
+}
 
 void QuadTree::build(DirectX::XMFLOAT3 center, float x, float z, int depth)
 {
     if (depth < 1) depth = 1;
+    if (depth > (int)MAX_LEVELS - 1) depth = MAX_LEVELS - 1;
 
-    root = populateNode(center, x, z, depth);
-}
+    leafLevel = (unsigned int)depth;
+    leafResolution = 1u << leafLevel;
+    leafCount = leafResolution * leafResolution;
+    rootCenter = center;
+    leafSize = { x / leafResolution, z / leafResolution };
 
-bool QuadTree::insert(GameObject* gO)
-{
-    bool inserted = false;
-    auto box = gO->getCollider().getFrustumBox();
+    nodeBounds.resize(levelOffset(leafLevel + 1));
 
-    const std::function<void(QuadNode*)> recursiveInsert = [&](QuadNode* node)
+    /*same child order as before: -x-z, +x-z, -x+z, +x+z which is exactly the morton order*/
+    for (unsigned int l = 0; l <= leafLevel; l++)
     {
-        if (node->boundingBox.Intersects(box))
+        const unsigned int res = 1u << l;
+        const float sizeX = x / res;
+        const float sizeZ = z / res;
+
+        for (unsigned int cz = 0; cz < res; cz++)
         {
-            if (node->children.empty())
-            {
-                totalPointersStored++;
-                node->containedObjects.push_back(gO);
-                inserted = true;
-            }
-            else
+            for (unsigned int cx = 0; cx < res; cx++)
             {
-                for (auto& c : node->children)
-                {
-                    recursiveInsert(c.get());
-                }
+                const XMFLOAT3 nodeCenter = { center.x - x / 2.0f + (cx + 0.5f) * sizeX,
+                                              center.y,
+                                              center.z - z / 2.0f + (cz + 0.5f) * sizeZ };
+
+                nodeBounds[levelOffset(l) + mortonCode(cx, cz)] = BoundingBox(nodeCenter, { sizeX / 2.0f, fixedHeight, sizeZ / 2.0f });
             }
         }
-    };
+    }
 
-    recursiveInsert(root.get());
+    storedObjects.clear();
+    totalPointersStored = 0;
 
-    return inserted;
+    /*an empty tree can be searched right away*/
+    pack();
 }
 
-std::unique_ptr<QuadTree::QuadNode> QuadTree::populateNode(DirectX::XMFLOAT3 center, float x, float z, int depth)
+bool QuadTree::insert(GameObject* gO, const DirectX::BoundingBox& box)
 {
-    auto node = std::make_unique<QuadNode>();
-    auto box = DirectX::BoundingBox(center, { x / 2.0f, fixedHeight, z / 2.0f});
+    if (nodeBounds.empty()) return false;
 
-    node->boundingBox = box;
+    /*the height is the same for all nodes*/
+    if (std::abs(box.Center.y - rootCenter.y) > box.Extents.y + fixedHeight) return false;
 
-    if (depth > 0)
-    {
-        auto center1 = XMFLOAT3{ center.x - x / 4.0f, 0.0f, center.z - z / 4.0f };
-        auto x1 = populateNode(center1, x / 2.0f, z / 2.0f, depth - 1);
-        node->children.push_back(std::move(x1));
+    const float originX = rootCenter.x - leafSize.x * leafResolution / 2.0f;
+    const float originZ = rootCenter.z - leafSize.y * leafResolution / 2.0f;
 
-        auto center2 = XMFLOAT3{center.x + x / 4.0f, 0.0f, center.z - z / 4.0f };
-        auto x2 = populateNode(center2, x / 2.0f, z / 2.0f, depth - 1);
-        node->children.push_back(std::move(x2));
+    const int minX = (int)std::floor((box.Center.x - box.Extents.x - originX) / leafSize.x);
+    const int maxX = (int)std::floor((box.Center.x + box.Extents.x - originX) / leafSize.x);
+    const int minZ = (int)std::floor((box.Center.z - box.Extents.z - originZ) / leafSize.y);
+    const int maxZ = (int)std::floor((box.Center.z + box.Extents.z - originZ) / leafSize.y);
 
-        auto center3 = XMFLOAT3{center.x - x / 4.0f, 0.0f, center.z + z / 4.0f };
-        auto x3 = populateNode(center3, x / 2.0f, z / 2.0f, depth - 1);
-        node->children.push_back(std::move(x3));
+    const int res = (int)leafResolution;
 
-        auto center4 = XMFLOAT3{center.x + x / 4.0f, 0.0f, center.z + z / 4.0f };
-        auto x4 = populateNode(center4, x / 2.0f, z / 2.0f, depth - 1);
-        node->children.push_back(std::move(x4));
-    }
+    if (maxX < 0 || maxZ < 0 || minX >= res || minZ >= res) return false;
 
+    /*directly address the covered leaf cells instead of descending the tree*/
+    for (int z = (std::max)(minZ, 0); z <= (std::min)(maxZ, res - 1); z++)
+    {
+        for (int x = (std::max)(minX, 0); x <= (std::min)(maxX, res - 1); x++)
+        {
+            storedObjects.push_back({ mortonCode((unsigned int)x, (unsigned int)z), gO });
+            totalPointersStored++;
+        }
+    }
 
-    return node;
+    return true;
 }
 
+bool QuadTree::remove(GameObject* gO)
+{
+    const auto removed = std::remove_if(storedObjects.begin(), storedObjects.end(), [gO](const auto& p) { return p.second == gO; });
+    const int count = (int)(storedObjects.end() - removed);
+
+    storedObjects.erase(removed, storedObjects.end());
+    totalPointersStored -= count;
+
+    return count > 0;
+}
 
-//void QuadTree::searchCollision(GameObject* obj, std::vector<GameObject*>& collisions) const
-//{
-//    std::vector<QuadNode*> nodeCollisions;
-//    UINT checks = 0;
-//
-//    /*skip if obj has no collision*/
-//    if (!obj->isCollisionEnabled) return;
-//
-//    /*look up which quadtree nodes collide with the object bounding box*/
-//    const std::function<void(QuadNode*)> recursiveSearch = [&](QuadNode* node)
-//    {
-//        if (node->children.empty())
-//        {
-//            checks++;
-//            if (node->boundingBox.Intersects(obj->getCollider().getFrustumBox()))
-//            {
-//                nodeCollisions.push_back(node);
-//            }
-//        }
-//        else
-//        {
-//            checks++;
-//            if (node->boundingBox.Intersects(obj->getCollider().getFrustumBox()))
-//            {
-//                for (auto& i : node->children)
-//                {
-//                    recursiveSearch(i.get());
-//                }
-//            }
-//        }
-//    };
-//
-//    recursiveSearch(getRoot());
-//
-//    /*call intersect on every game object in every collided node*/
-//    for (const auto& i : nodeCollisions)
-//    {
-//        for (const auto& go : i->containedObjects)
-//        {
-//            if (!go->isCollisionEnabled) continue;
-//
-//            checks++;
-//            if (go->getCollider().intersects(obj->getCollider()))
-//            {
-//                collisions.push_back(go);
-//            }
-//        }
-//    }
-//
-//    //LOG(Severity::Debug, "Checks: " << checks << " in " << nodeCollisions.size() << " nodes.");
-//}
-
-void QuadTree::searchCollision(const DirectX::BoundingFrustum& frustum, std::vector<QuadNode*>& nodes) const
+void QuadTree::pack()
 {
+    /*counting sort by leaf, keeps the insertion order inside a leaf*/
+    leafOffsets.assign((size_t)leafCount + 1, 0);
+
+    for (const auto& p : storedObjects)
+    {
+        leafOffsets[(size_t)p.first + 1]++;
+    }
+
+    for (unsigned int i = 1; i <= leafCount; i++)
+    {
+        leafOffsets[i] += leafOffsets[i - 1];
+    }
+
+    std::vector<unsigned int> cursor(leafOffsets.begin(), leafOffsets.end() - 1);
+    leafObjects.resize(storedObjects.size());
 
-    UINT checks = 0;
+    for (const auto& p : storedObjects)
+    {
+        leafObjects[cursor[p.first]++] = p.second;
+    }
+
+    /*object counts from the leaves up to the root*/
+    nodeObjectCount.assign(nodeBounds.size(), 0);
+
+    for (unsigned int i = 0; i < leafCount; i++)
+    {
+        nodeObjectCount[(size_t)levelOffset(leafLevel) + i] = leafOffsets[(size_t)i + 1] - leafOffsets[i];
+    }
 
-    /*look up which quadtree nodes collide with the frustum*/
-    const std::function<void(QuadNode*)> recursiveSearch = [&](QuadNode* node)
+    for (unsigned int l = leafLevel; l > 0; l--)
     {
-        if (node->children.empty())
+        const unsigned int count = 1u << (2 * l);
+
+        for (unsigned int m = 0; m < count; m++)
         {
-            checks++;
-            if (frustum.Contains(node->boundingBox) != DirectX::DISJOINT && !node->containedObjects.empty())
-            {
-                nodes.push_back(node);
-            }
+            nodeObjectCount[(size_t)levelOffset(l - 1) + (m >> 2)] += nodeObjectCount[(size_t)levelOffset(l) + m];
         }
-        else
+    }
+}
+
+QuadTree::ObjectRange QuadTree::getLeafObjects(unsigned int leaf) const
+{
+    if (leaf >= leafCount) return {};
+
+    return { leafObjects.data() + leafOffsets[leaf], leafObjects.data() + leafOffsets[(size_t)leaf + 1] };
+}
+
+void QuadTree::addSubtreeLeaves(unsigned int level, unsigned int code, std::vector<unsigned int>& leaves) const
+{
+    const unsigned int shift = 2 * (leafLevel - level);
+    const unsigned int first = code << shift;
+    const unsigned int last = (code + 1) << shift;
+    const unsigned int offset = levelOffset(leafLevel);
+
+    for (unsigned int leaf = first; leaf < last; leaf++)
+    {
+        if (nodeObjectCount[(size_t)offset + leaf] > 0)
         {
-            checks++;
-            if (frustum.Contains(node->boundingBox) != DirectX::DISJOINT)
-            {
-                for (auto& i : node->children)
-                {
-                    recursiveSearch(i.get());
-                }
-            }
+            leaves.push_back(leaf);
         }
-    };
-
-    recursiveSearch(getRoot());
+    }
+}
 
-    //LOG(Severity::Debug, "Checks: " << checks << " and " << nodes.size() << " collision nodes.");
+void QuadTree::searchCollision(const DirectX::BoundingFrustum& frustum, std::vector<unsigned int>& leaves) const
+{
+    searchCollision(FrustumPlanes(frustum), leaves);
 }
 
+void QuadTree::searchCollision(const FrustumPlanes& planes, std::vector<unsigned int>& leaves) const
+{
+    if (nodeBounds.empty()) return;
+
+    /*explicit stack of (level, morton code), children are pushed in reverse to output leaves ascending*/
+    unsigned int stackLevel[3 * MAX_LEVELS + 1];
+    unsigned int stackCode[3 * MAX_LEVELS + 1];
+    unsigned int top = 0;
+
+    stackLevel[top] = 0;
+    stackCode[top++] = 0;
+
+    while (top > 0)
+    {
+        top--;
+        const unsigned int level = stackLevel[top];
+        const unsigned int code = stackCode[top];
+        const unsigned int node = levelOffset(level) + code;
+
+        if (nodeObjectCount[node] == 0) continue;
+
+        const ContainmentType result = planes.classify(nodeBounds[node]);
+
+        if (result == DISJOINT) continue;
+
+        if (result == CONTAINS || level == leafLevel)
+        {
+            addSubtreeLeaves(level, code, leaves);
+            continue;
+        }
+
+        for (unsigned int c = 4; c > 0; c--)
+        {
+            stackLevel[top] = level + 1;
+            stackCode[top++] = (code << 2) | (c - 1);
+        }
+    }
+}
 
 std::string QuadTree::toString() const
 {
     std::stringstream result;
 
-    std::function<void(QuadNode*, int)> addNodeToString = [&](QuadNode* node, int depth) -> void
+    if (nodeBounds.empty()) return result.str();
+
+    unsigned int stackLevel[3 * MAX_LEVELS + 1];
+    unsigned int stackCode[3 * MAX_LEVELS + 1];
+    unsigned int top = 0;
+
+    stackLevel[top] = 0;
+    stackCode[top++] = 0;
+
+    while (top > 0)
     {
-        result << std::string((long long)depth * 3, ' ') << *node << "\n";
+        top--;
+        const unsigned int level = stackLevel[top];
+        const unsigned int code = stackCode[top];
+        const auto& box = nodeBounds[levelOffset(level) + code];
 
-        for (const auto& i : node->children)
+        result << std::string((size_t)level * 3, ' ') << box.Center.x << " | " << box.Center.z << " (" << box.Extents.x << " | " << box.Extents.z << ") -> "
+            << nodeObjectCount[levelOffset(level) + code] << " contained objects.\n";
+
+        if (level == leafLevel) continue;
+
+        for (unsigned int c = 4; c > 0; c--)
         {
-            addNodeToString(i.get(), depth + 1);
+            stackLevel[top] = level + 1;
+            stackCode[top++] = (code << 2) | (c - 1);
         }
-    };
-
-    addNodeToString(root.get(), 0);
+    }
 
     return result.str();
 }
@@ -1,25 +1,43 @@
 #pragma once
 
 class GameObject;
+struct FrustumPlanes;
 
-#include "../util/d3dUtil.h"
+#include "../util/mathhelper.h"
+#include <DirectXCollision.h>
+#include <vector>
+#include <string>
 #include <iostream>
 
+/*
+linear quad tree without pointers, all nodes of a level are stored morton ordered in one array
+(children of node m on level l are 4m..4m+3 on level l+1) and the objects of all leaves are packed
+into one contiguous buffer with a range per leaf
+*/
 class QuadTree
 {
 
 public:
 
-    struct QuadNode
+    /*range of game objects stored in one leaf, usable in range based for loops*/
+    struct ObjectRange
     {
-        DirectX::BoundingBox boundingBox;
-        std::vector<GameObject*> containedObjects;
-        std::vector<std::unique_ptr<QuadNode>> children;
+        GameObject* const* first = nullptr;
+        GameObject* const* last = nullptr;
 
-        friend std::ostream& operator<< (std::ostream& os, const QuadNode& node)
+        GameObject* const* begin() const
         {
-            os << node.boundingBox.Center.x << " | " << node.boundingBox.Center.z << " (" << node.boundingBox.Extents.x << " | " << node.boundingBox.Extents.z << ") -> " << node.containedObjects.size() << " contained objects.";
-            return os;
+            return first;
+        }
+
+        GameObject* const* end() const
+        {
+            return last;
+        }
+
+        size_t size() const
+        {
+            return last - first;
         }
     };
 
@@ -38,10 +56,26 @@ public:
     void build(DirectX::XMFLOAT3 center, float x, float z, int depth);
 
     /*
-    inserts a game object at the right position(s) in the tree
-    @params the game object you want to insert
+    inserts a game object at the right position(s) in the tree,
+    it is found by the searches after the next pack()
+    @param game object, the tree never dereferences it
+    @param world space bounds of the object
+    @returns false if the bounds are outside of the area
+    */
+    bool insert(GameObject* gO, const DirectX::BoundingBox& bounds);
+
+    /*
+    removes a game object from all leaves, the searches still find it until the next pack()
+    @param game object
+    @returns false if the object was not stored
+    */
+    bool remove(GameObject* gO);
+
+    /*
+    sorts the objects inserted since the last call into the packed leaf buffer,
+    call it on the owning thread after a batch of inserts, the searches only read the packed buffer
     */
-    bool insert(GameObject* gO);
+    void pack();
 
     /*
     @returns how many game object pointers are stored in the tree (duplicates possible)
@@ -52,26 +86,41 @@ public:
     }
 
     /*
-    @returns raw pointer to the root node of the tree
+    @returns amount of leaves, leaf indices are morton codes of the leaf cells
     */
-    QuadNode* getRoot() const
+    unsigned int getLeafCount() const
     {
-        return root.get();
+        return leafCount;
     }
 
     /*
-    seach the tree for collisions with game object obj
-    @param object for which collisions are searched for
-    @param pointer to game objects that collide with obj will be stored here
+    @param leaf index returned by one of the searches
+    @returns all game objects stored in the leaf
     */
-    //void searchCollision(GameObject* obj, std::vector<GameObject*>& collisions) const;
+    ObjectRange getLeafObjects(unsigned int leaf) const;
+
+    /*
+    @param leaf index
+    @returns bounding box of the leaf
+    */
+    const DirectX::BoundingBox& getLeafBounds(unsigned int leaf) const
+    {
+        return nodeBounds[levelOffset(leafLevel) + leaf];
+    }
 
     /*
     compute collision between all nodes in the tree and a camera frustum
     @param frustum that is used for collision check
-    @param pointer to nodes that collide with frustum will be stored here
+    @param indices of non empty leaves that collide with the frustum will be stored here, ascending
+    */
+    void searchCollision(const DirectX::BoundingFrustum& frustum, std::vector<unsigned int>& leaves) const;
+
+    /*
+    same as above for any set of six planes, e.g. the orthographic light volume of the shadow map
+    @param planes that are used for collision check
+    @param indices of non empty leaves that collide with the planes will be stored here, ascending
     */
-    void searchCollision(const DirectX::BoundingFrustum& frustum, std::vector<QuadNode*>& nodes) const;
+    void searchCollision(const FrustumPlanes& planes, std::vector<unsigned int>& leaves) const;
 
     /*outputs the quadtree to a stream*/
     friend std::ostream& operator<<(std::ostream& os, const QuadTree& tree);
@@ -85,7 +134,38 @@ private:
     const float fixedHeight = 64.0f;
     int totalPointersStored = 0;
 
-    std::unique_ptr<QuadNode> populateNode(DirectX::XMFLOAT3 center, float x, float z, int depth);
-    std::unique_ptr<QuadNode> root = nullptr;
+    static constexpr unsigned int MAX_LEVELS = 12;
+
+    /*index of the first node of a level in nodeBounds*/
+    static unsigned int levelOffset(unsigned int level)
+    {
+        return ((1u << (2 * level)) - 1) / 3;
+    }
+
+    /*interleaves the bits of x (even bits) and z (odd bits)*/
+    static unsigned int mortonCode(unsigned int x, unsigned int z);
+
+    /*appends all non empty leaves below a node, they form one contiguous morton range*/
+    void addSubtreeLeaves(unsigned int level, unsigned int code, std::vector<unsigned int>& leaves) const;
+
+    unsigned int leafLevel = 0;
+    unsigned int leafCount = 0;
+    unsigned int leafResolution = 0;
+
+    DirectX::XMFLOAT3 rootCenter = { 0.0f,0.0f,0.0f };
+    DirectX::XMFLOAT2 leafSize = { 0.0f,0.0f };
+
+    /*bounding boxes of all nodes, level after level*/
+    std::vector<DirectX::BoundingBox> nodeBounds;
+
+    /*all inserted leaf/object pairs, sorted into leafObjects by pack()*/
+    std::vector<std::pair<unsigned int, GameObject*>> storedObjects;
+
+    /*leafOffsets[i] to leafOffsets[i+1] is the range of leaf i in leafObjects*/
+    std::vector<unsigned int> leafOffsets;
+    std::vector<GameObject*> leafObjects;
+
+    /*amount of stored objects below each node, used to skip empty subtrees*/
+    std::vector<unsigned int> nodeObjectCount;
 
-};
\ No newline at end of file
+};
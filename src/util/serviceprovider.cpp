@@ -3,6 +3,7 @@
 #include "../audio/soundengine.h"
 #include "../util/debuginfo.h"
 #include "../core/editmode.h"
+#include "../util/jobsystem.h"
 
 std::shared_ptr<Logger<LogPolicy>>ServiceProvider::vsLogger = nullptr;
 
@@ -18,6 +19,7 @@ std::shared_ptr<Level>ServiceProvider::activeLevel = nullptr;
 std::shared_ptr<Camera>ServiceProvider::activeCamera = nullptr;
 std::shared_ptr<Randomizer>ServiceProvider::randomizer = nullptr;
 std::shared_ptr<Maze>ServiceProvider::maze = nullptr;
+std::shared_ptr<JobSystem>ServiceProvider::jobSystem = nullptr;
 std::shared_ptr<DebugInfo>ServiceProvider::debugInfo = std::make_shared<DebugInfo>();
 std::shared_ptr<EditSettings>ServiceProvider::editSettings = std::make_shared<EditSettings>();
 
@@ -157,6 +159,16 @@ void ServiceProvider::setMaze(std::shared_ptr<Maze> _maze)
     maze = _maze;
 }
 
+JobSystem* ServiceProvider::getJobSystem()
+{
+    return jobSystem.get();
+}
+
+void ServiceProvider::setJobSystem(std::shared_ptr<JobSystem> _jobSystem)
+{
+    jobSystem = _jobSystem;
+}
+
 DebugInfo* ServiceProvider::getDebugInfo()
 {
     return debugInfo.get();
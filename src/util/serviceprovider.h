@@ -11,6 +11,7 @@ class BulletPhysics;
 class CollisionDatabase;
 class Randomizer;
 class Maze;
+class JobSystem;
 
 struct EditSettings;
 struct DebugInfo;
@@ -43,6 +44,7 @@ private:
     static std::shared_ptr<EditSettings> editSettings;
     static std::shared_ptr<Randomizer> randomizer;
     static std::shared_ptr<Maze> maze;
+    static std::shared_ptr<JobSystem> jobSystem;
 
     static std::atomic<unsigned int> audioGuid;
     static std::mutex audioLock;
@@ -90,6 +92,9 @@ public:
     static Maze* getMaze();
     static void setMaze(std::shared_ptr<Maze> _maze);
 
+    static JobSystem* getJobSystem();
+    static void setJobSystem(std::shared_ptr<JobSystem> _jobSystem);
+
     static DebugInfo* getDebugInfo();
     static EditSettings* getEditSettings();
 
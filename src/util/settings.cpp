@@ -89,9 +89,25 @@ bool SettingsLoader::loadSettings(const std::string& path)
         settings.graphicSettings.ShadowEnabled = settingsJson["Graphic"]["ShadowEnabled"];
         settings.graphicSettings.SobelFilter = settingsJson["Graphic"]["SobelFilter"];
         settings.graphicSettings.ShadowQuality = settingsJson["Graphic"]["ShadowQuality"];
+        settings.graphicSettings.AnimationTimeStep = settingsJson["Graphic"]["AnimationTimeStep"];
+        settings.graphicSettings.AnimationPhases = settingsJson["Graphic"]["AnimationPhases"];
+        settings.graphicSettings.AnimationLodHalfRateDistance = settingsJson["Graphic"]["AnimationLodHalfRateDistance"];
+        settings.graphicSettings.AnimationLodQuarterRateDistance = settingsJson["Graphic"]["AnimationLodQuarterRateDistance"];
+        settings.graphicSettings.AnimationBoneMaskDistance = settingsJson["Graphic"]["AnimationBoneMaskDistance"];
+        settings.graphicSettings.AnimationBoneMaskDepth = settingsJson["Graphic"]["AnimationBoneMaskDepth"];
 
 
 
+        /*dirty upload queues use one bit per frame resource*/
+        if (settings.graphicSettings.numFrameResources > 32)
+        {
+            settings.graphicSettings.numFrameResources = 32;
+        }
+        else if (settings.graphicSettings.numFrameResources < 1)
+        {
+            settings.graphicSettings.numFrameResources = 1;
+        }
+
         if (settings.graphicSettings.AnisotropicFiltering > 16)
         {
             settings.graphicSettings.AnisotropicFiltering = 16;
@@ -122,6 +138,21 @@ bool SettingsLoader::loadSettings(const std::string& path)
 
         settings.graphicSettings.ShadowQuality = shadowMapSizes[settings.graphicSettings.ShadowQuality];
 
+        if (settings.graphicSettings.AnimationTimeStep < 0.0f)
+        {
+            settings.graphicSettings.AnimationTimeStep = 0.0f;
+        }
+
+        if (settings.graphicSettings.AnimationPhases < 0)
+        {
+            settings.graphicSettings.AnimationPhases = 0;
+        }
+
+        if (settings.graphicSettings.AnimationBoneMaskDepth < 0)
+        {
+            settings.graphicSettings.AnimationBoneMaskDepth = 0;
+        }
+
 
         /*load input settings*/
 
@@ -32,6 +32,12 @@ struct GraphicSettings
     int ShadowEnabled = 1;
     int ShadowQuality = 3;
     int SobelFilter = true;
+    float AnimationTimeStep = 0.0f;
+    int AnimationPhases = 0;
+    float AnimationLodHalfRateDistance = 0.0f;
+    float AnimationLodQuarterRateDistance = 0.0f;
+    float AnimationBoneMaskDistance = 0.0f;
+    int AnimationBoneMaskDepth = 0;
 };
 
 struct GameplaySettings
@@ -1,18 +1,23 @@
 #pragma once
 
 #include "d3dUtil.h"
+#include "skinnedmodelparser.h"
+#include "../render/frameresource.h"
 #include <filesystem>
 
 class SkinnedModelLoader
 {
 public:
+
     explicit SkinnedModelLoader(ID3D12Device* _device, ID3D12GraphicsCommandList* _cmdList)
     {
         device = _device;
         cmdList = _cmdList;
     }
+
     ~SkinnedModelLoader() = default;
 
+    /*parses a model with SkinnedModelParser and uploads its geometry and hitbox mesh*/
     std::unique_ptr<SkinnedModel> loadS3D(const std::filesystem::directory_entry& fileName);
 
 private:
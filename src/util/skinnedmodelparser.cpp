@@ -0,0 +1,259 @@
+#include "skinnedmodelparser.h"
+#include <fstream>
+#include <functional>
+
+using namespace DirectX;
+
+bool SkinnedModelParser::parseS3D(const std::filesystem::path& fileName, SkinnedRig& rig, std::vector<MeshGeometry>& meshes, DirectX::BoundingBox& bounds) const
+{
+    /*open file*/
+    std::streampos fileSize;
+    std::ifstream file(fileName, std::ios::binary);
+
+    /*get file size*/
+    file.seekg(0, std::ios::end);
+    fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    /*check header*/
+    bool header = true;
+    char headerBuffer[4] = { 's','3','d','f' };
+
+    for (int i = 0; i < 4; i++)
+    {
+        char temp;
+        file.read(&temp, sizeof(temp));
+
+        if (temp != headerBuffer[i])
+        {
+            header = false;
+            break;
+        }
+    }
+
+    if (header == false)
+    {
+        /*header incorrect*/
+        return false;
+    }
+
+    /*number of bones*/
+    char numBones = 0;
+    file.read((char*)(&numBones), sizeof(char));
+
+
+    /*bone information*/
+    std::vector<int> boneID(numBones);
+    std::vector<std::string> boneName(numBones);
+    std::vector<std::pair<std::string, DirectX::XMFLOAT4X4>> boneOffset(numBones);
+
+    for (char i = 0; i < numBones; i++)
+    {
+        /*id*/
+        file.read((char*)(&boneID[i]), sizeof(char));
+
+        /*name length*/
+        short slen = 0;
+        file.read((char*)(&slen), sizeof(short));
+
+        /*name*/
+        char* bname = new char[(size_t)slen + 1];
+        file.read(bname, slen);
+        bname[slen] = '\0';
+
+        boneName[i] = std::string(bname);
+        delete[] bname;
+
+        /*matrix*/
+        float tFloat[16];
+        file.read((char*)&tFloat[0], sizeof(float) * 16);
+        boneOffset[i].first = boneName[i];
+        boneOffset[i].second = XMFLOAT4X4(tFloat);
+
+    }
+
+    /*bone hierarchy*/
+    std::vector<int> boneHierarchy(numBones);
+
+    for (char i = 0; i < numBones; i++)
+    {
+        int index;
+
+        file.read((char*)(&index), sizeof(int));
+        file.read((char*)(&boneHierarchy[index]), sizeof(int));
+    }
+
+
+    /*node tree*/
+    std::function<void(Node*, Node*)> loadTree = [&](Node* node, Node* parent)
+    {
+        /*read data*/
+        short slen = 0;
+        file.read((char*)(&slen), sizeof(short));
+
+        char* nameStr = new char[(size_t)slen + 1];
+        file.read(nameStr, slen);
+        nameStr[slen] = '\0';
+
+        float mTemp[16];
+        file.read((char*)&mTemp[0], sizeof(float) * 16);
+
+        int numChildren = 0;
+        file.read((char*)(&numChildren), sizeof(int));
+
+
+        /*fill node*/
+        node->name = nameStr;
+        node->transform = XMFLOAT4X4(mTemp);
+        node->parent = parent;
+
+        delete[] nameStr;
+
+        XMStoreFloat4x4(&node->boneOffset, XMMatrixIdentity());
+        for (int i = 0; i < (int)boneOffset.size(); i++)
+        {
+            if (node->name == boneOffset[i].first)
+            {
+                node->isBone = true;
+                node->boneOffset = boneOffset[i].second;
+                node->boneIndex = i;
+            }
+        }
+
+        for (int i = 0; i < numChildren; i++)
+        {
+            node->children.push_back(new Node());
+            loadTree(node->children.back(), node);
+        }
+
+
+    };
+
+
+   
+
+    /*put bone data into the rig*/
+    rig.boneCount = numBones;
+    rig.boneHierarchy = boneHierarchy;
+    loadTree(rig.nodeTree.root, nullptr);
+    rig.nodeTree.boneRoot = rig.nodeTree.findNodeByBoneIndex(0);
+
+    //LOG(Severity::Debug, "\n" << rig.nodeTree.toString() << std::endl);
+
+    rig.rootTransform = rig.nodeTree.boneRoot->parent->transform;
+    rig.bakeSkeleton();
+
+    /*number of meshes*/
+    char numMeshes = 0;
+    file.read(&numMeshes, sizeof(numMeshes));
+
+    XMFLOAT3 cMin(+FLT_MAX, +FLT_MAX, +FLT_MAX);
+    XMFLOAT3 cMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    XMVECTOR vMin = XMLoadFloat3(&cMin);
+    XMVECTOR vMax = XMLoadFloat3(&cMax);
+
+    for (char i = 0; i < numMeshes; i++)
+    {
+        MeshGeometry m;
+
+        /*read material string*/
+
+        short slen = 0;
+        file.read((char*)(&slen), sizeof(short));
+
+        char* matStr = new char[(size_t)slen + 1];
+        file.read(matStr, slen);
+        matStr[slen] = '\0';
+
+        m.materialName = matStr;
+
+        delete[] matStr;
+
+        /*read number of vertices*/
+        int vertCount = 0;
+        file.read((char*)(&vertCount), sizeof(vertCount));
+
+        auto& vertices = m.vertices;
+        vertices.resize(vertCount);
+
+        int tempInt;
+        float tempFloat;
+
+        /*vertex properties*/
+        for (int j = 0; j < vertCount; j++)
+        {
+            file.read((char*)(&vertices[j].Pos.x), sizeof(float));
+            file.read((char*)(&vertices[j].Pos.y), sizeof(float));
+            file.read((char*)(&vertices[j].Pos.z), sizeof(float));
+
+            file.read((char*)(&vertices[j].TexC.x), sizeof(float));
+            file.read((char*)(&vertices[j].TexC.y), sizeof(float));
+
+            file.read((char*)(&vertices[j].Normal.x), sizeof(float));
+            file.read((char*)(&vertices[j].Normal.y), sizeof(float));
+            file.read((char*)(&vertices[j].Normal.z), sizeof(float));
+
+            file.read((char*)(&vertices[j].TangentU.x), sizeof(float));
+            file.read((char*)(&vertices[j].TangentU.y), sizeof(float));
+            file.read((char*)(&vertices[j].TangentU.z), sizeof(float));
+
+            /*bone indices & weights*/
+            file.read((char*)&tempInt, sizeof(unsigned int));
+            file.read((char*)&tempFloat, sizeof(float));
+
+            vertices[j].BoneIndices[0] = (std::uint8_t)tempInt;
+            vertices[j].BoneWeights.x = tempFloat;
+
+            file.read((char*)&tempInt, sizeof(unsigned int));
+            file.read((char*)&tempFloat, sizeof(float));
+
+            vertices[j].BoneIndices[1] = (std::uint8_t)tempInt;
+            vertices[j].BoneWeights.y = tempFloat;
+
+            file.read((char*)&tempInt, sizeof(unsigned int));
+            file.read((char*)&tempFloat, sizeof(float));
+
+            vertices[j].BoneIndices[2] = (std::uint8_t)tempInt;
+            vertices[j].BoneWeights.z = tempFloat;
+
+            file.read((char*)&tempInt, sizeof(unsigned int));
+            file.read((char*)&tempFloat, sizeof(float));
+
+            vertices[j].BoneIndices[3] = (std::uint8_t)tempInt;
+
+            /*collision box related*/
+            XMVECTOR P = XMLoadFloat3(&vertices[j].Pos);
+
+            vMin = XMVectorMin(vMin, P);
+            vMax = XMVectorMax(vMax, P);
+        }
+
+        /*number of indices*/
+        int vInd = 0;
+        file.read((char*)(&vInd), sizeof(vInd));
+
+        auto& indices = m.indices;
+        indices.resize(vInd);
+
+        int tri1, tri2, tri3;
+
+        for (int j = 0; j < vInd / 3; j++)
+        {
+            file.read((char*)(&tri1), sizeof(int));
+            file.read((char*)(&tri2), sizeof(int));
+            file.read((char*)(&tri3), sizeof(int));
+            indices[(size_t)j * 3] = (unsigned short)tri1;
+            indices[(size_t)j * 3 + 1] = (unsigned short)tri2;
+            indices[(size_t)j * 3 + 2] = (unsigned short)tri3;
+        }
+
+        meshes.push_back(std::move(m));
+    }
+
+    /*create AABB*/
+    XMStoreFloat3(&bounds.Center, 0.5f * (vMin + vMax));
+    XMStoreFloat3(&bounds.Extents, 0.5f * (vMax - vMin));
+
+    return true;
+}
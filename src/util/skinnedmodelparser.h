@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../render/animation.h"
+#include <DirectXCollision.h>
+#include <filesystem>
+#include <cstdint>
+
+struct SkinnedVertex
+{
+    DirectX::XMFLOAT3 Pos;
+    DirectX::XMFLOAT3 Normal;
+    DirectX::XMFLOAT2 TexC;
+    DirectX::XMFLOAT3 TangentU;
+    DirectX::XMFLOAT3 BoneWeights;
+    std::uint8_t BoneIndices[4];
+};
+
+/*reads .s3d files on the cpu, SkinnedModelLoader creates the gpu buffers of the result*/
+class SkinnedModelParser
+{
+public:
+
+    /*geometry of one mesh, stays on the cpu until it is uploaded*/
+    struct MeshGeometry
+    {
+        std::string materialName;
+        std::vector<SkinnedVertex> vertices;
+        std::vector<std::uint16_t> indices;
+    };
+
+    explicit SkinnedModelParser() = default;
+    ~SkinnedModelParser() = default;
+
+    /*
+    @param file
+    @param newly constructed rig that receives the bones, node tree and baked skeleton
+    @param receives the geometry in the order of the meshes
+    @param receives the bounding box of all vertices
+    @returns false if the file is invalid
+    */
+    bool parseS3D(const std::filesystem::path& fileName, SkinnedRig& rig, std::vector<MeshGeometry>& meshes, DirectX::BoundingBox& bounds) const;
+};
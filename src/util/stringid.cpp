@@ -0,0 +1,37 @@
+#include "stringid.h"
+#include "../util/serviceprovider.h"
+
+std::mutex StringTable::lock;
+std::unordered_map<StringId, std::string> StringTable::strings;
+
+StringId StringTable::intern(std::string_view str)
+{
+    const StringId id(str);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    const auto [entry, inserted] = strings.try_emplace(id, str);
+
+    if (!inserted && entry->second != str)
+    {
+        reportCollision(entry->second, str);
+    }
+
+    return id;
+}
+
+void StringTable::reportCollision(std::string_view first, std::string_view second)
+{
+    LOG(Severity::Error, "String id collision between " << std::string(first) << " and " << std::string(second) << "!");
+}
+
+const std::string& StringTable::lookup(StringId id)
+{
+    static const std::string empty;
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    const auto entry = strings.find(id);
+
+    return entry != strings.end() ? entry->second : empty;
+}
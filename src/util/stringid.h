@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+
+/*
+32 bit fnv-1a hash, constexpr so literals can be hashed at compile time
+@param characters of the string
+@param length of the string
+@returns hash value
+*/
+constexpr std::uint32_t hashString(const char* str, size_t length)
+{
+    std::uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<std::uint8_t>(str[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*
+identifier of a string that is compared and hashed as an integer.
+literals are hashed at compile time with "name"_id, runtime strings are hashed without a temporary copy.
+*/
+struct StringId
+{
+    constexpr StringId() = default;
+
+    constexpr explicit StringId(std::uint32_t hash)
+        : value(hash)
+    {
+    }
+
+    explicit StringId(std::string_view str)
+        : value(hashString(str.data(), str.size()))
+    {
+    }
+
+    constexpr bool operator==(StringId other) const
+    {
+        return value == other.value;
+    }
+
+    constexpr bool operator!=(StringId other) const
+    {
+        return value != other.value;
+    }
+
+    std::uint32_t value = 0;
+};
+
+constexpr StringId operator""_id(const char* str, size_t length)
+{
+    return StringId(hashString(str, length));
+}
+
+namespace std
+{
+    template<>
+    struct hash<StringId>
+    {
+        size_t operator()(StringId id) const noexcept
+        {
+            return id.value;
+        }
+    };
+}
+
+/*
+global table of all interned strings, used to get the string of an id back and to catch hash collisions
+*/
+class StringTable
+{
+public:
+
+    /*
+    @param string to intern
+    @returns id of the string, a collision with a different string is logged as error
+    */
+    static StringId intern(std::string_view str);
+
+    /*
+    @param id of an interned string
+    @returns the string or an empty string if the id was never interned
+    */
+    static const std::string& lookup(StringId id);
+
+    /*
+    logs two different strings with the same id as error
+    @param string that owns the id
+    @param other string with the same id
+    */
+    static void reportCollision(std::string_view first, std::string_view second);
+
+private:
+
+    static std::mutex lock;
+    static std::unordered_map<StringId, std::string> strings;
+};